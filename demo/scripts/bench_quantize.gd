@@ -0,0 +1,232 @@
+# Copyright (c) 2024 Yuri Sarudiansky
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# Throughput and accuracy measurements of the Quantize functions. This is not part of the demo levels and is meant to
+# be run from the command line, without any window:
+#
+#   godot --headless --path demo --script res://scripts/bench_quantize.gd -- --count=1000000 --seed=1
+#
+# Both arguments are optional. The scalar measurements call into the extension once per value, so those are also
+# affected by the GDScript overhead. Still, that is exactly the cost paid by scripts using those functions.
+
+extends SceneTree
+
+
+#######################################################################################################################
+### "Private" properties
+var _count: int = 1000000
+var _rng: RandomNumberGenerator = RandomNumberGenerator.new()
+
+
+#######################################################################################################################
+### "Private" functions
+func _parse_arguments() -> void:
+	_rng.seed = 1
+
+	for arg: String in OS.get_cmdline_user_args():
+		if (arg.begins_with("--count=")):
+			_count = maxi(4, arg.get_slice("=", 1).to_int())
+		elif (arg.begins_with("--seed=")):
+			_rng.seed = arg.get_slice("=", 1).to_int()
+
+
+# Uniformly distributed random unit quaternion (Shoemake's method), returned as a flat x, y, z, w array
+func _generate_quats() -> PackedFloat32Array:
+	var ret: PackedFloat32Array = PackedFloat32Array()
+	@warning_ignore("return_value_discarded")
+	ret.resize(_count * 4)
+
+	for i: int in _count:
+		var u1: float = _rng.randf()
+		var u2: float = _rng.randf() * TAU
+		var u3: float = _rng.randf() * TAU
+		var s1: float = sqrt(1.0 - u1)
+		var s2: float = sqrt(u1)
+
+		ret[i * 4 + 0] = s1 * sin(u2)
+		ret[i * 4 + 1] = s1 * cos(u2)
+		ret[i * 4 + 2] = s2 * sin(u3)
+		ret[i * 4 + 3] = s2 * cos(u3)
+
+	return ret
+
+
+func _generate_floats() -> PackedFloat32Array:
+	var ret: PackedFloat32Array = PackedFloat32Array()
+	@warning_ignore("return_value_discarded")
+	ret.resize(_count)
+
+	for i: int in _count:
+		ret[i] = _rng.randf()
+
+	return ret
+
+
+# Angle, in degrees, between the original and the restored rotations. The absolute value of the dot product takes care
+# of quaternions that got their signal flipped
+func _angular_error(original: PackedFloat32Array, restored: PackedFloat32Array, index: int) -> float:
+	var o: int = index * 4
+	var d: float = absf(original[o] * restored[o] + original[o + 1] * restored[o + 1] + original[o + 2] * restored[o + 2] + original[o + 3] * restored[o + 3])
+	return rad_to_deg(2.0 * acos(minf(d, 1.0)))
+
+
+func _report_rotation_error(label: String, original: PackedFloat32Array, restored: PackedFloat32Array) -> void:
+	var max_err: float = 0.0
+	var total: float = 0.0
+
+	for i: int in _count:
+		var err: float = _angular_error(original, restored, i)
+		max_err = maxf(max_err, err)
+		total += err
+
+	print("   %-24s max error: %.6f deg    mean error: %.6f deg" % [label, max_err, total / _count])
+
+
+func _report_throughput(label: String, usec: int) -> void:
+	var per_sec: float = float(_count) / (maxi(usec, 1) / 1000000.0)
+	print("   %-24s %10.3f ms    %14.0f values/s" % [label, usec / 1000.0, per_sec])
+
+
+func _bench_rquat(bits: int, quats: PackedFloat32Array) -> void:
+	print("\n%s bits per component rotation quaternions" % bits)
+
+	var compress: Callable
+	var restore: Callable
+	var compress_array: Callable
+	var restore_array: Callable
+
+	# Lambdas are used because static functions of native classes can't be directly taken as Callable. This adds a
+	# little overhead to the scalar measurements
+	match bits:
+		9:
+			compress = func(q: Quaternion) -> int: return Quantize.compress_rquat_9bits(q)
+			restore = func(c: int) -> Quaternion: return Quantize.restore_rquat_9bits(c)
+			compress_array = func(a: PackedFloat32Array) -> PackedInt32Array: return Quantize.compress_rquat_9bits_array(a)
+			restore_array = func(a: PackedInt32Array) -> PackedFloat32Array: return Quantize.restore_rquat_9bits_array(a)
+		10:
+			compress = func(q: Quaternion) -> int: return Quantize.compress_rquat_10bits(q)
+			restore = func(c: int) -> Quaternion: return Quantize.restore_rquat_10bits(c)
+			compress_array = func(a: PackedFloat32Array) -> PackedInt32Array: return Quantize.compress_rquat_10bits_array(a)
+			restore_array = func(a: PackedInt32Array) -> PackedFloat32Array: return Quantize.restore_rquat_10bits_array(a)
+		15:
+			compress = func(q: Quaternion) -> PackedInt32Array: return Quantize.compress_rquat_15bits(q)
+			restore = func(c: PackedInt32Array) -> Quaternion: return Quantize.restore_rquat_15bits(c[0], c[1])
+			compress_array = func(a: PackedFloat32Array) -> PackedInt32Array: return Quantize.compress_rquat_15bits_array(a)
+			restore_array = func(a: PackedInt32Array) -> PackedFloat32Array: return Quantize.restore_rquat_15bits_array(a)
+
+	# Scalar path, one call per quaternion
+	var encoded: Array = []
+	@warning_ignore("return_value_discarded")
+	encoded.resize(_count)
+
+	var start: int = Time.get_ticks_usec()
+	for i: int in _count:
+		var o: int = i * 4
+		encoded[i] = compress.call(Quaternion(quats[o], quats[o + 1], quats[o + 2], quats[o + 3]))
+	_report_throughput("scalar encode", Time.get_ticks_usec() - start)
+
+	var scalar_restored: PackedFloat32Array = PackedFloat32Array()
+	@warning_ignore("return_value_discarded")
+	scalar_restored.resize(_count * 4)
+
+	start = Time.get_ticks_usec()
+	for i: int in _count:
+		var q: Quaternion = restore.call(encoded[i])
+		var o: int = i * 4
+		scalar_restored[o] = q.x
+		scalar_restored[o + 1] = q.y
+		scalar_restored[o + 2] = q.z
+		scalar_restored[o + 3] = q.w
+	_report_throughput("scalar decode", Time.get_ticks_usec() - start)
+
+	# Batch path, a single call for everything
+	start = Time.get_ticks_usec()
+	var batch: PackedInt32Array = compress_array.call(quats)
+	_report_throughput("batch encode", Time.get_ticks_usec() - start)
+
+	start = Time.get_ticks_usec()
+	var batch_restored: PackedFloat32Array = restore_array.call(batch)
+	_report_throughput("batch decode", Time.get_ticks_usec() - start)
+
+	_report_rotation_error("scalar", quats, scalar_restored)
+	_report_rotation_error("batch", quats, batch_restored)
+
+	if (scalar_restored != batch_restored):
+		push_error("Scalar and batch results of the %s bits compression don't match" % bits)
+
+
+func _bench_floats(bits: int, values: PackedFloat32Array) -> void:
+	print("\n%s bits unit floats" % bits)
+
+	var encoded: PackedInt32Array = PackedInt32Array()
+	@warning_ignore("return_value_discarded")
+	encoded.resize(_count)
+
+	var start: int = Time.get_ticks_usec()
+	for i: int in _count:
+		encoded[i] = Quantize.quantize_unit_float(values[i], bits)
+	_report_throughput("scalar encode", Time.get_ticks_usec() - start)
+
+	var scalar_restored: PackedFloat32Array = PackedFloat32Array()
+	@warning_ignore("return_value_discarded")
+	scalar_restored.resize(_count)
+
+	start = Time.get_ticks_usec()
+	for i: int in _count:
+		scalar_restored[i] = Quantize.restore_unit_float(encoded[i], bits)
+	_report_throughput("scalar decode", Time.get_ticks_usec() - start)
+
+	start = Time.get_ticks_usec()
+	var batch: PackedInt32Array = Quantize.quantize_unit_float_array(values, bits)
+	_report_throughput("batch encode", Time.get_ticks_usec() - start)
+
+	start = Time.get_ticks_usec()
+	var batch_restored: PackedFloat32Array = Quantize.restore_unit_float_array(batch, bits)
+	_report_throughput("batch decode", Time.get_ticks_usec() - start)
+
+	var max_err: float = 0.0
+	var total: float = 0.0
+	for i: int in _count:
+		var err: float = absf(batch_restored[i] - values[i])
+		max_err = maxf(max_err, err)
+		total += err
+
+	print("   %-24s max error: %.9f    mean error: %.9f" % ["batch", max_err, total / _count])
+
+	if (batch != encoded):
+		push_error("Scalar and batch results of the %s bits float quantization don't match" % bits)
+
+
+#######################################################################################################################
+### Overrides
+func _init() -> void:
+	_parse_arguments()
+
+	print("Quantize benchmark - %s values, seed %s" % [_count, _rng.seed])
+
+	var quats: PackedFloat32Array = _generate_quats()
+	for bits: int in [9, 10, 15]:
+		_bench_rquat(bits, quats)
+
+	var values: PackedFloat32Array = _generate_floats()
+	for bits: int in [8, 10, 12, 16]:
+		_bench_floats(bits, values)
+
+	quit()
@@ -28,6 +28,12 @@ smooth3d_enabled = 1
 # Functions that allow lossy compression of floating point numbers and rotation quaternions
 quantize_enabled = 1
 
+# Bit packed stream writer/reader, using the Quantize functions to write compressed data. Requires quantize_enabled
+bitstream_enabled = 1
+
+# Resource holding quantized Animation tracks, sampled on demand. Requires quantize_enabled
+quantized_animation_enabled = 1
+
 # Nodes that apply an impulse into all physical bodies that are within a configurable radius, from the
 # location the radial impulse is placed at.
 radial_impulse2d_enabled = 1
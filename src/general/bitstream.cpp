@@ -0,0 +1,517 @@
+/**
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "bitstream.h"
+
+#ifndef BITSTREAM_DISABLED
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+#include <string.h>
+
+
+/// BitStreamWriter
+void BitStreamWriter::flush_scratch()
+{
+   const int count = m_scratch_bits >> 3;
+   if (count == 0)
+   {
+      return;
+   }
+
+   const int64_t offset = m_buffer.size();
+   m_buffer.resize(offset + count);
+   uint8_t* dest = m_buffer.ptrw() + offset;
+
+   for (int i = 0; i < count; i++)
+   {
+      dest[i] = (uint8_t)(m_scratch & 0xFF);
+      m_scratch >>= 8;
+   }
+
+   m_scratch_bits -= count << 3;
+}
+
+
+void BitStreamWriter::write_uquat(const Quantize::uquat_data& data, int num_bits, bool with_signal)
+{
+   write_bits(data.a, num_bits);
+   write_bits(data.b, num_bits);
+   write_bits(data.c, num_bits);
+   write_bits(data.index, 2);
+
+   if (with_signal)
+   {
+      write_bits(data.signal, 1);
+   }
+}
+
+
+void BitStreamWriter::_bind_methods()
+{
+   using namespace godot;
+
+   ClassDB::bind_method(D_METHOD("write_bits", "value", "numbits"), &BitStreamWriter::write_bits);
+   ClassDB::bind_method(D_METHOD("write_bool", "value"), &BitStreamWriter::write_bool);
+   ClassDB::bind_method(D_METHOD("write_float", "value"), &BitStreamWriter::write_float);
+   ClassDB::bind_method(D_METHOD("write_unit_float", "value", "numbits"), &BitStreamWriter::write_unit_float);
+   ClassDB::bind_method(D_METHOD("write_quantized_float", "value", "minval", "maxval", "numbits"), &BitStreamWriter::write_quantized_float);
+   ClassDB::bind_method(D_METHOD("write_quantized_float_array", "values", "minval", "maxval", "numbits"), &BitStreamWriter::write_quantized_float_array);
+   ClassDB::bind_method(D_METHOD("write_rotation_quat", "q", "numbits"), &BitStreamWriter::write_rotation_quat);
+   ClassDB::bind_method(D_METHOD("write_rquat_9", "q"), &BitStreamWriter::write_rquat_9);
+   ClassDB::bind_method(D_METHOD("write_rquat_10", "q"), &BitStreamWriter::write_rquat_10);
+   ClassDB::bind_method(D_METHOD("write_rquat_15", "q"), &BitStreamWriter::write_rquat_15);
+   ClassDB::bind_method(D_METHOD("write_delta", "baseline", "current", "numbits"), &BitStreamWriter::write_delta);
+   ClassDB::bind_method(D_METHOD("align"), &BitStreamWriter::align);
+   ClassDB::bind_method(D_METHOD("get_bit_count"), &BitStreamWriter::get_bit_count);
+   ClassDB::bind_method(D_METHOD("get_byte_count"), &BitStreamWriter::get_byte_count);
+   ClassDB::bind_method(D_METHOD("clear"), &BitStreamWriter::clear);
+   ClassDB::bind_method(D_METHOD("get_data"), &BitStreamWriter::get_data);
+}
+
+
+void BitStreamWriter::write_bits(uint32_t value, int num_bits)
+{
+   ERR_FAIL_COND_MSG(num_bits < 1 || num_bits > 32, godot::vformat("Number of bits must be between 1 and 32, but %s has been given", num_bits));
+
+   const uint64_t mask = (uint64_t(1) << num_bits) - 1;
+   m_scratch |= (uint64_t(value) & mask) << m_scratch_bits;
+   m_scratch_bits += num_bits;
+
+   // Scratch holds at most 7 bits after a flush, so 32 incoming bits always fit. Flushing only once
+   // 32 bits are accumulated to reduce the number of buffer resizes
+   if (m_scratch_bits >= 32)
+   {
+      flush_scratch();
+   }
+}
+
+
+void BitStreamWriter::write_bool(bool value)
+{
+   write_bits(value ? 1 : 0, 1);
+}
+
+
+void BitStreamWriter::write_float(float value)
+{
+   uint32_t bits;
+   memcpy(&bits, &value, sizeof(uint32_t));
+   write_bits(bits, 32);
+}
+
+
+void BitStreamWriter::write_unit_float(double value, int num_bits)
+{
+   ERR_FAIL_COND_MSG(num_bits < 2 || num_bits > 32, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   write_bits(Quantize::quantize_unit_float(value, num_bits), num_bits);
+}
+
+
+void BitStreamWriter::write_quantized_float(double value, double minval, double maxval, int num_bits)
+{
+   ERR_FAIL_COND_MSG(num_bits < 2 || num_bits > 32, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   write_bits(Quantize::quantize_float(value, minval, maxval, num_bits), num_bits);
+}
+
+
+void BitStreamWriter::write_quantized_float_array(const godot::PackedFloat32Array& values, double minval, double maxval, int num_bits)
+{
+   ERR_FAIL_COND_MSG(num_bits < 2 || num_bits > 32, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   const int64_t count = values.size();
+   if (count == 0)
+   {
+      return;
+   }
+
+   godot::Vector<uint32_t> quantized;
+   quantized.resize(count);
+   Quantize::quantize_float_batch(values.ptr(), quantized.ptrw(), count, minval, maxval, num_bits);
+
+   const uint32_t* q = quantized.ptr();
+   for (int64_t i = 0; i < count; i++)
+   {
+      write_bits(q[i], num_bits);
+   }
+}
+
+
+void BitStreamWriter::write_rotation_quat(const godot::Quaternion& q, int num_bits)
+{
+   ERR_FAIL_COND_MSG(num_bits < 2 || num_bits > 32, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   write_uquat(Quantize::compress_rotation_quaternion(q, num_bits), num_bits, false);
+}
+
+
+void BitStreamWriter::write_rquat_9(const godot::Quaternion& q)
+{
+   write_uquat(Quantize::compress_rotation_quaternion_t<9>(q), 9, true);
+}
+
+
+void BitStreamWriter::write_rquat_10(const godot::Quaternion& q)
+{
+   write_uquat(Quantize::compress_rotation_quaternion_t<10>(q), 10, false);
+}
+
+
+void BitStreamWriter::write_rquat_15(const godot::Quaternion& q)
+{
+   write_uquat(Quantize::compress_rotation_quaternion_t<15>(q), 15, true);
+}
+
+
+int64_t BitStreamWriter::write_delta(const godot::PackedInt32Array& baseline, const godot::PackedInt32Array& current, int num_bits)
+{
+   ERR_FAIL_COND_V_MSG(num_bits < 1 || num_bits > 32, 0, godot::vformat("Number of bits must be between 1 and 32, but %s has been given", num_bits));
+   ERR_FAIL_COND_V_MSG(baseline.size() != current.size(), 0, godot::vformat("Baseline holds %s entries while current holds %s", baseline.size(), current.size()));
+
+   const int64_t count = current.size();
+   const uint32_t* base = (const uint32_t*)baseline.ptr();
+   const uint32_t* curr = (const uint32_t*)current.ptr();
+
+   // Only the bits that are actually written matter when comparing
+   const uint32_t value_mask = (uint32_t)((uint64_t(1) << num_bits) - 1);
+
+   // Build the change mask first, in 32 entries chunks. Since bits are written starting from the lowest one, each chunk
+   // can be directly written as a single integer
+   godot::Vector<uint32_t> mask;
+   mask.resize((count + 31) >> 5);
+   uint32_t* mask_ptr = mask.ptrw();
+   int64_t changed = 0;
+
+   for (int64_t chunk = 0; chunk < mask.size(); chunk++)
+   {
+      const int64_t first = chunk << 5;
+      const int64_t last = godot::Math::min<int64_t>(first + 32, count);
+      uint32_t word = 0;
+
+      for (int64_t i = first; i < last; i++)
+      {
+         const uint32_t diff = ((base[i] ^ curr[i]) & value_mask) != 0;
+         word |= diff << (i - first);
+         changed += diff;
+      }
+
+      mask_ptr[chunk] = word;
+   }
+
+   write_bool(changed > 0);
+   if (changed == 0)
+   {
+      // The most common case for idle entities. A single bit for the entire array
+      return 0;
+   }
+
+   for (int64_t chunk = 0; chunk < mask.size(); chunk++)
+   {
+      const int64_t remaining = count - (chunk << 5);
+      write_bits(mask_ptr[chunk], remaining < 32 ? (int)remaining : 32);
+   }
+
+   for (int64_t chunk = 0; chunk < mask.size(); chunk++)
+   {
+      const uint32_t word = mask_ptr[chunk];
+      if (word == 0)
+      {
+         continue;
+      }
+
+      const int64_t first = chunk << 5;
+      const int64_t last = godot::Math::min<int64_t>(first + 32, count);
+      for (int64_t i = first; i < last; i++)
+      {
+         if ((word >> (i - first)) & 1)
+         {
+            write_bits(curr[i], num_bits);
+         }
+      }
+   }
+
+   return changed;
+}
+
+
+void BitStreamWriter::align()
+{
+   const int pad = (8 - (m_scratch_bits & 7)) & 7;
+   if (pad > 0)
+   {
+      write_bits(0, pad);
+   }
+}
+
+
+void BitStreamWriter::clear()
+{
+   m_buffer.clear();
+   m_scratch = 0;
+   m_scratch_bits = 0;
+}
+
+
+godot::PackedByteArray BitStreamWriter::get_data() const
+{
+   godot::PackedByteArray ret;
+
+   const int64_t full = m_buffer.size();
+   const int pending = (m_scratch_bits + 7) >> 3;
+
+   ret.resize(full + pending);
+   uint8_t* dest = ret.ptrw();
+
+   if (full > 0)
+   {
+      memcpy(dest, m_buffer.ptr(), full);
+   }
+
+   // Bits above m_scratch_bits are always 0, so the last byte is already padded
+   uint64_t scratch = m_scratch;
+   for (int i = 0; i < pending; i++)
+   {
+      dest[full + i] = (uint8_t)(scratch & 0xFF);
+      scratch >>= 8;
+   }
+
+   return ret;
+}
+
+
+
+/// BitStreamReader
+Quantize::uquat_data BitStreamReader::read_uquat(int num_bits, bool with_signal)
+{
+   Quantize::uquat_data ret;
+   ret.a = read_bits(num_bits);
+   ret.b = read_bits(num_bits);
+   ret.c = read_bits(num_bits);
+   ret.index = read_bits(2);
+   ret.signal = with_signal ? read_bits(1) : 1;
+
+   return ret;
+}
+
+
+void BitStreamReader::_bind_methods()
+{
+   using namespace godot;
+
+   ClassDB::bind_method(D_METHOD("set_data", "data"), &BitStreamReader::set_data);
+   ClassDB::bind_method(D_METHOD("get_data"), &BitStreamReader::get_data);
+   ClassDB::bind_method(D_METHOD("read_bits", "numbits"), &BitStreamReader::read_bits);
+   ClassDB::bind_method(D_METHOD("read_bool"), &BitStreamReader::read_bool);
+   ClassDB::bind_method(D_METHOD("read_float"), &BitStreamReader::read_float);
+   ClassDB::bind_method(D_METHOD("read_unit_float", "numbits"), &BitStreamReader::read_unit_float);
+   ClassDB::bind_method(D_METHOD("read_quantized_float", "minval", "maxval", "numbits"), &BitStreamReader::read_quantized_float);
+   ClassDB::bind_method(D_METHOD("read_quantized_float_array", "count", "minval", "maxval", "numbits"), &BitStreamReader::read_quantized_float_array);
+   ClassDB::bind_method(D_METHOD("read_rotation_quat", "numbits"), &BitStreamReader::read_rotation_quat);
+   ClassDB::bind_method(D_METHOD("read_rquat_9"), &BitStreamReader::read_rquat_9);
+   ClassDB::bind_method(D_METHOD("read_rquat_10"), &BitStreamReader::read_rquat_10);
+   ClassDB::bind_method(D_METHOD("read_rquat_15"), &BitStreamReader::read_rquat_15);
+   ClassDB::bind_method(D_METHOD("read_delta", "baseline", "numbits"), &BitStreamReader::read_delta);
+   ClassDB::bind_method(D_METHOD("align"), &BitStreamReader::align);
+   ClassDB::bind_method(D_METHOD("get_position"), &BitStreamReader::get_position);
+   ClassDB::bind_method(D_METHOD("seek", "bit_position"), &BitStreamReader::seek);
+   ClassDB::bind_method(D_METHOD("get_bit_count"), &BitStreamReader::get_bit_count);
+   ClassDB::bind_method(D_METHOD("get_bits_left"), &BitStreamReader::get_bits_left);
+}
+
+
+void BitStreamReader::set_data(const godot::PackedByteArray& data)
+{
+   m_data = data;
+   m_ptr = m_data.size() > 0 ? m_data.ptr() : nullptr;
+   m_bit_count = m_data.size() << 3;
+   m_position = 0;
+}
+
+
+uint32_t BitStreamReader::read_bits(int num_bits)
+{
+   ERR_FAIL_COND_V_MSG(num_bits < 1 || num_bits > 32, 0, godot::vformat("Number of bits must be between 1 and 32, but %s has been given", num_bits));
+   ERR_FAIL_COND_V_MSG(m_position + num_bits > m_bit_count, 0, godot::vformat("Attempting to read %s bits but only %s are left in the stream", num_bits, get_bits_left()));
+
+   // At most 5 bytes are touched (7 bits of offset + 32 bits of data), so everything fits in 64 bits
+   const int64_t first = m_position >> 3;
+   const int64_t last = (m_position + num_bits - 1) >> 3;
+
+   uint64_t chunk = 0;
+   for (int64_t i = last; i >= first; i--)
+   {
+      chunk = (chunk << 8) | m_ptr[i];
+   }
+
+   chunk >>= (m_position & 7);
+   m_position += num_bits;
+
+   return (uint32_t)(chunk & ((uint64_t(1) << num_bits) - 1));
+}
+
+
+bool BitStreamReader::read_bool()
+{
+   return read_bits(1) != 0;
+}
+
+
+float BitStreamReader::read_float()
+{
+   const uint32_t bits = read_bits(32);
+   float ret;
+   memcpy(&ret, &bits, sizeof(float));
+   return ret;
+}
+
+
+double BitStreamReader::read_unit_float(int num_bits)
+{
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, 0.0, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   return Quantize::restore_unit_float(read_bits(num_bits), num_bits);
+}
+
+
+double BitStreamReader::read_quantized_float(double minval, double maxval, int num_bits)
+{
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, minval, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   return Quantize::restore_float(read_bits(num_bits), minval, maxval, num_bits);
+}
+
+
+godot::PackedFloat32Array BitStreamReader::read_quantized_float_array(int64_t count, double minval, double maxval, int num_bits)
+{
+   godot::PackedFloat32Array ret;
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, ret, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   ERR_FAIL_COND_V_MSG(count < 0 || count * num_bits > get_bits_left(), ret, godot::vformat("Attempting to read %s values of %s bits but only %s bits are left in the stream", count, num_bits, get_bits_left()));
+
+   if (count == 0)
+   {
+      return ret;
+   }
+
+   godot::Vector<uint32_t> quantized;
+   quantized.resize(count);
+   uint32_t* q = quantized.ptrw();
+   for (int64_t i = 0; i < count; i++)
+   {
+      q[i] = read_bits(num_bits);
+   }
+
+   ret.resize(count);
+   Quantize::restore_float_batch(quantized.ptr(), ret.ptrw(), count, minval, maxval, num_bits);
+
+   return ret;
+}
+
+
+godot::Quaternion BitStreamReader::read_rotation_quat(int num_bits)
+{
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, godot::Quaternion(), godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+   return Quantize::restore_rotation_quaternion(read_uquat(num_bits, false), num_bits);
+}
+
+
+godot::Quaternion BitStreamReader::read_rquat_9()
+{
+   return Quantize::restore_rotation_quaternion_t<9>(read_uquat(9, true));
+}
+
+
+godot::Quaternion BitStreamReader::read_rquat_10()
+{
+   return Quantize::restore_rotation_quaternion_t<10>(read_uquat(10, false));
+}
+
+
+godot::Quaternion BitStreamReader::read_rquat_15()
+{
+   return Quantize::restore_rotation_quaternion_t<15>(read_uquat(15, true));
+}
+
+
+godot::PackedInt32Array BitStreamReader::read_delta(const godot::PackedInt32Array& baseline, int num_bits)
+{
+   godot::PackedInt32Array ret = baseline;
+   ERR_FAIL_COND_V_MSG(num_bits < 1 || num_bits > 32, ret, godot::vformat("Number of bits must be between 1 and 32, but %s has been given", num_bits));
+
+   if (!read_bool())
+   {
+      return ret;
+   }
+
+   const int64_t count = baseline.size();
+   ERR_FAIL_COND_V_MSG(count > get_bits_left(), ret, godot::vformat("Stream does not hold enough bits for the change mask of %s entries", count));
+
+   godot::Vector<uint32_t> mask;
+   mask.resize((count + 31) >> 5);
+   uint32_t* mask_ptr = mask.ptrw();
+
+   for (int64_t chunk = 0; chunk < mask.size(); chunk++)
+   {
+      const int64_t remaining = count - (chunk << 5);
+      mask_ptr[chunk] = read_bits(remaining < 32 ? (int)remaining : 32);
+   }
+
+   // Only touch the returned array (which triggers the copy on write) after the mask has been read
+   uint32_t* out = (uint32_t*)ret.ptrw();
+   const uint32_t value_mask = (uint32_t)((uint64_t(1) << num_bits) - 1);
+
+   for (int64_t chunk = 0; chunk < mask.size(); chunk++)
+   {
+      const uint32_t word = mask_ptr[chunk];
+      if (word == 0)
+      {
+         continue;
+      }
+
+      const int64_t first = chunk << 5;
+      const int64_t last = godot::Math::min<int64_t>(first + 32, count);
+      for (int64_t i = first; i < last; i++)
+      {
+         if ((word >> (i - first)) & 1)
+         {
+            // Keep the bits of the baseline that are not part of the quantized value
+            out[i] = (out[i] & ~value_mask) | read_bits(num_bits);
+         }
+      }
+   }
+
+   return ret;
+}
+
+
+void BitStreamReader::align()
+{
+   m_position = godot::Math::min<int64_t>((m_position + 7) & ~int64_t(7), m_bit_count);
+}
+
+
+void BitStreamReader::seek(int64_t bit_position)
+{
+   ERR_FAIL_COND_MSG(bit_position < 0 || bit_position > m_bit_count, godot::vformat("Position %s is outside of the stream, which holds %s bits", bit_position, m_bit_count));
+   m_position = bit_position;
+}
+
+
+#endif  //BITSTREAM_DISABLED
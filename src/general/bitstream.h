@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef _kehgeneral_bitstream_h_included
+#define _kehgeneral_bitstream_h_included 1
+
+#include <godot_cpp/godot.hpp>
+#include <godot_cpp/classes/ref_counted.hpp>
+#include <godot_cpp/templates/vector.hpp>
+
+
+#ifndef BITSTREAM_DISABLED
+
+#include "quantize.h"
+
+
+// Bits are written "least significant first". That is, the first bit written into the stream goes into the
+// lowest bit of the first byte. Values are also written starting from their lowest bit. The reader must
+// follow the exact same order of calls (and number of bits) used when writing the data.
+
+class BitStreamWriter : public godot::RefCounted
+{
+   GDCLASS(BitStreamWriter, godot::RefCounted);
+private:
+   // Holds the completely filled bytes
+   godot::Vector<uint8_t> m_buffer;
+
+   // Bits that were written but still don't fill enough bytes to be moved into the buffer. Because a single
+   // write is limited to 32 bits, there is always enough room in here for the incoming data
+   uint64_t m_scratch;
+   int m_scratch_bits;
+
+   // Move all whole bytes held by the scratch into the buffer
+   void flush_scratch();
+
+   // Write the smallest three components of a compressed rotation quaternion
+   void write_uquat(const Quantize::uquat_data& data, int num_bits, bool with_signal);
+
+protected:
+   static void _bind_methods();
+
+public:
+   // Append the lowest 'num_bits' bits of the given value into the stream. The number of bits must be
+   // in the [1..32] range.
+   void write_bits(uint32_t value, int num_bits);
+
+   // A single bit
+   void write_bool(bool value);
+
+   // Write the full 32 bits of a single precision float, without any loss
+   void write_float(float value);
+
+   // Quantize the given unit float ([0..1] range) and write the result using 'num_bits' bits
+   void write_unit_float(double value, int num_bits);
+
+   // Quantize a float in the [minval..maxval] range and write the result using 'num_bits' bits
+   void write_quantized_float(double value, double minval, double maxval, int num_bits);
+
+   // Quantize all floats in the given array using the same range and number of bits. This does not
+   // write the amount of values, so the reader must know it beforehand (or it has to be written first).
+   void write_quantized_float_array(const godot::PackedFloat32Array& values, double minval, double maxval, int num_bits);
+
+   // Compress a rotation quaternion using the smallest three method with 'num_bits' bits per component.
+   // Only 3 * num_bits + 2 bits are written, meaning that the signal is not kept. For rotations this is
+   // not a problem as q and -q represent the same orientation.
+   void write_rotation_quat(const godot::Quaternion& q, int num_bits);
+
+   // Those are equivalent to the compress_rquat_*bits() functions in the Quantize class, however no bit is
+   // wasted. The 9 bits version takes 30 bits, the 10 bits one 32 bits and the 15 bits one 48 bits. Like
+   // the Quantize counterparts, the 9 and 15 bits versions keep the original quaternion signal.
+   void write_rquat_9(const godot::Quaternion& q);
+   void write_rquat_10(const godot::Quaternion& q);
+   void write_rquat_15(const godot::Quaternion& q);
+
+   // Write only the entries of 'current' that differ from 'baseline', each one using 'num_bits' bits. Both arrays
+   // must have the same size, which is not written. The layout is a single bit telling if anything changed. If so, it's
+   // followed by one bit per entry (1 meaning changed) then the changed values, in order. Returns the number of
+   // changed entries.
+   int64_t write_delta(const godot::PackedInt32Array& baseline, const godot::PackedInt32Array& current, int num_bits);
+
+   // Pad the stream with 0 bits until the next byte boundary
+   void align();
+
+   // Total number of bits written so far
+   int64_t get_bit_count() const { return (int64_t(m_buffer.size()) << 3) + m_scratch_bits; }
+
+   // Number of bytes required to hold all the written bits
+   int64_t get_byte_count() const { return (get_bit_count() + 7) >> 3; }
+
+   // Discard everything that has been written
+   void clear();
+
+   // Retrieve the written data. If the number of written bits is not a multiple of 8 then the last byte is
+   // padded with 0 bits
+   godot::PackedByteArray get_data() const;
+
+   BitStreamWriter() : m_scratch(0), m_scratch_bits(0) {}
+};
+
+
+
+class BitStreamReader : public godot::RefCounted
+{
+   GDCLASS(BitStreamReader, godot::RefCounted);
+private:
+   godot::PackedByteArray m_data;
+
+   // Cached pointer to the data so the read functions don't have to query it on every call. The array above
+   // holds a reference to the data, so this remains valid until set_data() is called again
+   const uint8_t* m_ptr;
+
+   int64_t m_bit_count;
+   int64_t m_position;
+
+   Quantize::uquat_data read_uquat(int num_bits, bool with_signal);
+
+protected:
+   static void _bind_methods();
+
+public:
+   // Assign the data to be read and reset the read position
+   void set_data(const godot::PackedByteArray& data);
+   const godot::PackedByteArray& get_data() const { return m_data; }
+
+   // Read 'num_bits' bits ([1..32] range) from the stream
+   uint32_t read_bits(int num_bits);
+
+   bool read_bool();
+
+   float read_float();
+
+   double read_unit_float(int num_bits);
+
+   double read_quantized_float(double minval, double maxval, int num_bits);
+
+   godot::PackedFloat32Array read_quantized_float_array(int64_t count, double minval, double maxval, int num_bits);
+
+   godot::Quaternion read_rotation_quat(int num_bits);
+
+   godot::Quaternion read_rquat_9();
+   godot::Quaternion read_rquat_10();
+   godot::Quaternion read_rquat_15();
+
+   // Read data written by BitStreamWriter::write_delta(), returning a copy of the baseline with the changed entries
+   // replaced. The baseline must be identical to the one used when writing
+   godot::PackedInt32Array read_delta(const godot::PackedInt32Array& baseline, int num_bits);
+
+   // Skip the remaining bits of the current byte
+   void align();
+
+   // Read position, in bits
+   int64_t get_position() const { return m_position; }
+   void seek(int64_t bit_position);
+
+   int64_t get_bit_count() const { return m_bit_count; }
+   int64_t get_bits_left() const { return m_bit_count - m_position; }
+
+   BitStreamReader() : m_ptr(nullptr), m_bit_count(0), m_position(0) {}
+};
+
+
+
+#endif  //BITSTREAM_DISABLED
+
+
+#endif  //_kehgeneral_bitstream_h_included
@@ -28,7 +28,20 @@
 #include <godot_cpp/core/class_db.hpp>
 #include <godot_cpp/variant/utility_functions.hpp>
 
-const double Quantize::ROTATION_BOUNDS = 0.707107;
+// The SIMD path of the rotation quaternion batch compression is only available on x86. Other architectures (and
+// CPUs without AVX) will always use the scalar code
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(__EMSCRIPTEN__)
+   #define QUANTIZE_X86_SIMD 1
+   #include <immintrin.h>
+
+   #if defined(_MSC_VER) && !defined(__clang__)
+      #include <intrin.h>
+      // MSVC does not require any special attribute to use intrinsics
+      #define QUANTIZE_TARGET_AVX
+   #else
+      #define QUANTIZE_TARGET_AVX __attribute__((target("avx")))
+   #endif
+#endif
 
 const uint32_t Quantize::Quantize::MASK_A_9BIT = 511;              // 511 == 111111111   (9 bits per component)
 const uint32_t Quantize::MASK_B_9BIT = 511 << 9;
@@ -48,6 +61,313 @@ const uint32_t Quantize::MASK_INDEX_15BIT = 3 << 30;
 const uint32_t Quantize::MASK_SIGNAL_15BIT = 1 << 15;
 
 
+// Size of each interval in the [0..1] range for every possible number of bits, indexed by that number. Restoring a
+// value then becomes a table load and a multiplication instead of a shift, an integer to float conversion and a division.
+// Entries are computed with the exact same expression previously used at runtime ("1.0f / (double)(intervals - 1.0f)",
+// which is evaluated in single precision before the conversion to double) so restored values remain bit identical.
+struct IntervalSizeTable
+{
+   double value[33];
+
+   constexpr IntervalSizeTable() : value()
+   {
+      for (int i = 1; i <= 32; i++)
+      {
+         value[i] = 1.0f / (double)((float)(uint64_t(1) << i) - 1.0f);
+      }
+   }
+};
+
+static constexpr IntervalSizeTable s_interval_size;
+
+
+// Bit widths that get a dedicated (compile time specialized) path when the runtime functions dispatch to the templated
+// ones. Any other width uses the exact same math, but with the constants computed during runtime
+#define QUANTIZE_SPECIALIZED_BITS(CASE) CASE(8) CASE(9) CASE(10) CASE(12) CASE(15) CASE(16)
+
+static inline uint32_t max_quantized(int num_bits)
+{
+   return (uint32_t)((uint64_t(1) << num_bits) - 1);
+}
+
+static inline float quantize_scale(int num_bits)
+{
+   return (float)(uint64_t(1) << num_bits) - 1.0f;
+}
+
+
+// The batch kernels are templated on the floating point type of the buffer so both PackedFloat32Array and
+// PackedFloat64Array can share the exact same code. The math is identical to quantize_unit_float()/quantize_float()
+// and restore_unit_float()/restore_float(), meaning that the results are bit identical to the scalar versions. The
+// loop bodies don't contain any branch, which allows the compiler to vectorize them.
+template <typename T, int Bits>
+static void quantize_batch_kernel_t(const T* values, uint32_t* out, int64_t count, double minval, double maxval)
+{
+   const double range = maxval - minval;
+
+   for (int64_t i = 0; i < count; i++)
+   {
+      out[i] = Quantize::quantize_unit_float_t<Bits>(((double)values[i] - minval) / range);
+   }
+}
+
+template <typename T>
+static void quantize_batch_kernel(const T* values, uint32_t* out, int64_t count, double minval, double maxval, int num_bits)
+{
+   switch (num_bits)
+   {
+      #define QUANTIZE_BATCH_CASE(b) case b: quantize_batch_kernel_t<T, b>(values, out, count, minval, maxval); return;
+      QUANTIZE_SPECIALIZED_BITS(QUANTIZE_BATCH_CASE)
+      #undef QUANTIZE_BATCH_CASE
+   }
+
+   const uint32_t max_quant = max_quantized(num_bits);
+   const float scale = quantize_scale(num_bits);
+   const double range = maxval - minval;
+
+   for (int64_t i = 0; i < count; i++)
+   {
+      out[i] = Quantize::quantize_unit_float_impl(((double)values[i] - minval) / range, max_quant, scale);
+   }
+}
+
+
+template <typename T, int Bits>
+static void restore_batch_kernel_t(const uint32_t* quantized, T* out, int64_t count, double minval, double maxval)
+{
+   const double range = maxval - minval;
+
+   for (int64_t i = 0; i < count; i++)
+   {
+      out[i] = (T)(minval + (Quantize::restore_unit_float_t<Bits>(quantized[i]) * range));
+   }
+}
+
+template <typename T>
+static void restore_batch_kernel(const uint32_t* quantized, T* out, int64_t count, double minval, double maxval, int num_bits)
+{
+   switch (num_bits)
+   {
+      #define RESTORE_BATCH_CASE(b) case b: restore_batch_kernel_t<T, b>(quantized, out, count, minval, maxval); return;
+      QUANTIZE_SPECIALIZED_BITS(RESTORE_BATCH_CASE)
+      #undef RESTORE_BATCH_CASE
+   }
+
+   const double interval_size = s_interval_size.value[num_bits];
+   const double range = maxval - minval;
+
+   for (int64_t i = 0; i < count; i++)
+   {
+      out[i] = (T)(minval + (Quantize::restore_unit_float_impl(quantized[i], interval_size) * range));
+   }
+}
+
+
+// An axis can either be skipped (0 bits) or use the same range accepted by quantize_unit_float()
+static inline bool is_valid_axis_bits(int num_bits)
+{
+   return num_bits == 0 || (num_bits >= 2 && num_bits <= 32);
+}
+
+static inline void write_axis(uint32_t* words, int64_t& bit_pos, double value, double minval, double maxval, int num_bits)
+{
+   if (num_bits == 0)
+   {
+      return;
+   }
+
+   const double clamped = godot::Math::clamp<double>(value, godot::Math::min<double>(minval, maxval), godot::Math::max<double>(minval, maxval));
+   Quantize::write_packed_bits(words, bit_pos, Quantize::quantize_float(clamped, minval, maxval, num_bits), num_bits);
+}
+
+static inline double read_axis(const uint32_t* words, int64_t& bit_pos, double minval, double maxval, int num_bits)
+{
+   if (num_bits == 0)
+   {
+      return minval;
+   }
+
+   return Quantize::restore_float(Quantize::read_packed_bits(words, bit_pos, num_bits), minval, maxval, num_bits);
+}
+
+// Largest data that can be packed by the vector/transform functions is a Transform3D using 32 bits for everything, that is,
+// 3 * 32 (position) + 3 * 32 + 2 (rotation) + 3 * 32 (scale) = 290 bits
+static const int MAX_PACKED_WORDS = 10;
+
+
+#ifdef QUANTIZE_X86_SIMD
+static bool cpu_has_avx()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+   int info[4];
+   __cpuid(info, 1);
+
+   // Besides the CPU supporting AVX, the OS must be saving the YMM registers (OSXSAVE + XCR0 bits 1 and 2)
+   const bool osxsave = (info[2] & (1 << 27)) != 0;
+   const bool avx = (info[2] & (1 << 28)) != 0;
+   if (!osxsave || !avx)
+   {
+      return false;
+   }
+
+   return (_xgetbv(0) & 0x6) == 0x6;
+#else
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx");
+#endif
+}
+
+// Query the CPU only once
+static bool has_avx()
+{
+   static const bool s_avx = cpu_has_avx();
+   return s_avx;
+}
+
+
+// Performs the "smallest three" quantization of 4 rotation quaternions at once. The incoming pointer must point to 16
+// floats (x, y, z, w of each quaternion in sequence). Each output register holds the corresponding value of the 4
+// quaternions, that is, the 3 quantized components, the index of the dropped one and its signal (1 = positive, 0 = negative).
+// The math is done in double precision, following the exact same operations of compress_rotation_quaternion(), so the
+// results are bit identical to the scalar path.
+QUANTIZE_TARGET_AVX
+static void smallest_three_x4(const float* xyzw, double bounds, int num_bits, __m128i& out_a, __m128i& out_b, __m128i& out_c, __m128i& out_index, __m128i& out_signal)
+{
+   // Transpose so each register holds one of the components of all 4 quaternions
+   __m128 r0 = _mm_loadu_ps(xyzw);
+   __m128 r1 = _mm_loadu_ps(xyzw + 4);
+   __m128 r2 = _mm_loadu_ps(xyzw + 8);
+   __m128 r3 = _mm_loadu_ps(xyzw + 12);
+   _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+   const __m256d x = _mm256_cvtps_pd(r0);
+   const __m256d y = _mm256_cvtps_pd(r1);
+   const __m256d z = _mm256_cvtps_pd(r2);
+   const __m256d w = _mm256_cvtps_pd(r3);
+
+   const __m256d zero = _mm256_setzero_pd();
+   const __m256d one = _mm256_set1_pd(1.0);
+   const __m256d sign_bit = _mm256_set1_pd(-0.0);
+
+   // Locate the largest component. Strict "greater than" so the first one wins on ties, just like the scalar loop
+   __m256d mval = _mm256_andnot_pd(sign_bit, x);
+   __m256d mindex = zero;
+   __m256d gt;
+
+   const __m256d ay = _mm256_andnot_pd(sign_bit, y);
+   gt = _mm256_cmp_pd(ay, mval, _CMP_GT_OQ);
+   mval = _mm256_blendv_pd(mval, ay, gt);
+   mindex = _mm256_blendv_pd(mindex, _mm256_set1_pd(1.0), gt);
+
+   const __m256d az = _mm256_andnot_pd(sign_bit, z);
+   gt = _mm256_cmp_pd(az, mval, _CMP_GT_OQ);
+   mval = _mm256_blendv_pd(mval, az, gt);
+   mindex = _mm256_blendv_pd(mindex, _mm256_set1_pd(2.0), gt);
+
+   const __m256d aw = _mm256_andnot_pd(sign_bit, w);
+   gt = _mm256_cmp_pd(aw, mval, _CMP_GT_OQ);
+   mindex = _mm256_blendv_pd(mindex, _mm256_set1_pd(3.0), gt);
+
+   // Masks telling which component got dropped
+   const __m256d drop_x = _mm256_cmp_pd(mindex, zero, _CMP_EQ_OQ);
+   const __m256d drop_xy = _mm256_cmp_pd(mindex, one, _CMP_LE_OQ);
+   const __m256d drop_xyz = _mm256_cmp_pd(mindex, _mm256_set1_pd(2.0), _CMP_LE_OQ);
+
+   // Signal of the dropped component
+   __m256d dropped = w;
+   dropped = _mm256_blendv_pd(dropped, z, _mm256_cmp_pd(mindex, _mm256_set1_pd(2.0), _CMP_EQ_OQ));
+   dropped = _mm256_blendv_pd(dropped, y, _mm256_cmp_pd(mindex, one, _CMP_EQ_OQ));
+   dropped = _mm256_blendv_pd(dropped, x, drop_x);
+   const __m256d negative = _mm256_cmp_pd(dropped, zero, _CMP_LT_OQ);
+   const __m256d sig = _mm256_blendv_pd(one, _mm256_set1_pd(-1.0), negative);
+
+   // The remaining components, in the same order they are taken by the scalar loop
+   const __m256d a = _mm256_mul_pd(_mm256_blendv_pd(x, y, drop_x), sig);
+   const __m256d b = _mm256_mul_pd(_mm256_blendv_pd(y, z, drop_xy), sig);
+   const __m256d c = _mm256_mul_pd(_mm256_blendv_pd(z, w, drop_xyz), sig);
+
+   // Then quantize, mimicking quantize_float() followed by quantize_unit_float()
+   const uint32_t intervals = 1 << num_bits;
+   const __m256d minval = _mm256_set1_pd(-bounds);
+   const __m256d range = _mm256_set1_pd(bounds - (-bounds));
+   const __m256d scale = _mm256_set1_pd(intervals - 1.0f);
+   const __m256d half = _mm256_set1_pd(0.5f);
+   const __m128i max_quant = _mm_set1_epi32((int)(intervals - 1));
+
+   const __m256d comps[3] = { a, b, c };
+   __m128i quant[3];
+   for (int i = 0; i < 3; i++)
+   {
+      const __m256d unit = _mm256_div_pd(_mm256_sub_pd(comps[i], minval), range);
+      const __m128i rounded = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_mul_pd(unit, scale), half));
+
+      // The comparison results in -1 on the lanes above the maximum, so adding it is the same as subtracting 1
+      quant[i] = _mm_add_epi32(rounded, _mm_cmpgt_epi32(rounded, max_quant));
+   }
+
+   out_a = quant[0];
+   out_b = quant[1];
+   out_c = quant[2];
+   out_index = _mm256_cvttpd_epi32(mindex);
+   out_signal = _mm256_cvttpd_epi32(_mm256_blendv_pd(one, zero, negative));
+}
+
+
+// Compress 'count' rotation quaternions, 4 at a time, packing them using the layouts defined by the MASK_* constants.
+// Returns how many quaternions were compressed, which is always a multiple of 4. The remaining ones must be done by the
+// scalar path.
+QUANTIZE_TARGET_AVX
+static int64_t compress_rquat_batch_avx(const float* xyzw, uint32_t* out, int64_t count, double bounds, int num_bits)
+{
+   const int64_t simd_count = count & ~((int64_t)3);
+   const __m128i comp_mask = _mm_set1_epi32((1 << num_bits) - 1);
+
+   for (int64_t i = 0; i < simd_count; i += 4)
+   {
+      __m128i a, b, c, index, signal;
+      smallest_three_x4(xyzw + (i * 4), bounds, num_bits, a, b, c, index, signal);
+
+      a = _mm_and_si128(a, comp_mask);
+      b = _mm_and_si128(b, comp_mask);
+      c = _mm_and_si128(c, comp_mask);
+
+      switch (num_bits)
+      {
+         case 9:
+         {
+            __m128i packed = _mm_or_si128(a, _mm_slli_epi32(b, 9));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(c, 18));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(index, 27));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(signal, 30));
+            _mm_storeu_si128((__m128i*)(out + i), packed);
+         } break;
+
+         case 10:
+         {
+            __m128i packed = _mm_or_si128(a, _mm_slli_epi32(b, 10));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(c, 20));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(index, 30));
+            _mm_storeu_si128((__m128i*)(out + i), packed);
+         } break;
+
+         case 15:
+         {
+            const __m128i pack0 = _mm_or_si128(_mm_or_si128(a, _mm_slli_epi32(b, 15)), _mm_slli_epi32(index, 30));
+            const __m128i pack1 = _mm_or_si128(c, _mm_slli_epi32(signal, 15));
+
+            // Each quaternion takes two consecutive entries, so interleave the two packs
+            _mm_storeu_si128((__m128i*)(out + (i * 2)), _mm_unpacklo_epi32(pack0, pack1));
+            _mm_storeu_si128((__m128i*)(out + (i * 2) + 4), _mm_unpackhi_epi32(pack0, pack1));
+         } break;
+      }
+   }
+
+   return simd_count;
+}
+#endif   //QUANTIZE_X86_SIMD
+
+
+
 
 void Quantize::_bind_methods()
 {
@@ -58,6 +378,13 @@ void Quantize::_bind_methods()
    ClassDB::bind_static_method("Quantize", D_METHOD("quantize_float", "value", "minval", "maxval", "numbits"), &Quantize::quantize_float);
    ClassDB::bind_static_method("Quantize", D_METHOD("restore_float", "quantized", "minval", "maxval", "numbits"), &Quantize::restore_float);
 
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_unit_float_array", "values", "numbits"), &Quantize::quantize_unit_float_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_unit_float_array", "quantized", "numbits"), &Quantize::restore_unit_float_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_float_array", "values", "minval", "maxval", "numbits"), &Quantize::quantize_float_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_float_array", "quantized", "minval", "maxval", "numbits"), &Quantize::restore_float_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_float64_array", "values", "minval", "maxval", "numbits"), &Quantize::quantize_float64_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_float64_array", "quantized", "minval", "maxval", "numbits"), &Quantize::restore_float64_array);
+
    ClassDB::bind_static_method("Quantize", D_METHOD("compress_rotation_quat", "unit_quat", "numbits"), &Quantize::_compress_rotation_quaternion);
    ClassDB::bind_static_method("Quantize", D_METHOD("restore_rotation_quat", "quant", "numbits"), &Quantize::_restore_rotation_quaternion);
 
@@ -69,6 +396,23 @@ void Quantize::_bind_methods()
 
    ClassDB::bind_static_method("Quantize", D_METHOD("compress_rquat_15bits", "q"), &Quantize::compress_rquat_15bits);
    ClassDB::bind_static_method("Quantize", D_METHOD("restore_rquat_15bits", "pack0", "pack1"), &Quantize::_restore_rquat_15bits);
+
+   ClassDB::bind_static_method("Quantize", D_METHOD("compress_rquat_9bits_array", "xyzw"), &Quantize::compress_rquat_9bits_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_rquat_9bits_array", "compressed"), &Quantize::restore_rquat_9bits_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("compress_rquat_10bits_array", "xyzw"), &Quantize::compress_rquat_10bits_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_rquat_10bits_array", "compressed"), &Quantize::restore_rquat_10bits_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("compress_rquat_15bits_array", "xyzw"), &Quantize::compress_rquat_15bits_array);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_rquat_15bits_array", "compressed"), &Quantize::restore_rquat_15bits_array);
+
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_vector2", "v", "minval", "maxval", "numbits"), &Quantize::quantize_vector2);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_vector2", "quantized", "minval", "maxval", "numbits"), &Quantize::restore_vector2);
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_vector3", "v", "minval", "maxval", "numbits"), &Quantize::quantize_vector3);
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_vector3", "quantized", "minval", "maxval", "numbits"), &Quantize::restore_vector3);
+
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_transform2d", "t", "minpos", "maxpos", "pos_bits", "rot_bits", "minscale", "maxscale", "scale_bits"), &Quantize::quantize_transform2d, DEFVAL(Vector2(1, 1)), DEFVAL(Vector2(1, 1)), DEFVAL(Vector2i(0, 0)));
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_transform2d", "quantized", "minpos", "maxpos", "pos_bits", "rot_bits", "minscale", "maxscale", "scale_bits"), &Quantize::restore_transform2d, DEFVAL(Vector2(1, 1)), DEFVAL(Vector2(1, 1)), DEFVAL(Vector2i(0, 0)));
+   ClassDB::bind_static_method("Quantize", D_METHOD("quantize_transform3d", "t", "minpos", "maxpos", "pos_bits", "rot_bits", "minscale", "maxscale", "scale_bits"), &Quantize::quantize_transform3d, DEFVAL(Vector3(1, 1, 1)), DEFVAL(Vector3(1, 1, 1)), DEFVAL(Vector3i(0, 0, 0)));
+   ClassDB::bind_static_method("Quantize", D_METHOD("restore_transform3d", "quantized", "minpos", "maxpos", "pos_bits", "rot_bits", "minscale", "maxscale", "scale_bits"), &Quantize::restore_transform3d, DEFVAL(Vector3(1, 1, 1)), DEFVAL(Vector3(1, 1, 1)), DEFVAL(Vector3i(0, 0, 0)));
 }
 
 
@@ -76,24 +420,22 @@ uint32_t Quantize::quantize_unit_float(double value, int num_bits)
 {
    ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, -1, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
 
-   uint32_t intervals = 1 << num_bits;
-   double scaled = value * (intervals - 1.0f);
-   uint32_t rounded = (uint32_t)(scaled + 0.5f);
-
-   if (rounded > intervals - 1)
+   switch (num_bits)
    {
-      rounded -= 1;
+      #define QUANTIZE_UNIT_CASE(b) case b: return quantize_unit_float_t<b>(value);
+      QUANTIZE_SPECIALIZED_BITS(QUANTIZE_UNIT_CASE)
+      #undef QUANTIZE_UNIT_CASE
    }
 
-   return rounded;
+   return quantize_unit_float_impl(value, max_quantized(num_bits), quantize_scale(num_bits));
 }
 
 double Quantize::restore_unit_float(uint32_t quantized, int num_bits)
 {
-   uint32_t intervals = 1 << num_bits;
-   double interval_size = 1.0f / (double)(intervals - 1.0f);
-   double approx_float = (double)quantized * interval_size;
-   return approx_float;
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, 0.0, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   // The table lookup is already as cheap as the specialized versions, so no dispatching here
+   return restore_unit_float_impl(quantized, s_interval_size.value[num_bits]);
 }
 
 
@@ -114,45 +456,106 @@ double Quantize::restore_float(uint32_t quantized, double minval, double maxval,
 }
 
 
-// NOTE: this assumes the incoming quaternion is a rotation one, which means it's a unit quaternion (length = 1).
-Quantize::uquat_data Quantize::compress_rotation_quaternion(const godot::Quaternion& q, int num_bits)
+void Quantize::quantize_float_batch(const float* values, uint32_t* out, int64_t count, double minval, double maxval, int num_bits)
 {
-   // Since it's not possible to iterate through the quaternion components through a loop, creating
-   // this temporary array.
-   double comps[4] = { q.x, q.y, q.z, q.w };
-   uint32_t quant[3];           // Will hold the three quantized components
-   int mindex = 0;              // Index of the largest component
-   double mval = -1.0f;          // Value of the largest component
-   double sig = 1.0f;            // Signal of the dropped component. Assume it's positive.
+   quantize_batch_kernel<float>(values, out, count, minval, maxval, num_bits);
+}
 
-   // Locate the largest component, storing its absolute value as well as the index
-   for (int i = 0; i < 4; i++)
-   {
-      double abval = godot::Math::abs<double>(comps[i]);
+void Quantize::quantize_float_batch(const double* values, uint32_t* out, int64_t count, double minval, double maxval, int num_bits)
+{
+   quantize_batch_kernel<double>(values, out, count, minval, maxval, num_bits);
+}
 
-      if (abval > mval)
-      {
-         mval = abval;
-         mindex = i;
-      }
-   }
+void Quantize::restore_float_batch(const uint32_t* quantized, float* out, int64_t count, double minval, double maxval, int num_bits)
+{
+   restore_batch_kernel<float>(quantized, out, count, minval, maxval, num_bits);
+}
 
-   if (comps[mindex] < 0.0f)
-   {
-      sig = -1.0f;
-   }
+void Quantize::restore_float_batch(const uint32_t* quantized, double* out, int64_t count, double minval, double maxval, int num_bits)
+{
+   restore_batch_kernel<double>(quantized, out, count, minval, maxval, num_bits);
+}
+
+
+godot::PackedInt32Array Quantize::quantize_unit_float_array(const godot::PackedFloat32Array& values, int num_bits)
+{
+   return quantize_float_array(values, 0.0, 1.0, num_bits);
+}
+
+godot::PackedFloat32Array Quantize::restore_unit_float_array(const godot::PackedInt32Array& quantized, int num_bits)
+{
+   return restore_float_array(quantized, 0.0, 1.0, num_bits);
+}
+
+
+godot::PackedInt32Array Quantize::quantize_float_array(const godot::PackedFloat32Array& values, double minval, double maxval, int num_bits)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, ret, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   const int64_t count = values.size();
+   ret.resize(count);
+
+   // Packed arrays hold signed integers, but the bit pattern is what matters here
+   quantize_float_batch(values.ptr(), (uint32_t*)ret.ptrw(), count, minval, maxval, num_bits);
+
+   return ret;
+}
+
+godot::PackedFloat32Array Quantize::restore_float_array(const godot::PackedInt32Array& quantized, double minval, double maxval, int num_bits)
+{
+   godot::PackedFloat32Array ret;
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, ret, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   const int64_t count = quantized.size();
+   ret.resize(count);
+
+   restore_float_batch((const uint32_t*)quantized.ptr(), ret.ptrw(), count, minval, maxval, num_bits);
+
+   return ret;
+}
+
+
+godot::PackedInt32Array Quantize::quantize_float64_array(const godot::PackedFloat64Array& values, double minval, double maxval, int num_bits)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, ret, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   const int64_t count = values.size();
+   ret.resize(count);
+
+   quantize_float_batch(values.ptr(), (uint32_t*)ret.ptrw(), count, minval, maxval, num_bits);
 
-   // Quantize the smallest components
-   for (int i = 0, c = 0; i < 4; i++)
+   return ret;
+}
+
+godot::PackedFloat64Array Quantize::restore_float64_array(const godot::PackedInt32Array& quantized, double minval, double maxval, int num_bits)
+{
+   godot::PackedFloat64Array ret;
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, ret, godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   const int64_t count = quantized.size();
+   ret.resize(count);
+
+   restore_float_batch((const uint32_t*)quantized.ptr(), ret.ptrw(), count, minval, maxval, num_bits);
+
+   return ret;
+}
+
+
+// NOTE: this assumes the incoming quaternion is a rotation one, which means it's a unit quaternion (length = 1).
+Quantize::uquat_data Quantize::compress_rotation_quaternion(const godot::Quaternion& q, int num_bits)
+{
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, uquat_data(), godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
+
+   switch (num_bits)
    {
-      if (i != mindex)
-      {
-         double fl = comps[i] * sig;
-         quant[c++] = quantize_float(fl, -ROTATION_BOUNDS, ROTATION_BOUNDS, num_bits);
-      }
+      #define COMPRESS_ROTATION_CASE(b) case b: return compress_rotation_quaternion_t<b>(q);
+      QUANTIZE_SPECIALIZED_BITS(COMPRESS_ROTATION_CASE)
+      #undef COMPRESS_ROTATION_CASE
    }
 
-   return uquat_data(quant[0], quant[1], quant[2], mindex, sig == 1.0f ? 1 : 0);
+   return compress_rotation_impl(q, max_quantized(num_bits), quantize_scale(num_bits));
 }
 
 
@@ -175,43 +578,16 @@ godot::Dictionary Quantize::_compress_rotation_quaternion(const godot::Quaternio
 
 godot::Quaternion Quantize::restore_rotation_quaternion(const Quantize::uquat_data& quant, int num_bits)
 {
-   // Take signal from 0=negative|1=positive (easier bit packing) to -1,+1 for easier multiplication
-   double sig = quant.signal == 1 ? 1.0f : -1.0f;
-
-   // Restore the three smallest components (a, b and c)
-   double ra = restore_float(quant.a, -ROTATION_BOUNDS, ROTATION_BOUNDS, num_bits) * sig;
-   double rb = restore_float(quant.b, -ROTATION_BOUNDS, ROTATION_BOUNDS, num_bits) * sig;
-   double rc = restore_float(quant.c, -ROTATION_BOUNDS, ROTATION_BOUNDS, num_bits) * sig;
-   // Restore the dropped component
-   double dropped = sqrtf(1.0f - ra*ra - rb*rb - rc*rc) * sig;
-
-   godot::Quaternion ret = godot::Quaternion();
+   ERR_FAIL_COND_V_MSG(num_bits < 2 || num_bits > 32, godot::Quaternion(), godot::vformat("Number of bits must be between 2 and 32, but %s has been given", num_bits));
 
-   switch (quant.index)
+   switch (num_bits)
    {
-      case 0:
-         // X was dropped
-         ret = godot::Quaternion(dropped, ra, rb, rc);
-         break;
-      
-      case 1:
-         // Y was dropped
-         ret = godot::Quaternion(ra, dropped, rb, rc);
-         break;
-      
-      case 2:
-         // Z was dropped
-         ret = godot::Quaternion(ra, rb, dropped, rc);
-         break;
-      
-      case 3:
-         // W was dropped
-         ret = godot::Quaternion(ra, rb, rc, dropped);
-         break;
+      #define RESTORE_ROTATION_CASE(b) case b: return restore_rotation_quaternion_t<b>(quant);
+      QUANTIZE_SPECIALIZED_BITS(RESTORE_ROTATION_CASE)
+      #undef RESTORE_ROTATION_CASE
    }
 
-
-   return ret;
+   return restore_rotation_impl(quant, s_interval_size.value[num_bits]);
 }
 
 
@@ -231,11 +607,8 @@ godot::Quaternion Quantize::_restore_rotation_quaternion(const godot::Dictionary
 
 
 
-uint32_t Quantize::compress_rquat_9bits(const godot::Quaternion& q)
+uint32_t Quantize::pack_rquat_9bits(const uquat_data& comp)
 {
-   // First compress normally
-   uquat_data comp = compress_rotation_quaternion(q, 9);
-   // Then pack the data
    return (((comp.signal << 30) & MASK_SIGNAL_9BIT) |
            ((comp.index << 27) & MASK_INDEX_9BIT) |
            ((comp.c << 18) & MASK_C_9BIT) |
@@ -243,67 +616,477 @@ uint32_t Quantize::compress_rquat_9bits(const godot::Quaternion& q)
            (comp.a & MASK_A_9BIT));
 }
 
-godot::Quaternion Quantize::restore_rquat_9bits(uint32_t compressed)
+Quantize::uquat_data Quantize::unpack_rquat_9bits(uint32_t compressed)
 {
-   // To restore, must use dictionary, so create it
-   uquat_data unpacked(
+   return uquat_data(
       compressed & MASK_A_9BIT,
       (compressed & MASK_B_9BIT) >> 9,
       (compressed & MASK_C_9BIT) >> 18,
       (compressed & MASK_INDEX_9BIT) >> 27,
       (compressed & MASK_SIGNAL_9BIT) >> 30);
-
-   return restore_rotation_quaternion(unpacked, 9);
 }
 
 
-uint32_t Quantize::compress_rquat_10bits(const godot::Quaternion& q)
+uint32_t Quantize::pack_rquat_10bits(const uquat_data& comp)
 {
-   uquat_data comp = compress_rotation_quaternion(q, 10);
    return (((comp.index << 30) & MASK_INDEX_10BIT) |
            ((comp.c << 20) & MASK_C_10BIT) |
            ((comp.b << 10) & MASK_B_10BIT) |
            (comp.a & MASK_A_10BIT));
 }
 
-godot::Quaternion Quantize::restore_rquat_10bits(uint32_t compressed)
+Quantize::uquat_data Quantize::unpack_rquat_10bits(uint32_t compressed)
 {
-   uquat_data unpacked(
+   return uquat_data(
       compressed & MASK_A_10BIT,
       (compressed & MASK_B_10BIT) >> 10,
       (compressed & MASK_C_10BIT) >> 20,
       (compressed & MASK_INDEX_10BIT) >> 30);
+}
+
+
+void Quantize::pack_rquat_15bits(const uquat_data& comp, uint32_t& out_pack0, uint16_t& out_pack1)
+{
+   out_pack0 = ((comp.index << 30) & MASK_INDEX_15BIT) |
+               ((comp.b << 15) & MASK_B_15BIT) |
+               (comp.a & MASK_A_15BIT);
+
+   out_pack1 = ((comp.signal << 15) & MASK_SIGNAL_15BIT) | (comp.c & MASK_C_15BIT);
+}
+
+Quantize::uquat_data Quantize::unpack_rquat_15bits(uint32_t pack0, uint16_t pack1)
+{
+   return uquat_data(
+      pack0 & MASK_A_15BIT,
+      (pack0 & MASK_B_15BIT) >> 15,
+      pack1 & MASK_C_15BIT,
+      (pack0 & MASK_INDEX_15BIT) >> 30,
+      (pack1 & MASK_SIGNAL_15BIT) >> 15);
+}
+
+
+
+uint32_t Quantize::compress_rquat_9bits(const godot::Quaternion& q)
+{
+   // First compress normally then pack the data
+   return pack_rquat_9bits(compress_rotation_quaternion_t<9>(q));
+}
 
-   return restore_rotation_quaternion(unpacked, 10);
+godot::Quaternion Quantize::restore_rquat_9bits(uint32_t compressed)
+{
+   return restore_rotation_quaternion_t<9>(unpack_rquat_9bits(compressed));
+}
+
+
+uint32_t Quantize::compress_rquat_10bits(const godot::Quaternion& q)
+{
+   return pack_rquat_10bits(compress_rotation_quaternion_t<10>(q));
+}
+
+godot::Quaternion Quantize::restore_rquat_10bits(uint32_t compressed)
+{
+   return restore_rotation_quaternion_t<10>(unpack_rquat_10bits(compressed));
 }
 
 
 godot::PackedInt32Array Quantize::compress_rquat_15bits(const godot::Quaternion& q)
 {
-   // Obtain the compressed data
-   Quantize::uquat_data c = compress_rotation_quaternion(q, 15);
+   uint32_t pack0;
+   uint16_t pack1;
+   compress_rquat_15bits_into(q, pack0, pack1);
 
    godot::PackedInt32Array ret;
-   ret.append(((c.index << 30) & MASK_INDEX_15BIT) |
-              ((c.b << 15) & MASK_B_15BIT) |
-              (c.a & MASK_A_15BIT));
-   
-   ret.append(((c.signal << 15) & MASK_SIGNAL_15BIT) | (c.c & MASK_C_15BIT));
+   ret.append(pack0);
+   ret.append(pack1);
 
    return ret;
 }
 
 
+void Quantize::compress_rquat_15bits_into(const godot::Quaternion& q, uint32_t& out_pack0, uint16_t& out_pack1)
+{
+   pack_rquat_15bits(compress_rotation_quaternion_t<15>(q), out_pack0, out_pack1);
+}
+
+
 godot::Quaternion Quantize::restore_rquat_15bits(uint32_t pack0, uint16_t pack1)
 {
-   uquat_data unpacked(
-      pack0 & MASK_A_15BIT,
-      (pack0 & MASK_B_15BIT) >> 15,
-      pack1 & MASK_C_15BIT,
-      (pack0 & MASK_INDEX_15BIT) >> 30,
-      (pack1 & MASK_SIGNAL_15BIT) >> 15);
+   return restore_rotation_quaternion_t<15>(unpack_rquat_15bits(pack0, pack1));
+}
+
+
+
+void Quantize::compress_rquat_9bits_batch(const float* xyzw, uint32_t* out, int64_t count)
+{
+   int64_t i = 0;
+#ifdef QUANTIZE_X86_SIMD
+   if (has_avx())
+   {
+      i = compress_rquat_batch_avx(xyzw, out, count, ROTATION_BOUNDS, 9);
+   }
+#endif
+
+   for (; i < count; i++)
+   {
+      const float* c = xyzw + (i * 4);
+      out[i] = pack_rquat_9bits(compress_rotation_quaternion_t<9>(godot::Quaternion(c[0], c[1], c[2], c[3])));
+   }
+}
+
+void Quantize::compress_rquat_10bits_batch(const float* xyzw, uint32_t* out, int64_t count)
+{
+   int64_t i = 0;
+#ifdef QUANTIZE_X86_SIMD
+   if (has_avx())
+   {
+      i = compress_rquat_batch_avx(xyzw, out, count, ROTATION_BOUNDS, 10);
+   }
+#endif
+
+   for (; i < count; i++)
+   {
+      const float* c = xyzw + (i * 4);
+      out[i] = pack_rquat_10bits(compress_rotation_quaternion_t<10>(godot::Quaternion(c[0], c[1], c[2], c[3])));
+   }
+}
+
+void Quantize::compress_rquat_15bits_batch(const float* xyzw, uint32_t* out, int64_t count)
+{
+   int64_t i = 0;
+#ifdef QUANTIZE_X86_SIMD
+   if (has_avx())
+   {
+      i = compress_rquat_batch_avx(xyzw, out, count, ROTATION_BOUNDS, 15);
+   }
+#endif
+
+   for (; i < count; i++)
+   {
+      const float* c = xyzw + (i * 4);
+      uint16_t pack1;
+      pack_rquat_15bits(compress_rotation_quaternion_t<15>(godot::Quaternion(c[0], c[1], c[2], c[3])), out[i * 2], pack1);
+      out[i * 2 + 1] = pack1;
+   }
+}
+
+
+// Just to avoid repeating the same four lines on each of the restore batch functions
+static inline void write_quat(const godot::Quaternion& q, float* out)
+{
+   out[0] = q.x;
+   out[1] = q.y;
+   out[2] = q.z;
+   out[3] = q.w;
+}
+
+void Quantize::restore_rquat_9bits_batch(const uint32_t* compressed, float* out_xyzw, int64_t count)
+{
+   for (int64_t i = 0; i < count; i++)
+   {
+      write_quat(restore_rotation_quaternion_t<9>(unpack_rquat_9bits(compressed[i])), out_xyzw + (i * 4));
+   }
+}
+
+void Quantize::restore_rquat_10bits_batch(const uint32_t* compressed, float* out_xyzw, int64_t count)
+{
+   for (int64_t i = 0; i < count; i++)
+   {
+      write_quat(restore_rotation_quaternion_t<10>(unpack_rquat_10bits(compressed[i])), out_xyzw + (i * 4));
+   }
+}
+
+void Quantize::restore_rquat_15bits_batch(const uint32_t* compressed, float* out_xyzw, int64_t count)
+{
+   for (int64_t i = 0; i < count; i++)
+   {
+      const uquat_data unpacked = unpack_rquat_15bits(compressed[i * 2], (uint16_t)compressed[i * 2 + 1]);
+      write_quat(restore_rotation_quaternion_t<15>(unpacked), out_xyzw + (i * 4));
+   }
+}
+
+
+
+godot::PackedInt32Array Quantize::compress_rquat_9bits_array(const godot::PackedFloat32Array& xyzw)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(xyzw.size() % 4 != 0, ret, godot::vformat("Expected 4 floats per quaternion, but the array size (%s) is not a multiple of 4", xyzw.size()));
+
+   const int64_t count = xyzw.size() / 4;
+   ret.resize(count);
+
+   compress_rquat_9bits_batch(xyzw.ptr(), (uint32_t*)ret.ptrw(), count);
+
+   return ret;
+}
+
+godot::PackedFloat32Array Quantize::restore_rquat_9bits_array(const godot::PackedInt32Array& compressed)
+{
+   godot::PackedFloat32Array ret;
+
+   const int64_t count = compressed.size();
+   ret.resize(count * 4);
+
+   restore_rquat_9bits_batch((const uint32_t*)compressed.ptr(), ret.ptrw(), count);
+
+   return ret;
+}
+
+
+godot::PackedInt32Array Quantize::compress_rquat_10bits_array(const godot::PackedFloat32Array& xyzw)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(xyzw.size() % 4 != 0, ret, godot::vformat("Expected 4 floats per quaternion, but the array size (%s) is not a multiple of 4", xyzw.size()));
+
+   const int64_t count = xyzw.size() / 4;
+   ret.resize(count);
+
+   compress_rquat_10bits_batch(xyzw.ptr(), (uint32_t*)ret.ptrw(), count);
+
+   return ret;
+}
+
+godot::PackedFloat32Array Quantize::restore_rquat_10bits_array(const godot::PackedInt32Array& compressed)
+{
+   godot::PackedFloat32Array ret;
+
+   const int64_t count = compressed.size();
+   ret.resize(count * 4);
+
+   restore_rquat_10bits_batch((const uint32_t*)compressed.ptr(), ret.ptrw(), count);
+
+   return ret;
+}
+
+
+godot::PackedInt32Array Quantize::compress_rquat_15bits_array(const godot::PackedFloat32Array& xyzw)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(xyzw.size() % 4 != 0, ret, godot::vformat("Expected 4 floats per quaternion, but the array size (%s) is not a multiple of 4", xyzw.size()));
+
+   const int64_t count = xyzw.size() / 4;
+   ret.resize(count * 2);
+
+   compress_rquat_15bits_batch(xyzw.ptr(), (uint32_t*)ret.ptrw(), count);
+
+   return ret;
+}
+
+godot::PackedFloat32Array Quantize::restore_rquat_15bits_array(const godot::PackedInt32Array& compressed)
+{
+   godot::PackedFloat32Array ret;
+   ERR_FAIL_COND_V_MSG(compressed.size() % 2 != 0, ret, godot::vformat("Expected 2 integers per quaternion, but the array size (%s) is odd", compressed.size()));
+
+   const int64_t count = compressed.size() / 2;
+   ret.resize(count * 4);
+
+   restore_rquat_15bits_batch((const uint32_t*)compressed.ptr(), ret.ptrw(), count);
+
+   return ret;
+}
+
+
+godot::PackedInt32Array Quantize::quantize_vector2(const godot::Vector2& v, const godot::Vector2& minval, const godot::Vector2& maxval, const godot::Vector2i& num_bits)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(num_bits.x) || !is_valid_axis_bits(num_bits.y), ret, godot::vformat("Number of bits of each axis must be 0 or between 2 and 32, but %s has been given", num_bits));
+
+   uint32_t words[MAX_PACKED_WORDS] = { 0 };
+   int64_t bit_pos = 0;
+
+   write_axis(words, bit_pos, v.x, minval.x, maxval.x, num_bits.x);
+   write_axis(words, bit_pos, v.y, minval.y, maxval.y, num_bits.y);
+
+   ret.resize((bit_pos + 31) >> 5);
+   for (int64_t i = 0; i < ret.size(); i++)
+   {
+      ret.set(i, words[i]);
+   }
+
+   return ret;
+}
+
+godot::Vector2 Quantize::restore_vector2(const godot::PackedInt32Array& quantized, const godot::Vector2& minval, const godot::Vector2& maxval, const godot::Vector2i& num_bits)
+{
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(num_bits.x) || !is_valid_axis_bits(num_bits.y), minval, godot::vformat("Number of bits of each axis must be 0 or between 2 and 32, but %s has been given", num_bits));
+   const int total_bits = num_bits.x + num_bits.y;
+   ERR_FAIL_COND_V_MSG(quantized.size() < ((total_bits + 31) >> 5), minval, godot::vformat("Quantized data should hold %s bits but only %s integers were given", total_bits, quantized.size()));
+
+   const uint32_t* words = (const uint32_t*)quantized.ptr();
+   int64_t bit_pos = 0;
+
+   godot::Vector2 ret;
+   ret.x = read_axis(words, bit_pos, minval.x, maxval.x, num_bits.x);
+   ret.y = read_axis(words, bit_pos, minval.y, maxval.y, num_bits.y);
+
+   return ret;
+}
+
+
+godot::PackedInt32Array Quantize::quantize_vector3(const godot::Vector3& v, const godot::Vector3& minval, const godot::Vector3& maxval, const godot::Vector3i& num_bits)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(num_bits.x) || !is_valid_axis_bits(num_bits.y) || !is_valid_axis_bits(num_bits.z), ret, godot::vformat("Number of bits of each axis must be 0 or between 2 and 32, but %s has been given", num_bits));
+
+   uint32_t words[MAX_PACKED_WORDS] = { 0 };
+   int64_t bit_pos = 0;
+
+   write_axis(words, bit_pos, v.x, minval.x, maxval.x, num_bits.x);
+   write_axis(words, bit_pos, v.y, minval.y, maxval.y, num_bits.y);
+   write_axis(words, bit_pos, v.z, minval.z, maxval.z, num_bits.z);
+
+   ret.resize((bit_pos + 31) >> 5);
+   for (int64_t i = 0; i < ret.size(); i++)
+   {
+      ret.set(i, words[i]);
+   }
+
+   return ret;
+}
+
+godot::Vector3 Quantize::restore_vector3(const godot::PackedInt32Array& quantized, const godot::Vector3& minval, const godot::Vector3& maxval, const godot::Vector3i& num_bits)
+{
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(num_bits.x) || !is_valid_axis_bits(num_bits.y) || !is_valid_axis_bits(num_bits.z), minval, godot::vformat("Number of bits of each axis must be 0 or between 2 and 32, but %s has been given", num_bits));
+   const int total_bits = num_bits.x + num_bits.y + num_bits.z;
+   ERR_FAIL_COND_V_MSG(quantized.size() < ((total_bits + 31) >> 5), minval, godot::vformat("Quantized data should hold %s bits but only %s integers were given", total_bits, quantized.size()));
+
+   const uint32_t* words = (const uint32_t*)quantized.ptr();
+   int64_t bit_pos = 0;
+
+   godot::Vector3 ret;
+   ret.x = read_axis(words, bit_pos, minval.x, maxval.x, num_bits.x);
+   ret.y = read_axis(words, bit_pos, minval.y, maxval.y, num_bits.y);
+   ret.z = read_axis(words, bit_pos, minval.z, maxval.z, num_bits.z);
+
+   return ret;
+}
+
+
+godot::PackedInt32Array Quantize::quantize_transform2d(const godot::Transform2D& t, const godot::Vector2& minpos, const godot::Vector2& maxpos, const godot::Vector2i& pos_bits, int rot_bits, const godot::Vector2& minscale, const godot::Vector2& maxscale, const godot::Vector2i& scale_bits)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(pos_bits.x) || !is_valid_axis_bits(pos_bits.y), ret, godot::vformat("Number of bits of each position axis must be 0 or between 2 and 32, but %s has been given", pos_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(rot_bits), ret, godot::vformat("Number of rotation bits must be 0 or between 2 and 32, but %s has been given", rot_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(scale_bits.x) || !is_valid_axis_bits(scale_bits.y), ret, godot::vformat("Number of bits of each scale axis must be 0 or between 2 and 32, but %s has been given", scale_bits));
+
+   uint32_t words[MAX_PACKED_WORDS] = { 0 };
+   int64_t bit_pos = 0;
+
+   const godot::Vector2 pos = t.get_origin();
+   write_axis(words, bit_pos, pos.x, minpos.x, maxpos.x, pos_bits.x);
+   write_axis(words, bit_pos, pos.y, minpos.y, maxpos.y, pos_bits.y);
+
+   write_axis(words, bit_pos, t.get_rotation(), -Math_PI, Math_PI, rot_bits);
+
+   const godot::Vector2 scale = t.get_scale();
+   write_axis(words, bit_pos, scale.x, minscale.x, maxscale.x, scale_bits.x);
+   write_axis(words, bit_pos, scale.y, minscale.y, maxscale.y, scale_bits.y);
+
+   ret.resize((bit_pos + 31) >> 5);
+   for (int64_t i = 0; i < ret.size(); i++)
+   {
+      ret.set(i, words[i]);
+   }
+
+   return ret;
+}
+
+godot::Transform2D Quantize::restore_transform2d(const godot::PackedInt32Array& quantized, const godot::Vector2& minpos, const godot::Vector2& maxpos, const godot::Vector2i& pos_bits, int rot_bits, const godot::Vector2& minscale, const godot::Vector2& maxscale, const godot::Vector2i& scale_bits)
+{
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(pos_bits.x) || !is_valid_axis_bits(pos_bits.y), godot::Transform2D(), godot::vformat("Number of bits of each position axis must be 0 or between 2 and 32, but %s has been given", pos_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(rot_bits), godot::Transform2D(), godot::vformat("Number of rotation bits must be 0 or between 2 and 32, but %s has been given", rot_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(scale_bits.x) || !is_valid_axis_bits(scale_bits.y), godot::Transform2D(), godot::vformat("Number of bits of each scale axis must be 0 or between 2 and 32, but %s has been given", scale_bits));
+   const int total_bits = pos_bits.x + pos_bits.y + rot_bits + scale_bits.x + scale_bits.y;
+   ERR_FAIL_COND_V_MSG(quantized.size() < ((total_bits + 31) >> 5), godot::Transform2D(), godot::vformat("Quantized data should hold %s bits but only %s integers were given", total_bits, quantized.size()));
+
+   const uint32_t* words = (const uint32_t*)quantized.ptr();
+   int64_t bit_pos = 0;
+
+   godot::Vector2 pos;
+   pos.x = read_axis(words, bit_pos, minpos.x, maxpos.x, pos_bits.x);
+   pos.y = read_axis(words, bit_pos, minpos.y, maxpos.y, pos_bits.y);
+
+   // When not encoded, read_axis() returns the minval, which would be -PI here
+   const double rotation = rot_bits > 0 ? read_axis(words, bit_pos, -Math_PI, Math_PI, rot_bits) : 0.0;
+
+   godot::Vector2 scale;
+   scale.x = read_axis(words, bit_pos, minscale.x, maxscale.x, scale_bits.x);
+   scale.y = read_axis(words, bit_pos, minscale.y, maxscale.y, scale_bits.y);
+
+   return godot::Transform2D(rotation, scale, 0.0, pos);
+}
+
+
+godot::PackedInt32Array Quantize::quantize_transform3d(const godot::Transform3D& t, const godot::Vector3& minpos, const godot::Vector3& maxpos, const godot::Vector3i& pos_bits, int rot_bits, const godot::Vector3& minscale, const godot::Vector3& maxscale, const godot::Vector3i& scale_bits)
+{
+   godot::PackedInt32Array ret;
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(pos_bits.x) || !is_valid_axis_bits(pos_bits.y) || !is_valid_axis_bits(pos_bits.z), ret, godot::vformat("Number of bits of each position axis must be 0 or between 2 and 32, but %s has been given", pos_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(rot_bits), ret, godot::vformat("Number of rotation bits must be 0 or between 2 and 32, but %s has been given", rot_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(scale_bits.x) || !is_valid_axis_bits(scale_bits.y) || !is_valid_axis_bits(scale_bits.z), ret, godot::vformat("Number of bits of each scale axis must be 0 or between 2 and 32, but %s has been given", scale_bits));
+
+   uint32_t words[MAX_PACKED_WORDS] = { 0 };
+   int64_t bit_pos = 0;
+
+   const godot::Vector3 pos = t.get_origin();
+   write_axis(words, bit_pos, pos.x, minpos.x, maxpos.x, pos_bits.x);
+   write_axis(words, bit_pos, pos.y, minpos.y, maxpos.y, pos_bits.y);
+   write_axis(words, bit_pos, pos.z, minpos.z, maxpos.z, pos_bits.z);
+
+   if (rot_bits > 0)
+   {
+      const uquat_data rot = compress_rotation_quaternion(t.get_basis().get_rotation_quaternion(), rot_bits);
+      write_packed_bits(words, bit_pos, rot.a, rot_bits);
+      write_packed_bits(words, bit_pos, rot.b, rot_bits);
+      write_packed_bits(words, bit_pos, rot.c, rot_bits);
+      write_packed_bits(words, bit_pos, rot.index, 2);
+   }
+
+   const godot::Vector3 scale = t.get_basis().get_scale();
+   write_axis(words, bit_pos, scale.x, minscale.x, maxscale.x, scale_bits.x);
+   write_axis(words, bit_pos, scale.y, minscale.y, maxscale.y, scale_bits.y);
+   write_axis(words, bit_pos, scale.z, minscale.z, maxscale.z, scale_bits.z);
+
+   ret.resize((bit_pos + 31) >> 5);
+   for (int64_t i = 0; i < ret.size(); i++)
+   {
+      ret.set(i, words[i]);
+   }
+
+   return ret;
+}
+
+godot::Transform3D Quantize::restore_transform3d(const godot::PackedInt32Array& quantized, const godot::Vector3& minpos, const godot::Vector3& maxpos, const godot::Vector3i& pos_bits, int rot_bits, const godot::Vector3& minscale, const godot::Vector3& maxscale, const godot::Vector3i& scale_bits)
+{
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(pos_bits.x) || !is_valid_axis_bits(pos_bits.y) || !is_valid_axis_bits(pos_bits.z), godot::Transform3D(), godot::vformat("Number of bits of each position axis must be 0 or between 2 and 32, but %s has been given", pos_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(rot_bits), godot::Transform3D(), godot::vformat("Number of rotation bits must be 0 or between 2 and 32, but %s has been given", rot_bits));
+   ERR_FAIL_COND_V_MSG(!is_valid_axis_bits(scale_bits.x) || !is_valid_axis_bits(scale_bits.y) || !is_valid_axis_bits(scale_bits.z), godot::Transform3D(), godot::vformat("Number of bits of each scale axis must be 0 or between 2 and 32, but %s has been given", scale_bits));
+   const int total_bits = pos_bits.x + pos_bits.y + pos_bits.z + (rot_bits > 0 ? rot_bits * 3 + 2 : 0) + scale_bits.x + scale_bits.y + scale_bits.z;
+   ERR_FAIL_COND_V_MSG(quantized.size() < ((total_bits + 31) >> 5), godot::Transform3D(), godot::vformat("Quantized data should hold %s bits but only %s integers were given", total_bits, quantized.size()));
+
+   const uint32_t* words = (const uint32_t*)quantized.ptr();
+   int64_t bit_pos = 0;
+
+   godot::Vector3 pos;
+   pos.x = read_axis(words, bit_pos, minpos.x, maxpos.x, pos_bits.x);
+   pos.y = read_axis(words, bit_pos, minpos.y, maxpos.y, pos_bits.y);
+   pos.z = read_axis(words, bit_pos, minpos.z, maxpos.z, pos_bits.z);
+
+   godot::Quaternion rotation;
+   if (rot_bits > 0)
+   {
+      uquat_data rot;
+      rot.a = read_packed_bits(words, bit_pos, rot_bits);
+      rot.b = read_packed_bits(words, bit_pos, rot_bits);
+      rot.c = read_packed_bits(words, bit_pos, rot_bits);
+      rot.index = read_packed_bits(words, bit_pos, 2);
+      rotation = restore_rotation_quaternion(rot, rot_bits);
+   }
+
+   godot::Vector3 scale;
+   scale.x = read_axis(words, bit_pos, minscale.x, maxscale.x, scale_bits.x);
+   scale.y = read_axis(words, bit_pos, minscale.y, maxscale.y, scale_bits.y);
+   scale.z = read_axis(words, bit_pos, minscale.z, maxscale.z, scale_bits.z);
 
-   return restore_rotation_quaternion(unpacked, 15);
+   return godot::Transform3D(godot::Basis(rotation, scale), pos);
 }
 
 
@@ -34,8 +34,9 @@ class Quantize : public godot::RefCounted
 {
    GDCLASS(Quantize, godot::RefCounted);
 private:
-   // Define the "boundaries" used to quantize rotation quaternions
-   const static double ROTATION_BOUNDS;
+   // Define the "boundaries" used to quantize rotation quaternions. Constant expression so the compile time specialized
+   // functions can fold it
+   static constexpr double ROTATION_BOUNDS = 0.707107;
 
    /// Some masks used to help pack/unpack quantized rotation quaternions into/from integers
    // First is meant to pack things as 9 bits per component
@@ -86,6 +87,104 @@ public:
          a(other.a), b(other.b), c(other.c), index(other.index), signal(other.signal) {}
    };
 
+
+private:
+   // Packing/unpacking of compressed rotation quaternions, shared between the single and batch versions of the
+   // compress_rquat_*/restore_rquat_* functions
+   static uint32_t pack_rquat_9bits(const uquat_data& comp);
+   static uquat_data unpack_rquat_9bits(uint32_t compressed);
+   static uint32_t pack_rquat_10bits(const uquat_data& comp);
+   static uquat_data unpack_rquat_10bits(uint32_t compressed);
+   static void pack_rquat_15bits(const uquat_data& comp, uint32_t& out_pack0, uint16_t& out_pack1);
+   static uquat_data unpack_rquat_15bits(uint32_t pack0, uint16_t pack1);
+
+public:
+   // The actual quantization math, shared by the runtime and the compile time specialized (templated) functions. When
+   // called from the templates all the arguments but the value are constants, which the compiler folds. Those don't
+   // perform any verification, so prefer the other functions unless writing a specialized kernel.
+   // 'max_quant' is the largest quantized value (intervals - 1). 'scale' is the same value as float, which is how the
+   // math was originally written (intervals - 1.0f). 'interval_size' is the size of each interval in the [0..1] range
+   static inline uint32_t quantize_unit_float_impl(double value, uint32_t max_quant, float scale)
+   {
+      const uint32_t rounded = (uint32_t)((value * scale) + 0.5f);
+      // Same as "if (rounded > max_quant) rounded -= 1", but without branching
+      return rounded - (uint32_t)(rounded > max_quant);
+   }
+
+   static inline double restore_unit_float_impl(uint32_t quantized, double interval_size)
+   {
+      return (double)quantized * interval_size;
+   }
+
+   static inline uquat_data compress_rotation_impl(const godot::Quaternion& q, uint32_t max_quant, float scale)
+   {
+      // Since it's not possible to iterate through the quaternion components through a loop, creating
+      // this temporary array.
+      const double comps[4] = { q.x, q.y, q.z, q.w };
+      uint32_t quant[3];           // Will hold the three quantized components
+      int mindex = 0;              // Index of the largest component
+      double mval = -1.0f;         // Value of the largest component
+
+      // Locate the largest component, storing its absolute value as well as the index
+      for (int i = 0; i < 4; i++)
+      {
+         const double abval = godot::Math::abs<double>(comps[i]);
+         if (abval > mval)
+         {
+            mval = abval;
+            mindex = i;
+         }
+      }
+
+      // Signal of the dropped component
+      const double sig = comps[mindex] < 0.0f ? -1.0f : 1.0f;
+
+      // Quantize the smallest components
+      for (int i = 0, c = 0; i < 4; i++)
+      {
+         if (i != mindex)
+         {
+            const double unit = ((comps[i] * sig) - -ROTATION_BOUNDS) / (ROTATION_BOUNDS - -ROTATION_BOUNDS);
+            quant[c++] = quantize_unit_float_impl(unit, max_quant, scale);
+         }
+      }
+
+      return uquat_data(quant[0], quant[1], quant[2], mindex, sig == 1.0f ? 1 : 0);
+   }
+
+   static inline godot::Quaternion restore_rotation_impl(const uquat_data& quant, double interval_size)
+   {
+      // Take signal from 0=negative|1=positive (easier bit packing) to -1,+1 for easier multiplication
+      const double sig = quant.signal == 1 ? 1.0f : -1.0f;
+      const double range = ROTATION_BOUNDS - -ROTATION_BOUNDS;
+
+      // Restore the three smallest components (a, b and c)
+      const double ra = (-ROTATION_BOUNDS + (restore_unit_float_impl(quant.a, interval_size) * range)) * sig;
+      const double rb = (-ROTATION_BOUNDS + (restore_unit_float_impl(quant.b, interval_size) * range)) * sig;
+      const double rc = (-ROTATION_BOUNDS + (restore_unit_float_impl(quant.c, interval_size) * range)) * sig;
+      // Restore the dropped component
+      const double dropped = sqrtf(1.0f - ra*ra - rb*rb - rc*rc) * sig;
+
+      switch (quant.index)
+      {
+         case 0:
+            // X was dropped
+            return godot::Quaternion(dropped, ra, rb, rc);
+         case 1:
+            // Y was dropped
+            return godot::Quaternion(ra, dropped, rb, rc);
+         case 2:
+            // Z was dropped
+            return godot::Quaternion(ra, rb, dropped, rc);
+         case 3:
+            // W was dropped
+            return godot::Quaternion(ra, rb, rc, dropped);
+      }
+
+      return godot::Quaternion();
+   }
+
+
    // Quantize a unit float (range [0..1]) into an integer of the specified number of bits.
    static uint32_t quantize_unit_float(double value, int num_bits);
 
@@ -102,6 +201,108 @@ public:
    static double restore_float(uint32_t quantized, double minval, double maxval, int num_bits);
 
 
+   // Write/read values with arbitrary number of bits ([0..32]) into/from a contiguous sequence of 32 bit integers, starting
+   // from the lowest bit of the first integer. When writing, the 'words' buffer must be zero initialized and large enough to
+   // hold all the bits. The position (in bits) is advanced by the number of written/read bits.
+   static inline void write_packed_bits(uint32_t* words, int64_t& bit_pos, uint32_t value, int num_bits)
+   {
+      if (num_bits == 0)
+      {
+         return;
+      }
+
+      const uint64_t mask = (uint64_t(1) << num_bits) - 1;
+      const uint64_t shifted = (uint64_t(value) & mask) << (bit_pos & 31);
+      const int64_t index = bit_pos >> 5;
+
+      words[index] |= (uint32_t)shifted;
+      if ((bit_pos & 31) + num_bits > 32)
+      {
+         words[index + 1] |= (uint32_t)(shifted >> 32);
+      }
+
+      bit_pos += num_bits;
+   }
+
+   static inline uint32_t read_packed_bits(const uint32_t* words, int64_t& bit_pos, int num_bits)
+   {
+      if (num_bits == 0)
+      {
+         return 0;
+      }
+
+      const int64_t index = bit_pos >> 5;
+      const int shift = bit_pos & 31;
+
+      uint64_t chunk = words[index];
+      if (shift + num_bits > 32)
+      {
+         chunk |= uint64_t(words[index + 1]) << 32;
+      }
+
+      bit_pos += num_bits;
+      return (uint32_t)((chunk >> shift) & ((uint64_t(1) << num_bits) - 1));
+   }
+
+
+   // Compile time specialized versions of the functions above, meant to be used by native code that always works with
+   // the same number of bits. Masks, interval sizes and so on become constants and there is no verification of the
+   // number of bits during runtime. Results are identical to the runtime versions.
+   template <int Bits>
+   static inline uint32_t quantize_unit_float_t(double value)
+   {
+      static_assert(Bits >= 2 && Bits <= 32, "Number of bits must be between 2 and 32");
+      constexpr uint32_t max_quant = (uint32_t)((uint64_t(1) << Bits) - 1);
+      constexpr float scale = (float)(uint64_t(1) << Bits) - 1.0f;
+      return quantize_unit_float_impl(value, max_quant, scale);
+   }
+
+   template <int Bits>
+   static inline double restore_unit_float_t(uint32_t quantized)
+   {
+      static_assert(Bits >= 2 && Bits <= 32, "Number of bits must be between 2 and 32");
+      constexpr double interval_size = 1.0f / (double)((float)(uint64_t(1) << Bits) - 1.0f);
+      return restore_unit_float_impl(quantized, interval_size);
+   }
+
+   template <int Bits>
+   static inline uint32_t quantize_float_t(double value, double minval, double maxval)
+   {
+      return quantize_unit_float_t<Bits>((value - minval) / (maxval - minval));
+   }
+
+   template <int Bits>
+   static inline double restore_float_t(uint32_t quantized, double minval, double maxval)
+   {
+      return minval + (restore_unit_float_t<Bits>(quantized) * (maxval - minval));
+   }
+
+
+   // Batch versions of the float quantization. Those work directly on raw buffers so native code can use
+   // them without any intermediate container. The output buffer must hold at least 'count' elements. No
+   // verification is done inside the loops, meaning that the number of bits must be checked before calling.
+   static void quantize_float_batch(const float* values, uint32_t* out, int64_t count, double minval, double maxval, int num_bits);
+   static void quantize_float_batch(const double* values, uint32_t* out, int64_t count, double minval, double maxval, int num_bits);
+   static void restore_float_batch(const uint32_t* quantized, float* out, int64_t count, double minval, double maxval, int num_bits);
+   static void restore_float_batch(const uint32_t* quantized, double* out, int64_t count, double minval, double maxval, int num_bits);
+
+   // Quantize all unit floats (range [0..1]) in the given array, returning the encoded integers in the same order.
+   static godot::PackedInt32Array quantize_unit_float_array(const godot::PackedFloat32Array& values, int num_bits);
+
+   // Restore all unit floats that were encoded with quantize_unit_float_array().
+   static godot::PackedFloat32Array restore_unit_float_array(const godot::PackedInt32Array& quantized, int num_bits);
+
+   // Quantize all floats in the given array, which must be in the [minval..maxval] range.
+   static godot::PackedInt32Array quantize_float_array(const godot::PackedFloat32Array& values, double minval, double maxval, int num_bits);
+
+   // Restore all floats that were encoded with quantize_float_array(). Range and number of bits must match.
+   static godot::PackedFloat32Array restore_float_array(const godot::PackedInt32Array& quantized, double minval, double maxval, int num_bits);
+
+   // Double precision variants of the two functions above.
+   static godot::PackedInt32Array quantize_float64_array(const godot::PackedFloat64Array& values, double minval, double maxval, int num_bits);
+   static godot::PackedFloat64Array restore_float64_array(const godot::PackedInt32Array& quantized, double minval, double maxval, int num_bits);
+
+
    // Compress the given rotation quaternion (or unit Quaternion) using the specified number of bits
    // per component using the smallest three method.
    // NOTE: this one is not meant to be exposed to GDScript as it uses internal struct
@@ -121,6 +322,24 @@ public:
    // Restore a rotation quaternion
    static godot::Quaternion restore_rotation_quaternion(const uquat_data& quant, int num_bits);
 
+   // Compile time specialized versions of compress_rotation_quaternion() and restore_rotation_quaternion()
+   template <int Bits>
+   static inline uquat_data compress_rotation_quaternion_t(const godot::Quaternion& q)
+   {
+      static_assert(Bits >= 2 && Bits <= 32, "Number of bits must be between 2 and 32");
+      constexpr uint32_t max_quant = (uint32_t)((uint64_t(1) << Bits) - 1);
+      constexpr float scale = (float)(uint64_t(1) << Bits) - 1.0f;
+      return compress_rotation_impl(q, max_quant, scale);
+   }
+
+   template <int Bits>
+   static inline godot::Quaternion restore_rotation_quaternion_t(const uquat_data& quant)
+   {
+      static_assert(Bits >= 2 && Bits <= 32, "Number of bits must be between 2 and 32");
+      constexpr double interval_size = 1.0f / (double)((float)(uint64_t(1) << Bits) - 1.0f);
+      return restore_rotation_impl(quant, interval_size);
+   }
+
    // Restore a rotation quaternion. The quantized values must be given in a dictionary with the
    // same format of the one returned by the compress_rotation_quaternion() function.
    static godot::Quaternion _restore_rotation_quaternion(const godot::Dictionary& quant, int num_bits);
@@ -159,6 +378,67 @@ public:
    static godot::Quaternion restore_rquat_15bits(uint32_t pack0, uint16_t pack1);
    static godot::Quaternion _restore_rquat_15bits(uint32_t pack0, uint32_t pack1) { return restore_rquat_15bits(pack0, pack1); }
 
+   // Non allocating version of compress_rquat_15bits(), meant to be used by native code. The data is written
+   // directly into the two output integers.
+   static void compress_rquat_15bits_into(const godot::Quaternion& q, uint32_t& out_pack0, uint16_t& out_pack1);
+
+
+   // Batch versions of the rotation quaternion compression, working on raw buffers. The input must contain 'count'
+   // quaternions, each one taking 4 consecutive floats in the x, y, z, w order. The output buffer must be preallocated
+   // by the caller and must hold 'count' integers for the 9 and 10 bits versions. The 15 bits version requires twice that,
+   // with each quaternion taking two consecutive entries (pack0 then pack1).
+   static void compress_rquat_9bits_batch(const float* xyzw, uint32_t* out, int64_t count);
+   static void compress_rquat_10bits_batch(const float* xyzw, uint32_t* out, int64_t count);
+   static void compress_rquat_15bits_batch(const float* xyzw, uint32_t* out, int64_t count);
+
+   // And the restoration of the batches above. Output buffer must hold 4 * count floats.
+   static void restore_rquat_9bits_batch(const uint32_t* compressed, float* out_xyzw, int64_t count);
+   static void restore_rquat_10bits_batch(const uint32_t* compressed, float* out_xyzw, int64_t count);
+   static void restore_rquat_15bits_batch(const uint32_t* compressed, float* out_xyzw, int64_t count);
+
+   // Compress all rotation quaternions given in a flat array (x, y, z, w of each quaternion in sequence) using 9 bits per
+   // component. The returned array contains one integer per quaternion.
+   static godot::PackedInt32Array compress_rquat_9bits_array(const godot::PackedFloat32Array& xyzw);
+
+   // Restore rotation quaternions compressed with compress_rquat_9bits_array(). The result is a flat array of x, y, z, w.
+   static godot::PackedFloat32Array restore_rquat_9bits_array(const godot::PackedInt32Array& compressed);
+
+   // Same as compress_rquat_9bits_array() but using 10 bits per component. Quaternion signals may be flipped.
+   static godot::PackedInt32Array compress_rquat_10bits_array(const godot::PackedFloat32Array& xyzw);
+
+   // Restore rotation quaternions compressed with compress_rquat_10bits_array()
+   static godot::PackedFloat32Array restore_rquat_10bits_array(const godot::PackedInt32Array& compressed);
+
+   // Same as compress_rquat_9bits_array() but using 15 bits per component. The returned array contains two integers per
+   // quaternion, in the same order given by compress_rquat_15bits().
+   static godot::PackedInt32Array compress_rquat_15bits_array(const godot::PackedFloat32Array& xyzw);
+
+   // Restore rotation quaternions compressed with compress_rquat_15bits_array()
+   static godot::PackedFloat32Array restore_rquat_15bits_array(const godot::PackedInt32Array& compressed);
+
+
+   // Quantize each component of the given vector within its own [minval..maxval] range, using the number of bits
+   // specified for that axis. All quantized components are packed together, starting from the lowest bit of the first
+   // integer in the returned array. An axis set to use 0 bits is not encoded and restored as its minval. Values outside
+   // of the range are clamped.
+   static godot::PackedInt32Array quantize_vector2(const godot::Vector2& v, const godot::Vector2& minval, const godot::Vector2& maxval, const godot::Vector2i& num_bits);
+   static godot::Vector2 restore_vector2(const godot::PackedInt32Array& quantized, const godot::Vector2& minval, const godot::Vector2& maxval, const godot::Vector2i& num_bits);
+
+   static godot::PackedInt32Array quantize_vector3(const godot::Vector3& v, const godot::Vector3& minval, const godot::Vector3& maxval, const godot::Vector3i& num_bits);
+   static godot::Vector3 restore_vector3(const godot::PackedInt32Array& quantized, const godot::Vector3& minval, const godot::Vector3& maxval, const godot::Vector3i& num_bits);
+
+   // Quantize a 2D transform, packing the data in the order position, rotation then scale. Position and scale follow
+   // the same rules of quantize_vector2(). Rotation is the angle in the [-PI..PI] range, using rot_bits (0 meaning not
+   // encoded). Skew is not kept.
+   static godot::PackedInt32Array quantize_transform2d(const godot::Transform2D& t, const godot::Vector2& minpos, const godot::Vector2& maxpos, const godot::Vector2i& pos_bits, int rot_bits, const godot::Vector2& minscale, const godot::Vector2& maxscale, const godot::Vector2i& scale_bits);
+   static godot::Transform2D restore_transform2d(const godot::PackedInt32Array& quantized, const godot::Vector2& minpos, const godot::Vector2& maxpos, const godot::Vector2i& pos_bits, int rot_bits, const godot::Vector2& minscale, const godot::Vector2& maxscale, const godot::Vector2i& scale_bits);
+
+   // Quantize a 3D transform, packing the data in the order position, rotation then scale. Position and scale follow
+   // the same rules of quantize_vector3(). Rotation uses the smallest three method with rot_bits per component, taking
+   // 3 * rot_bits + 2 bits (0 meaning not encoded).
+   static godot::PackedInt32Array quantize_transform3d(const godot::Transform3D& t, const godot::Vector3& minpos, const godot::Vector3& maxpos, const godot::Vector3i& pos_bits, int rot_bits, const godot::Vector3& minscale, const godot::Vector3& maxscale, const godot::Vector3i& scale_bits);
+   static godot::Transform3D restore_transform3d(const godot::PackedInt32Array& quantized, const godot::Vector3& minpos, const godot::Vector3& maxpos, const godot::Vector3i& pos_bits, int rot_bits, const godot::Vector3& minscale, const godot::Vector3& maxscale, const godot::Vector3i& scale_bits);
+
 
    Quantize() {}
 };
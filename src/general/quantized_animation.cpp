@@ -0,0 +1,792 @@
+/**
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+
+#include "quantized_animation.h"
+
+#ifndef QUANTIZED_ANIMATION_DISABLED
+
+#include <godot_cpp/core/class_db.hpp>
+#include <godot_cpp/variant/utility_functions.hpp>
+
+
+int QuantizedAnimation::get_key_stride(int type, int bits)
+{
+   switch (type)
+   {
+      case godot::Animation::TYPE_POSITION_3D:
+      case godot::Animation::TYPE_SCALE_3D:
+         return TIME_BITS + (bits * 3);
+
+      case godot::Animation::TYPE_ROTATION_3D:
+         // Smallest three plus the index of the dropped component. The signal is not needed for rotations
+         return TIME_BITS + (bits * 3) + 2;
+   }
+
+   return TIME_BITS + bits;
+}
+
+
+bool QuantizedAnimation::is_supported_type(int type)
+{
+   switch (type)
+   {
+      case godot::Animation::TYPE_POSITION_3D:
+      case godot::Animation::TYPE_ROTATION_3D:
+      case godot::Animation::TYPE_SCALE_3D:
+      case godot::Animation::TYPE_BLEND_SHAPE:
+      case godot::Animation::TYPE_VALUE:
+         return true;
+   }
+
+   return false;
+}
+
+
+double QuantizedAnimation::get_key_time(const Track& track, int64_t key) const
+{
+   const uint32_t* words = reinterpret_cast<const uint32_t*>(track.data.ptr());
+   int64_t bit_pos = key * get_key_stride(track.type, track.bits);
+
+   // A 0 length animation is quantized using 1 as range, so all keys end up at time 0
+   return Quantize::restore_float(Quantize::read_packed_bits(words, bit_pos, TIME_BITS), 0.0, m_length > 0.0 ? m_length : 1.0, TIME_BITS);
+}
+
+
+godot::Vector3 QuantizedAnimation::decode_vector(const Track& track, int64_t key) const
+{
+   const uint32_t* words = reinterpret_cast<const uint32_t*>(track.data.ptr());
+   int64_t bit_pos = key * get_key_stride(track.type, track.bits) + TIME_BITS;
+
+   godot::Vector3 ret;
+   ret.x = Quantize::restore_float(Quantize::read_packed_bits(words, bit_pos, track.bits), track.minval.x, track.maxval.x, track.bits);
+
+   if (track.type == godot::Animation::TYPE_POSITION_3D || track.type == godot::Animation::TYPE_SCALE_3D)
+   {
+      ret.y = Quantize::restore_float(Quantize::read_packed_bits(words, bit_pos, track.bits), track.minval.y, track.maxval.y, track.bits);
+      ret.z = Quantize::restore_float(Quantize::read_packed_bits(words, bit_pos, track.bits), track.minval.z, track.maxval.z, track.bits);
+   }
+
+   return ret;
+}
+
+
+godot::Quaternion QuantizedAnimation::decode_rotation(const Track& track, int64_t key) const
+{
+   const uint32_t* words = reinterpret_cast<const uint32_t*>(track.data.ptr());
+   int64_t bit_pos = key * get_key_stride(track.type, track.bits) + TIME_BITS;
+
+   Quantize::uquat_data quant;
+   quant.a = Quantize::read_packed_bits(words, bit_pos, track.bits);
+   quant.b = Quantize::read_packed_bits(words, bit_pos, track.bits);
+   quant.c = Quantize::read_packed_bits(words, bit_pos, track.bits);
+   quant.index = (uint8_t)Quantize::read_packed_bits(words, bit_pos, 2);
+
+   return Quantize::restore_rotation_quaternion(quant, track.bits).normalized();
+}
+
+
+bool QuantizedAnimation::find_keys(int track_index, int type, double time, KeySample& out_sample) const
+{
+   ERR_FAIL_INDEX_V(track_index, m_track.size(), false);
+   const Track& track = m_track[track_index];
+   ERR_FAIL_COND_V_MSG(track.type != type, false, godot::vformat("Track %d is not of the requested type.", track_index));
+
+   if (track.key_count == 0)
+   {
+      return false;
+   }
+
+   const double t = wrap_time(time);
+
+   // Locate the first key with time greater than 't'
+   int64_t low = 0;
+   int64_t high = track.key_count;
+   while (low < high)
+   {
+      const int64_t mid = low + ((high - low) >> 1);
+      if (get_key_time(track, mid) <= t)
+      {
+         low = mid + 1;
+      }
+      else
+      {
+         high = mid;
+      }
+   }
+
+   const int64_t last = track.key_count - 1;
+   const bool wrap = track.loop_wrap && m_loop_mode == godot::Animation::LOOP_LINEAR && m_length > 0.0 && track.key_count > 1;
+
+   out_sample.weight = 0.0;
+
+   double from_time = t;
+   double to_time = t;
+
+   if (low > 0 && low <= last)
+   {
+      out_sample.from = low - 1;
+      out_sample.to = low;
+      from_time = get_key_time(track, out_sample.from);
+      to_time = get_key_time(track, out_sample.to);
+   }
+   else if (wrap)
+   {
+      // Between the last key and the end of the animation, or before the first key, the track interpolates from the
+      // last key into the first one
+      out_sample.from = last;
+      out_sample.to = 0;
+      from_time = get_key_time(track, last);
+      to_time = get_key_time(track, 0) + m_length;
+
+      if (low == 0)
+      {
+         from_time -= m_length;
+         to_time -= m_length;
+      }
+   }
+   else
+   {
+      out_sample.from = out_sample.to = low == 0 ? 0 : last;
+   }
+
+   const double delta = to_time - from_time;
+   if (out_sample.from != out_sample.to && delta > 0.0)
+   {
+      out_sample.weight = (t - from_time) / delta;
+   }
+
+   if (is_cubic(track))
+   {
+      // Offsets applied into the times of the two keys when wrapping around, which the neighbouring keys must follow
+      const double from_shift = from_time - get_key_time(track, out_sample.from);
+      const double to_shift = to_time - get_key_time(track, out_sample.to);
+
+      double pre_time = from_time;
+      double post_time = to_time;
+      out_sample.pre = out_sample.from;
+      out_sample.post = out_sample.to;
+
+      if (out_sample.from > 0)
+      {
+         out_sample.pre = out_sample.from - 1;
+         pre_time = get_key_time(track, out_sample.pre) + from_shift;
+      }
+      else if (wrap)
+      {
+         out_sample.pre = last;
+         pre_time = get_key_time(track, last) + from_shift - m_length;
+      }
+
+      if (out_sample.to < last)
+      {
+         out_sample.post = out_sample.to + 1;
+         post_time = get_key_time(track, out_sample.post) + to_shift;
+      }
+      else if (wrap)
+      {
+         out_sample.post = 0;
+         post_time = get_key_time(track, 0) + to_shift + m_length;
+      }
+
+      out_sample.to_dt = to_time - from_time;
+      out_sample.pre_dt = pre_time - from_time;
+      out_sample.post_dt = post_time - from_time;
+   }
+
+   return true;
+}
+
+
+bool QuantizedAnimation::is_step(const Track& track)
+{
+   if (track.interpolation == godot::Animation::INTERPOLATION_NEAREST)
+   {
+      return true;
+   }
+
+   return track.type == godot::Animation::TYPE_VALUE && track.update_mode == godot::Animation::UPDATE_DISCRETE;
+}
+
+
+bool QuantizedAnimation::is_cubic(const Track& track)
+{
+   return track.interpolation == godot::Animation::INTERPOLATION_CUBIC || track.interpolation == godot::Animation::INTERPOLATION_CUBIC_ANGLE;
+}
+
+
+double QuantizedAnimation::sample_float(const Track& track, const KeySample& ks) const
+{
+   const double from = decode_vector(track, ks.from).x;
+   if (ks.from == ks.to || is_step(track))
+   {
+      return from;
+   }
+
+   const double to = decode_vector(track, ks.to).x;
+
+   // Angle interpolation is only done by value tracks, matching what Animation does
+   const bool angle = track.type == godot::Animation::TYPE_VALUE;
+
+   switch (track.interpolation)
+   {
+      case godot::Animation::INTERPOLATION_CUBIC:
+         return godot::Math::cubic_interpolate_in_time(from, to, decode_vector(track, ks.pre).x, decode_vector(track, ks.post).x, ks.weight, ks.to_dt, ks.pre_dt, ks.post_dt);
+
+      case godot::Animation::INTERPOLATION_CUBIC_ANGLE:
+      {
+         const double pre = decode_vector(track, ks.pre).x;
+         const double post = decode_vector(track, ks.post).x;
+         if (angle)
+         {
+            return godot::Math::cubic_interpolate_angle_in_time(from, to, pre, post, ks.weight, ks.to_dt, ks.pre_dt, ks.post_dt);
+         }
+
+         return godot::Math::cubic_interpolate_in_time(from, to, pre, post, ks.weight, ks.to_dt, ks.pre_dt, ks.post_dt);
+      }
+
+      case godot::Animation::INTERPOLATION_LINEAR_ANGLE:
+         if (angle)
+         {
+            return godot::Math::lerp_angle(from, to, ks.weight);
+         }
+         break;
+   }
+
+   return godot::Math::lerp(from, to, ks.weight);
+}
+
+
+double QuantizedAnimation::wrap_time(double time) const
+{
+   if (m_length <= 0.0)
+   {
+      return 0.0;
+   }
+
+   switch (m_loop_mode)
+   {
+      case godot::Animation::LOOP_LINEAR:
+         return godot::Math::fposmod(time, m_length);
+
+      case godot::Animation::LOOP_PINGPONG:
+      {
+         const double t = godot::Math::fposmod(time, m_length * 2.0);
+         return t > m_length ? (m_length * 2.0) - t : t;
+      }
+   }
+
+   return godot::Math::clamp(time, 0.0, m_length);
+}
+
+
+void QuantizedAnimation::build_track(Track& track, const godot::Ref<godot::Animation>& animation, int index)
+{
+   const bool is_vector = track.type == godot::Animation::TYPE_POSITION_3D || track.type == godot::Animation::TYPE_SCALE_3D;
+   const bool is_rotation = track.type == godot::Animation::TYPE_ROTATION_3D;
+   const int stride = get_key_stride(track.type, track.bits);
+   const double time_range = m_length > 0.0 ? m_length : 1.0;
+
+   // Gather the bounds first. Rotations don't need those
+   if (!is_rotation)
+   {
+      for (int64_t k = 0; k < track.key_count; k++)
+      {
+         const godot::Variant value = animation->track_get_key_value(index, k);
+         const godot::Vector3 v = is_vector ? godot::Vector3(value) : godot::Vector3(double(value), 0.0, 0.0);
+
+         for (int c = 0; c < 3; c++)
+         {
+            track.minval[c] = k == 0 ? v[c] : MIN(track.minval[c], v[c]);
+            track.maxval[c] = k == 0 ? v[c] : MAX(track.maxval[c], v[c]);
+         }
+      }
+
+      // Constant components would result in an empty range, which can't be restored
+      for (int c = 0; c < 3; c++)
+      {
+         if (track.maxval[c] - track.minval[c] < CMP_EPSILON)
+         {
+            track.maxval[c] = track.minval[c] + 1.0;
+         }
+      }
+   }
+
+   track.data.resize(((track.key_count * stride) + 31) >> 5);
+   track.data.fill(0);
+
+   uint32_t* words = reinterpret_cast<uint32_t*>(track.data.ptrw());
+   int64_t bit_pos = 0;
+
+   for (int64_t k = 0; k < track.key_count; k++)
+   {
+      const double time = godot::Math::clamp(animation->track_get_key_time(index, k), 0.0, time_range);
+      Quantize::write_packed_bits(words, bit_pos, Quantize::quantize_float(time, 0.0, time_range, TIME_BITS), TIME_BITS);
+
+      const godot::Variant value = animation->track_get_key_value(index, k);
+
+      if (is_rotation)
+      {
+         const Quantize::uquat_data quant = Quantize::compress_rotation_quaternion(godot::Quaternion(value).normalized(), track.bits);
+         Quantize::write_packed_bits(words, bit_pos, quant.a, track.bits);
+         Quantize::write_packed_bits(words, bit_pos, quant.b, track.bits);
+         Quantize::write_packed_bits(words, bit_pos, quant.c, track.bits);
+         Quantize::write_packed_bits(words, bit_pos, quant.index, 2);
+      }
+      else if (is_vector)
+      {
+         const godot::Vector3 v = value;
+         Quantize::write_packed_bits(words, bit_pos, Quantize::quantize_float(v.x, track.minval.x, track.maxval.x, track.bits), track.bits);
+         Quantize::write_packed_bits(words, bit_pos, Quantize::quantize_float(v.y, track.minval.y, track.maxval.y, track.bits), track.bits);
+         Quantize::write_packed_bits(words, bit_pos, Quantize::quantize_float(v.z, track.minval.z, track.maxval.z, track.bits), track.bits);
+      }
+      else
+      {
+         Quantize::write_packed_bits(words, bit_pos, Quantize::quantize_float(double(value), track.minval.x, track.maxval.x, track.bits), track.bits);
+      }
+   }
+}
+
+
+godot::Array QuantizedAnimation::get_track_list() const
+{
+   godot::Array ret;
+
+   for (int64_t i = 0; i < m_track.size(); i++)
+   {
+      const Track& track = m_track[i];
+
+      godot::Dictionary entry;
+      entry["path"] = track.path;
+      entry["type"] = track.type;
+      entry["bits"] = track.bits;
+      entry["min"] = track.minval;
+      entry["max"] = track.maxval;
+      entry["count"] = track.key_count;
+      entry["interpolation"] = track.interpolation;
+      entry["loop_wrap"] = track.loop_wrap;
+      entry["update_mode"] = track.update_mode;
+      entry["data"] = track.data;
+
+      ret.append(entry);
+   }
+
+   return ret;
+}
+
+
+void QuantizedAnimation::set_track_list(const godot::Array& list)
+{
+   m_track.clear();
+
+   for (int64_t i = 0; i < list.size(); i++)
+   {
+      const godot::Dictionary entry = list[i];
+
+      Track track;
+      track.path = entry.get("path", godot::NodePath());
+      track.type = entry.get("type", (int)godot::Animation::TYPE_VALUE);
+      track.bits = entry.get("bits", 0);
+      track.minval = entry.get("min", godot::Vector3());
+      track.maxval = entry.get("max", godot::Vector3());
+      track.key_count = entry.get("count", 0);
+      track.interpolation = entry.get("interpolation", (int)godot::Animation::INTERPOLATION_LINEAR);
+      track.loop_wrap = entry.get("loop_wrap", true);
+      track.update_mode = entry.get("update_mode", (int)godot::Animation::UPDATE_CONTINUOUS);
+      track.data = entry.get("data", godot::PackedInt32Array());
+
+      // The stride can only be calculated once the number of bits is known to be valid
+      ERR_CONTINUE_MSG(!is_supported_type(track.type) || track.bits < MIN_BITS || track.bits > MAX_BITS || track.key_count < 0, godot::vformat("Compressed data of track '%s' is invalid.", track.path));
+
+      const int64_t required = ((track.key_count * get_key_stride(track.type, track.bits)) + 31) >> 5;
+      ERR_CONTINUE_MSG(track.data.size() < required, godot::vformat("Compressed data of track '%s' is invalid.", track.path));
+
+      m_track.push_back(track);
+   }
+}
+
+
+void QuantizedAnimation::_get_property_list(godot::List<godot::PropertyInfo>* out_list) const
+{
+   using namespace godot;
+
+   out_list->push_back(PropertyInfo(Variant::FLOAT, "length", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
+   out_list->push_back(PropertyInfo(Variant::INT, "loop_mode", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
+   out_list->push_back(PropertyInfo(Variant::ARRAY, "tracks", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
+}
+
+
+bool QuantizedAnimation::_set(const godot::StringName& prop_name, const godot::Variant& value)
+{
+   bool ret = true;
+
+   if (prop_name == godot::StringName("length"))
+   {
+      m_length = value;
+   }
+   else if (prop_name == godot::StringName("loop_mode"))
+   {
+      m_loop_mode = value;
+   }
+   else if (prop_name == godot::StringName("tracks"))
+   {
+      set_track_list(value);
+   }
+   else
+   {
+      ret = false;
+   }
+
+   return ret;
+}
+
+
+bool QuantizedAnimation::_get(const godot::StringName& prop_name, godot::Variant& out_value) const
+{
+   bool ret = true;
+
+   if (prop_name == godot::StringName("length"))
+   {
+      out_value = m_length;
+   }
+   else if (prop_name == godot::StringName("loop_mode"))
+   {
+      out_value = m_loop_mode;
+   }
+   else if (prop_name == godot::StringName("tracks"))
+   {
+      out_value = get_track_list();
+   }
+   else
+   {
+      ret = false;
+   }
+
+   return ret;
+}
+
+
+void QuantizedAnimation::_bind_methods()
+{
+   using namespace godot;
+
+   ClassDB::bind_method(D_METHOD("compress", "animation", "rotation_bits", "position_bits", "scale_bits", "float_bits"), &QuantizedAnimation::compress, DEFVAL(10), DEFVAL(16), DEFVAL(16), DEFVAL(16));
+   ClassDB::bind_method(D_METHOD("to_animation"), &QuantizedAnimation::to_animation);
+
+   ClassDB::bind_method(D_METHOD("get_length"), &QuantizedAnimation::get_length);
+   ClassDB::bind_method(D_METHOD("get_loop_mode"), &QuantizedAnimation::get_loop_mode);
+
+   ClassDB::bind_method(D_METHOD("get_track_count"), &QuantizedAnimation::get_track_count);
+   ClassDB::bind_method(D_METHOD("get_track_path", "track_index"), &QuantizedAnimation::get_track_path);
+   ClassDB::bind_method(D_METHOD("get_track_type", "track_index"), &QuantizedAnimation::get_track_type);
+   ClassDB::bind_method(D_METHOD("get_track_key_count", "track_index"), &QuantizedAnimation::get_track_key_count);
+   ClassDB::bind_method(D_METHOD("find_track", "path", "type"), &QuantizedAnimation::find_track);
+
+   ClassDB::bind_method(D_METHOD("sample_position", "track_index", "time"), &QuantizedAnimation::sample_position);
+   ClassDB::bind_method(D_METHOD("sample_rotation", "track_index", "time"), &QuantizedAnimation::sample_rotation);
+   ClassDB::bind_method(D_METHOD("sample_scale", "track_index", "time"), &QuantizedAnimation::sample_scale);
+   ClassDB::bind_method(D_METHOD("sample_blend_shape", "track_index", "time"), &QuantizedAnimation::sample_blend_shape);
+   ClassDB::bind_method(D_METHOD("sample_value", "track_index", "time"), &QuantizedAnimation::sample_value);
+
+   ClassDB::bind_method(D_METHOD("get_data_size"), &QuantizedAnimation::get_data_size);
+}
+
+
+void QuantizedAnimation::compress(const godot::Ref<godot::Animation>& animation, int rotation_bits, int position_bits, int scale_bits, int float_bits)
+{
+   ERR_FAIL_COND_MSG(!animation.is_valid(), "Attempting to compress an invalid Animation.");
+   ERR_FAIL_COND_MSG(rotation_bits < MIN_BITS || rotation_bits > MAX_BITS, godot::vformat("Number of rotation bits must be between %d and %d, but %s has been given", MIN_BITS, MAX_BITS, rotation_bits));
+   ERR_FAIL_COND_MSG(position_bits < MIN_BITS || position_bits > MAX_BITS, godot::vformat("Number of position bits must be between %d and %d, but %s has been given", MIN_BITS, MAX_BITS, position_bits));
+   ERR_FAIL_COND_MSG(scale_bits < MIN_BITS || scale_bits > MAX_BITS, godot::vformat("Number of scale bits must be between %d and %d, but %s has been given", MIN_BITS, MAX_BITS, scale_bits));
+   ERR_FAIL_COND_MSG(float_bits < MIN_BITS || float_bits > MAX_BITS, godot::vformat("Number of float bits must be between %d and %d, but %s has been given", MIN_BITS, MAX_BITS, float_bits));
+
+   m_track.clear();
+   m_length = animation->get_length();
+   m_loop_mode = animation->get_loop_mode();
+
+   const int32_t track_count = animation->get_track_count();
+   for (int32_t i = 0; i < track_count; i++)
+   {
+      const int type = animation->track_get_type(i);
+      if (!is_supported_type(type))
+      {
+         WARN_PRINT(godot::vformat("Track '%s' is of an unsupported type and will not be compressed.", animation->track_get_path(i)));
+         continue;
+      }
+
+      Track track;
+      track.path = animation->track_get_path(i);
+      track.type = type;
+      track.key_count = animation->track_get_key_count(i);
+      track.interpolation = animation->track_get_interpolation_type(i);
+      track.loop_wrap = animation->track_get_interpolation_loop_wrap(i);
+
+      if (type == godot::Animation::TYPE_VALUE)
+      {
+         track.update_mode = animation->value_track_get_update_mode(i);
+      }
+
+      switch (type)
+      {
+         case godot::Animation::TYPE_POSITION_3D:
+            track.bits = position_bits;
+            break;
+
+         case godot::Animation::TYPE_ROTATION_3D:
+            track.bits = rotation_bits;
+            break;
+
+         case godot::Animation::TYPE_SCALE_3D:
+            track.bits = scale_bits;
+            break;
+
+         default:
+            track.bits = float_bits;
+      }
+
+      if (type == godot::Animation::TYPE_VALUE)
+      {
+         // Only numeric value tracks can be range quantized
+         bool numeric = true;
+         for (int64_t k = 0; k < track.key_count && numeric; k++)
+         {
+            const godot::Variant::Type vtype = animation->track_get_key_value(i, k).get_type();
+            numeric = vtype == godot::Variant::FLOAT || vtype == godot::Variant::INT;
+         }
+
+         if (!numeric)
+         {
+            WARN_PRINT(godot::vformat("Value track '%s' does not hold numbers and will not be compressed.", track.path));
+            continue;
+         }
+      }
+
+      build_track(track, animation, i);
+
+      m_track.push_back(track);
+   }
+
+   emit_changed();
+}
+
+
+godot::Ref<godot::Animation> QuantizedAnimation::to_animation() const
+{
+   godot::Ref<godot::Animation> ret;
+   ret.instantiate();
+
+   ret->set_length(m_length);
+   ret->set_loop_mode((godot::Animation::LoopMode)m_loop_mode);
+
+   for (int64_t i = 0; i < m_track.size(); i++)
+   {
+      const Track& track = m_track[i];
+      const int32_t index = ret->add_track((godot::Animation::TrackType)track.type);
+      ret->track_set_path(index, track.path);
+      ret->track_set_interpolation_type(index, (godot::Animation::InterpolationType)track.interpolation);
+      ret->track_set_interpolation_loop_wrap(index, track.loop_wrap);
+
+      if (track.type == godot::Animation::TYPE_VALUE)
+      {
+         ret->value_track_set_update_mode(index, (godot::Animation::UpdateMode)track.update_mode);
+      }
+
+      for (int64_t k = 0; k < track.key_count; k++)
+      {
+         const double time = get_key_time(track, k);
+
+         switch (track.type)
+         {
+            case godot::Animation::TYPE_POSITION_3D:
+               ret->position_track_insert_key(index, time, decode_vector(track, k));
+               break;
+
+            case godot::Animation::TYPE_ROTATION_3D:
+               ret->rotation_track_insert_key(index, time, decode_rotation(track, k));
+               break;
+
+            case godot::Animation::TYPE_SCALE_3D:
+               ret->scale_track_insert_key(index, time, decode_vector(track, k));
+               break;
+
+            case godot::Animation::TYPE_BLEND_SHAPE:
+               ret->blend_shape_track_insert_key(index, time, decode_vector(track, k).x);
+               break;
+
+            default:
+               ret->track_insert_key(index, time, decode_vector(track, k).x);
+         }
+      }
+   }
+
+   return ret;
+}
+
+
+godot::NodePath QuantizedAnimation::get_track_path(int track_index) const
+{
+   ERR_FAIL_INDEX_V(track_index, m_track.size(), godot::NodePath());
+   return m_track[track_index].path;
+}
+
+
+int QuantizedAnimation::get_track_type(int track_index) const
+{
+   ERR_FAIL_INDEX_V(track_index, m_track.size(), -1);
+   return m_track[track_index].type;
+}
+
+
+int64_t QuantizedAnimation::get_track_key_count(int track_index) const
+{
+   ERR_FAIL_INDEX_V(track_index, m_track.size(), 0);
+   return m_track[track_index].key_count;
+}
+
+
+int QuantizedAnimation::find_track(const godot::NodePath& path, int type) const
+{
+   for (int64_t i = 0; i < m_track.size(); i++)
+   {
+      if (m_track[i].type == type && m_track[i].path == path)
+      {
+         return (int)i;
+      }
+   }
+
+   return -1;
+}
+
+
+godot::Vector3 QuantizedAnimation::sample_position(int track_index, double time) const
+{
+   KeySample ks;
+   if (!find_keys(track_index, godot::Animation::TYPE_POSITION_3D, time, ks))
+   {
+      return godot::Vector3();
+   }
+
+   const Track& track = m_track[track_index];
+   const godot::Vector3 from = decode_vector(track, ks.from);
+   if (ks.from == ks.to || is_step(track))
+   {
+      return from;
+   }
+
+   const godot::Vector3 to = decode_vector(track, ks.to);
+   if (is_cubic(track))
+   {
+      return from.cubic_interpolate_in_time(to, decode_vector(track, ks.pre), decode_vector(track, ks.post), ks.weight, ks.to_dt, ks.pre_dt, ks.post_dt);
+   }
+
+   return from.lerp(to, ks.weight);
+}
+
+
+godot::Quaternion QuantizedAnimation::sample_rotation(int track_index, double time) const
+{
+   KeySample ks;
+   if (!find_keys(track_index, godot::Animation::TYPE_ROTATION_3D, time, ks))
+   {
+      return godot::Quaternion();
+   }
+
+   const Track& track = m_track[track_index];
+   const godot::Quaternion from = decode_rotation(track, ks.from);
+   if (ks.from == ks.to || is_step(track))
+   {
+      return from;
+   }
+
+   const godot::Quaternion to = decode_rotation(track, ks.to);
+   if (is_cubic(track))
+   {
+      return from.spherical_cubic_interpolate_in_time(to, decode_rotation(track, ks.pre), decode_rotation(track, ks.post), ks.weight, ks.to_dt, ks.pre_dt, ks.post_dt);
+   }
+
+   return from.slerp(to, ks.weight);
+}
+
+
+godot::Vector3 QuantizedAnimation::sample_scale(int track_index, double time) const
+{
+   KeySample ks;
+   if (!find_keys(track_index, godot::Animation::TYPE_SCALE_3D, time, ks))
+   {
+      return godot::Vector3(1, 1, 1);
+   }
+
+   const Track& track = m_track[track_index];
+   const godot::Vector3 from = decode_vector(track, ks.from);
+   if (ks.from == ks.to || is_step(track))
+   {
+      return from;
+   }
+
+   const godot::Vector3 to = decode_vector(track, ks.to);
+   if (is_cubic(track))
+   {
+      return from.cubic_interpolate_in_time(to, decode_vector(track, ks.pre), decode_vector(track, ks.post), ks.weight, ks.to_dt, ks.pre_dt, ks.post_dt);
+   }
+
+   return from.lerp(to, ks.weight);
+}
+
+
+double QuantizedAnimation::sample_blend_shape(int track_index, double time) const
+{
+   KeySample ks;
+   if (!find_keys(track_index, godot::Animation::TYPE_BLEND_SHAPE, time, ks))
+   {
+      return 0.0;
+   }
+
+   return sample_float(m_track[track_index], ks);
+}
+
+
+double QuantizedAnimation::sample_value(int track_index, double time) const
+{
+   KeySample ks;
+   if (!find_keys(track_index, godot::Animation::TYPE_VALUE, time, ks))
+   {
+      return 0.0;
+   }
+
+   return sample_float(m_track[track_index], ks);
+}
+
+
+int64_t QuantizedAnimation::get_data_size() const
+{
+   int64_t ret = 0;
+   for (int64_t i = 0; i < m_track.size(); i++)
+   {
+      ret += m_track[i].data.size() * sizeof(int32_t);
+   }
+
+   return ret;
+}
+
+
+#endif  //QUANTIZED_ANIMATION_DISABLED
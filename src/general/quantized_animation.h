@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _kehgeneral_quantized_animation_h_included
+#define _kehgeneral_quantized_animation_h_included 1
+
+#include <godot_cpp/godot.hpp>
+#include <godot_cpp/classes/animation.hpp>
+#include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/templates/vector.hpp>
+
+
+#ifndef QUANTIZED_ANIMATION_DISABLED
+
+#include "quantize.h"
+
+
+// Holds a compact version of an Animation. Each supported track becomes a sequence of fixed size keys packed into
+// 32 bit integers. A key is formed by its time, quantized over the animation length, followed by its value. Rotations
+// use the smallest three method while positions, scales and floats are range quantized using per track bounds. Because
+// every key of a track has the same size, sampling locates keys through binary search directly over the packed data
+// and only the (up to) two keys involved in the interpolation are decoded.
+
+class QuantizedAnimation : public godot::Resource
+{
+   GDCLASS(QuantizedAnimation, godot::Resource);
+private:
+   // Number of bits used to quantize the time of each key
+   static const int TIME_BITS = 16;
+
+   // Allowed range for the number of bits of each value component. With 32 bits the float scale used by Quantize rounds
+   // up to 2^32, so the biggest value of a track would overflow the quantized integer
+   static const int MIN_BITS = 2;
+   static const int MAX_BITS = 31;
+
+   struct Track
+   {
+      godot::NodePath path;
+      int type;                     // One of the godot::Animation::TrackType values
+      int bits;                     // Number of bits of each value component
+      godot::Vector3 minval;        // Only the necessary components are used, depending on the track type
+      godot::Vector3 maxval;
+      int64_t key_count;
+      int interpolation;            // One of the godot::Animation::InterpolationType values
+      bool loop_wrap;               // When looping, interpolate between the last and the first keys
+      int update_mode;              // One of the godot::Animation::UpdateMode values. Only used by value tracks
+
+      // Packed keys. Stored as signed integers only so this can be directly saved within the resource
+      godot::PackedInt32Array data;
+
+      Track() : type(godot::Animation::TYPE_VALUE), bits(0), key_count(0), interpolation(godot::Animation::INTERPOLATION_LINEAR), loop_wrap(true), update_mode(godot::Animation::UPDATE_CONTINUOUS) {}
+   };
+
+   // Keys involved in sampling a track at a given time. The 'pre' and 'post' keys (the ones before 'from' and after 'to')
+   // are only filled for cubic interpolation. Times are relative to the 'from' key, already shifted when wrapping around
+   struct KeySample
+   {
+      int64_t from;
+      int64_t to;
+      double weight;
+
+      int64_t pre;
+      int64_t post;
+      double to_dt;
+      double pre_dt;
+      double post_dt;
+
+      KeySample() : from(0), to(0), weight(0.0), pre(0), post(0), to_dt(0.0), pre_dt(0.0), post_dt(0.0) {}
+   };
+
+   godot::Vector<Track> m_track;
+
+   double m_length;
+   int m_loop_mode;
+
+   /// Internal functions
+   // Number of bits taken by a single key, time included
+   static int get_key_stride(int type, int bits);
+
+   // Returns true if the given track type can be compressed
+   static bool is_supported_type(int type);
+
+   // Read the time of the key at the given index
+   double get_key_time(const Track& track, int64_t key) const;
+
+   // Decode the value of the key at the given index. Floats are returned in the x component of the vector
+   godot::Vector3 decode_vector(const Track& track, int64_t key) const;
+   godot::Quaternion decode_rotation(const Track& track, int64_t key) const;
+
+   // Locate the keys surrounding 'time' and the interpolation weight between them. Both keys are the same if 'time' is
+   // outside of the keys range, unless the animation loops linearly and the track wraps around, in which case the last
+   // and first keys are used. Returns false if the track does not exist or does not have any key
+   bool find_keys(int track_index, int type, double time, KeySample& out_sample) const;
+
+   // Returns true if sampling the track should just take the value of the 'from' key rather than interpolating
+   static bool is_step(const Track& track);
+
+   static bool is_cubic(const Track& track);
+
+   // Blend shape and value tracks share the sampling of a single float, as the value is held in the x component
+   double sample_float(const Track& track, const KeySample& ks) const;
+
+   // Converts the requested time into the animation range, taking the loop mode into account
+   double wrap_time(double time) const;
+
+   void build_track(Track& track, const godot::Ref<godot::Animation>& animation, int index);
+
+   // Used to save/load the track list within the resource
+   godot::Array get_track_list() const;
+   void set_track_list(const godot::Array& list);
+
+protected:
+   void _get_property_list(godot::List<godot::PropertyInfo>* out_list) const;
+   bool _set(const godot::StringName& prop_name, const godot::Variant& value);
+   bool _get(const godot::StringName& prop_name, godot::Variant& out_value) const;
+
+   static void _bind_methods();
+
+public:
+   // Compress the given animation, replacing anything that was previously held by this resource. Supported tracks
+   // are position 3D, rotation 3D, scale 3D, blend shape and value tracks holding numbers. Other tracks are ignored
+   // (with a warning).
+   void compress(const godot::Ref<godot::Animation>& animation, int rotation_bits, int position_bits, int scale_bits, int float_bits);
+
+   // Build a new Animation from the compressed data
+   godot::Ref<godot::Animation> to_animation() const;
+
+   double get_length() const { return m_length; }
+   int get_loop_mode() const { return m_loop_mode; }
+
+   int64_t get_track_count() const { return m_track.size(); }
+   godot::NodePath get_track_path(int track_index) const;
+   int get_track_type(int track_index) const;
+   int64_t get_track_key_count(int track_index) const;
+
+   // Returns the index of the track with the given path and type, -1 if not found
+   int find_track(const godot::NodePath& path, int type) const;
+
+   // Sample the track at the given time, following the interpolation type, loop wrap and (for value tracks) update mode
+   // of the source track. Rotations are spherically interpolated. If looping, time is wrapped into the animation length
+   godot::Vector3 sample_position(int track_index, double time) const;
+   godot::Quaternion sample_rotation(int track_index, double time) const;
+   godot::Vector3 sample_scale(int track_index, double time) const;
+   double sample_blend_shape(int track_index, double time) const;
+   double sample_value(int track_index, double time) const;
+
+   // Number of bytes used by the packed keys of all tracks
+   int64_t get_data_size() const;
+
+   QuantizedAnimation() : m_length(0.0), m_loop_mode(godot::Animation::LOOP_NONE) {}
+};
+
+
+#endif  //QUANTIZED_ANIMATION_DISABLED
+
+
+#endif  //_kehgeneral_quantized_animation_h_included
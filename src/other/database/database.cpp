@@ -24,10 +24,12 @@
 #ifndef DATABASE_DISABLED
 
 #include "database.h"
+#include "dbbinary.h"
 
 #include <godot_cpp/classes/file_access.hpp>
 #include <godot_cpp/classes/json.hpp>
 #include <godot_cpp/classes/resource_saver.hpp>
+#include <godot_cpp/classes/worker_thread_pool.hpp>
 
 #include <godot_cpp/variant/utility_functions.hpp>
 
@@ -37,6 +39,43 @@
 /// GDDatabase
 void GDDatabase::check_table_setup()
 {
+   if (!m_lazy_path.is_empty())
+   {
+      // In lazy mode the table directory holds everything needed, so tables that are not loaded remain so
+      m_intid_list.clear();
+      m_strid_list.clear();
+
+      for (godot::HashMap<godot::StringName, TableEntry>::ConstIterator iter = m_lazy_table.begin(); iter != m_lazy_table.end(); ++iter)
+      {
+         if (iter->value.id_type == godot::Variant::INT)
+         {
+            m_intid_list.append(iter->key);
+         }
+         else if (iter->value.id_type == godot::Variant::STRING)
+         {
+            m_strid_list.append(iter->key);
+         }
+      }
+
+      const godot::Array loaded_list = m_table.keys();
+      for (int64_t i = 0; i < loaded_list.size(); i++)
+      {
+         const godot::StringName tbname = loaded_list[i];
+         godot::Ref<DBTable> table = m_table[tbname];
+         table->clear_referencer();
+
+         for (godot::HashMap<godot::StringName, TableEntry>::ConstIterator iter = m_lazy_table.begin(); iter != m_lazy_table.end(); ++iter)
+         {
+            if (iter->value.reference_list.has(tbname))
+            {
+               table->add_referencer(iter->key);
+            }
+         }
+      }
+
+      return;
+   }
+
    godot::Array table_list = m_table.values();
    godot::Array name_list = m_table.keys();
 
@@ -133,6 +172,8 @@ bool GDDatabase::_set(const godot::StringName& prop_name, const godot::Variant&
 {
    if (prop_name == godot::StringName("db_table"))
    {
+      m_lazy_path = "";
+      m_lazy_table.clear();
       m_table = value;
       check_table_setup();
       return true;
@@ -144,6 +185,7 @@ bool GDDatabase::_get(const godot::StringName& prop_name, godot::Variant& out_va
 {
    if (prop_name == godot::StringName("db_table"))
    {
+      load_all_tables();
       out_value = m_table;
       return true;
    }
@@ -157,7 +199,7 @@ void GDDatabase::_bind_methods()
 
    ClassDB::bind_method(D_METHOD("save", "path", "include_tables"), &GDDatabase::save);
    ClassDB::bind_method(D_METHOD("has_table", "table_name"), &GDDatabase::has_table);
-   ClassDB::bind_method(D_METHOD("add_table", "table_name", "int_id", "locked_id"), &GDDatabase::add_table, DEFVAL(false));
+   ClassDB::bind_method(D_METHOD("add_table", "table_name", "int_id", "locked_id", "dense_id"), &GDDatabase::add_table, DEFVAL(false), DEFVAL(false));
    ClassDB::bind_method(D_METHOD("add_table_resource", "table"), &GDDatabase::add_table_res);
    ClassDB::bind_method(D_METHOD("rename_table", "from", "to"), &GDDatabase::rename_table);
    ClassDB::bind_method(D_METHOD("get_table_list"), &GDDatabase::get_table_list);
@@ -168,19 +210,41 @@ void GDDatabase::_bind_methods()
    ClassDB::bind_method(D_METHOD("table_rename_column", "table_name", "column_index", "new_title"), &GDDatabase::table_rename_column);
    ClassDB::bind_method(D_METHOD("table_remove_column", "table_name", "column_index"), &GDDatabase::table_remove_column);
    ClassDB::bind_method(D_METHOD("table_move_column", "table_name", "from", "to"), &GDDatabase::table_move_column);
+   ClassDB::bind_method(D_METHOD("table_set_column_index", "table_name", "column_index", "type"), &GDDatabase::table_set_column_index);
    ClassDB::bind_method(D_METHOD("table_has_random_setup", "table_name"), &GDDatabase::table_has_random_setup);
    ClassDB::bind_method(D_METHOD("table_insert_row", "table_name", "values", "index"), &GDDatabase::table_insert_row);
+   ClassDB::bind_method(D_METHOD("table_insert_rows", "table_name", "rows", "index"), &GDDatabase::table_insert_rows);
    ClassDB::bind_method(D_METHOD("move_row", "table_name", "from", "to"), &GDDatabase::table_move_row);
    ClassDB::bind_method(D_METHOD("remove_row", "table_name", "index_list"), &GDDatabase::table_remove_row);
    ClassDB::bind_method(D_METHOD("table_set_row_id", "table_name", "row_index", "new_id"), &GDDatabase::table_set_row_id);
    ClassDB::bind_method(D_METHOD("table_sort_rows_by_id", "table_name", "ascending"), &GDDatabase::table_sort_rows_by_id, DEFVAL(true));
    ClassDB::bind_method(D_METHOD("table_sort_rows", "table_name", "column_index", "ascending"), &GDDatabase::table_sort_rows);
+   ClassDB::bind_method(D_METHOD("table_sort_rows_by_columns", "table_name", "column_titles", "ascending"), &GDDatabase::table_sort_rows_by_columns, DEFVAL(Array()));
    ClassDB::bind_method(D_METHOD("table_set_cell_value", "table_name", "column_index", "row_index", "value"), &GDDatabase::table_set_cell_value);
    ClassDB::bind_method(D_METHOD("get_row_from", "table_name", "id", "expand"), &GDDatabase::get_row_from, DEFVAL(false));
    ClassDB::bind_method(D_METHOD("get_row_from_by_index", "table_name", "index", "expand"), &GDDatabase::get_row_from_by_index);
    ClassDB::bind_method(D_METHOD("randomly_pick_row", "table_name", "expand", "random_number_generator"), &GDDatabase::randomly_pick_row, DEFVAL(nullptr));
+   ClassDB::bind_method(D_METHOD("randomly_pick_row_indices", "table_name", "count", "with_replacement", "random_number_generator"), &GDDatabase::randomly_pick_row_indices, DEFVAL(true), DEFVAL(nullptr));
+   ClassDB::bind_method(D_METHOD("randomly_pick_rows", "table_name", "count", "with_replacement", "expand", "random_number_generator"), &GDDatabase::randomly_pick_rows, DEFVAL(true), DEFVAL(false), DEFVAL(nullptr));
+   ClassDB::bind_method(D_METHOD("query_indices", "table_name", "query"), &GDDatabase::query_indices);
+   ClassDB::bind_method(D_METHOD("query_rows", "table_name", "query", "expand"), &GDDatabase::query_rows, DEFVAL(false));
    ClassDB::bind_method(D_METHOD("is_table_referenced_by", "table_name", "other_table"), &GDDatabase::is_table_referenced_by);
    ClassDB::bind_method(D_METHOD("export_to_json", "directory", "monolithic", "indent"), &GDDatabase::export_to_json, DEFVAL(""));
+
+   ClassDB::bind_static_method("GDDatabase", D_METHOD("load_lazy", "path", "memory_budget"), &GDDatabase::load_lazy, DEFVAL(0));
+   ClassDB::bind_method(D_METHOD("is_lazy"), &GDDatabase::is_lazy);
+   ClassDB::bind_method(D_METHOD("is_table_loaded", "table_name"), &GDDatabase::is_table_loaded);
+   ClassDB::bind_method(D_METHOD("unload_unused_tables"), &GDDatabase::unload_unused_tables);
+   ClassDB::bind_method(D_METHOD("get_loaded_memory_usage"), &GDDatabase::get_loaded_memory_usage);
+   ClassDB::bind_method(D_METHOD("set_memory_budget", "bytes"), &GDDatabase::set_memory_budget);
+   ClassDB::bind_method(D_METHOD("get_memory_budget"), &GDDatabase::get_memory_budget);
+
+   ClassDB::bind_method(D_METHOD("load_async", "path"), &GDDatabase::load_async);
+   ClassDB::bind_method(D_METHOD("is_loading"), &GDDatabase::is_loading);
+   ClassDB::bind_method(D_METHOD("get_load_progress"), &GDDatabase::get_load_progress);
+
+   ADD_SIGNAL(MethodInfo("load_progress", PropertyInfo(Variant::INT, "loaded_tables"), PropertyInfo(Variant::INT, "table_count")));
+   ADD_SIGNAL(MethodInfo("load_completed", PropertyInfo(Variant::INT, "error")));
 }
 
 
@@ -192,6 +256,12 @@ bool GDDatabase::save(const godot::String& path, bool include_tables)
       p = get_path();
    }
 
+   // Saving requires every table in memory
+   if (!load_all_tables())
+   {
+      return false;
+   }
+
    if (include_tables)
    {
       const godot::Array k = m_table.keys();
@@ -217,13 +287,16 @@ bool GDDatabase::save(const godot::String& path, bool include_tables)
 }
 
 
-bool GDDatabase::add_table(const godot::StringName& table_name, bool int_id, bool locked_id)
+bool GDDatabase::add_table(const godot::StringName& table_name, bool int_id, bool locked_id, bool dense_id)
 {
    if (has_table(table_name)) { return false; }
 
+   ERR_FAIL_COND_V_MSG(dense_id && !int_id, false, "Dense ID mode requires a table using integer IDs.");
+
    const int id_type = int_id ? godot::Variant::INT : godot::Variant::STRING;
 
    godot::Ref<DBTable> table = godot::Ref<DBTable>(memnew(DBTable(id_type, table_name, locked_id)));
+   table->set_dense_id(dense_id);
    
    return add_table_res(table);
 }
@@ -235,6 +308,11 @@ bool GDDatabase::add_table_res(const godot::Ref<DBTable>& table)
 
    if (has_table(table->get_table_name())) { return false; }
 
+   if (!load_all_tables())
+   {
+      return false;
+   }
+
    m_table[table->get_table_name()] = table;
 
    if (table->get_id_type() == godot::Variant::INT)
@@ -253,12 +331,17 @@ bool GDDatabase::add_table_res(const godot::Ref<DBTable>& table)
 bool GDDatabase::rename_table(const godot::StringName& from, const godot::StringName& to)
 {
    if (from == to) { return true; }
-   if (m_table.has(to))
+   if (has_table(to))
    {
       // Target name already exists. Bail
       return false;
    }
 
+   if (!load_all_tables())
+   {
+      return false;
+   }
+
    godot::Ref<DBTable> table = get_table(from);
    if (!table.is_valid())
    {
@@ -285,8 +368,61 @@ bool GDDatabase::rename_table(const godot::StringName& from, const godot::String
 }
 
 
+godot::PackedStringArray GDDatabase::get_table_list() const
+{
+   if (m_lazy_path.is_empty())
+   {
+      return m_table.keys();
+   }
+
+   // The directory also holds the tables that are not loaded
+   godot::PackedStringArray ret;
+   for (godot::HashMap<godot::StringName, TableEntry>::ConstIterator iter = m_lazy_table.begin(); iter != m_lazy_table.end(); ++iter)
+   {
+      ret.append(iter->key);
+   }
+
+   return ret;
+}
+
+
+godot::Ref<DBTable> GDDatabase::get_table(const godot::StringName& table_name) const
+{
+   godot::Ref<DBTable> ret = m_table.get(table_name, godot::Ref<DBTable>());
+   if (m_lazy_path.is_empty())
+   {
+      return ret;
+   }
+
+   godot::HashMap<godot::StringName, TableEntry>::Iterator iter = m_lazy_table.find(table_name);
+   if (iter == m_lazy_table.end())
+   {
+      return ret;
+   }
+
+   iter->value.last_used = ++m_use_counter;
+
+   if (!ret.is_valid())
+   {
+      ret = load_lazy_table(table_name, true);
+   }
+
+   return ret;
+}
+
+
 bool GDDatabase::remove_table(const godot::StringName& table_name)
 {
+   if (!has_table(table_name))
+   {
+      return false;
+   }
+
+   if (!load_all_tables())
+   {
+      return false;
+   }
+
    godot::Ref<DBTable> table = get_table(table_name);
 
    if (!table.is_valid())
@@ -343,6 +479,8 @@ int64_t GDDatabase::table_insert_column(const godot::StringName& table_name, con
       return -1;
    }
 
+   set_table_modified(table_name);
+
    if (table->has_column(column_title))
    {
       return -1;
@@ -352,6 +490,12 @@ int64_t GDDatabase::table_insert_column(const godot::StringName& table_name, con
    godot::String ext = external;
    if (type == DBTable::VT_ExternalString || type == DBTable::VT_ExternalInteger)
    {
+      // Linking tables changes the directory, so leave lazy mode
+      if (!load_all_tables())
+      {
+         return -1;
+      }
+
       if (ext.is_empty() || !m_table.has(ext))
       {
          if (ext.is_empty())
@@ -401,6 +545,8 @@ bool GDDatabase::table_rename_column(const godot::StringName& table_name, int64_
       return false;
    }
 
+   set_table_modified(table_name);
+
    if (table->has_column(to))
    {
       return false;
@@ -418,12 +564,19 @@ bool GDDatabase::table_remove_column(const godot::StringName& table_name, int64_
       return false;
    }
 
+   set_table_modified(table_name);
+
    DBTable::ColumnInfo cinfo;
    if (!table->fill_column_info(column_index, cinfo))
    {
       return false;
    }
 
+   if (!cinfo.external_table.is_empty() && !load_all_tables())
+   {
+      return false;
+   }
+
    const bool ret = table->remove_column(column_index);
 
    if (ret && !cinfo.external_table.is_empty())
@@ -444,6 +597,8 @@ bool GDDatabase::table_move_column(const godot::StringName& table_name, int64_t
       return false;
    }
 
+   set_table_modified(table_name);
+
    return table->move_column(from, to);
 }
 
@@ -456,10 +611,27 @@ bool GDDatabase::table_change_column_value_type(const godot::StringName& table_n
       return false;
    }
 
+   set_table_modified(table_name);
+
    return table->change_column_value_type(column_index, to_type);
 }
 
 
+bool GDDatabase::table_set_column_index(const godot::StringName& table_name, int64_t column_index, DBTable::IndexType type)
+{
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid())
+   {
+      return false;
+   }
+
+   set_table_modified(table_name);
+
+   ERR_FAIL_INDEX_V(column_index, table->get_column_count(), false);
+   return table->set_column_index(table->get_column_title(column_index), type);
+}
+
+
 bool GDDatabase::table_has_random_setup(const godot::StringName& table_name) const
 {
    godot::Ref<DBTable> table = get_table(table_name);
@@ -480,9 +652,25 @@ int64_t GDDatabase::table_insert_row(const godot::StringName& table_name, const
       return -1;
    }
 
+   set_table_modified(table_name);
+
    return table->add_row(values, index);
 }
 
+
+int64_t GDDatabase::table_insert_rows(const godot::StringName& table_name, const godot::Array& rows, int64_t index)
+{
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid())
+   {
+      return -1;
+   }
+
+   set_table_modified(table_name);
+
+   return table->add_rows(rows, index);
+}
+
 bool GDDatabase::table_move_row(const godot::StringName& table_name, int64_t from, int64_t to)
 {
    godot::Ref<DBTable> table = get_table(table_name);
@@ -491,6 +679,8 @@ bool GDDatabase::table_move_row(const godot::StringName& table_name, int64_t fro
       return false;
    }
 
+   set_table_modified(table_name);
+
    return table->move_row(from, to);
 }
 
@@ -503,13 +693,11 @@ bool GDDatabase::table_remove_row(const godot::StringName& table_name, const god
       return false;
    }
 
-   // The index list must be sorted and iterated in reverse order. To ensure it's indeed sorted, copy it then perform the operation
-   godot::PackedInt64Array ilist = index_list;
-   ilist.sort();
+   set_table_modified(table_name);
 
    // If another table is referencing 'table_name' then that other must be updated as some of its cell may be pointing to the
    // row(s) being removed. The way this will happen here follows:
-   // - For each row to be removed, its ID will be stored within a Set
+   // - While the rows are removed, their IDs will be stored within a Set
    // - Once every row is removed, use the list of tables referencing the 'table_name' and 'notify' each one that the rows within the
    //   provided Set have been removed
    // - The referencing table should then go through each cell in the corresponding column checking if the value is within the provided
@@ -519,15 +707,11 @@ bool GDDatabase::table_remove_row(const godot::StringName& table_name, const god
    // The Set holding removed rows. Since row ID can be either String or Integer, holding IDs as godot::Variant
    DBTable::ValueSetType rem_set;
 
-   for (int64_t i = ilist.size() - 1; i >= 0; i--)
+   // All rows are removed in a single pass. There is no need to fill the rem_set if there is no referencing table
+   const int64_t rem_count = table->remove_rows_by_index(index_list, reflist.size() > 0 ? &rem_set : nullptr);
+   if (rem_count == 0)
    {
-      // There is no need to fill the rem_set if there is no referencing table
-      if (reflist.size() > 0)
-      {
-         rem_set.insert(ilist[i]);
-      }
-
-      table->remove_row_by_index(ilist[i]);
+      return false;
    }
 
    if (rem_set.size() > 0)
@@ -537,6 +721,7 @@ bool GDDatabase::table_remove_row(const godot::StringName& table_name, const god
       {
          godot::Ref<DBTable> reftable = get_table(reflist[i]);
          reftable->referenced_rows_removed(table_name, rem_set);
+         set_table_modified(reflist[i]);
       }
    }
 
@@ -552,6 +737,8 @@ bool GDDatabase::table_set_row_id(const godot::StringName& table_name, int64_t r
       return false;
    }
 
+   set_table_modified(table_name);
+
    // First hold current ID as it may be necessary to update referencing tables (if any)
    const godot::Variant& old_id = table->get_row_id(row_index);
 
@@ -574,6 +761,7 @@ bool GDDatabase::table_set_row_id(const godot::StringName& table_name, int64_t r
          }
 
          reftable->referenced_row_id_changed(table_name, old_id, new_id);
+         set_table_modified(reflist[i]);
       }
    }
 
@@ -589,6 +777,8 @@ bool GDDatabase::table_sort_rows_by_id(const godot::StringName& table_name, bool
       return false;
    }
 
+   set_table_modified(table_name);
+
    table->sort_by_id(ascending);
    return true;
 }
@@ -602,10 +792,26 @@ bool GDDatabase::table_sort_rows(const godot::StringName& table_name, int64_t co
       return false;
    }
 
+   set_table_modified(table_name);
+
    return table->sort_by_column(column_index, ascending);
 }
 
 
+bool GDDatabase::table_sort_rows_by_columns(const godot::StringName& table_name, const godot::PackedStringArray& column_titles, const godot::Array& ascending)
+{
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid())
+   {
+      return false;
+   }
+
+   set_table_modified(table_name);
+
+   return table->sort_by_columns(column_titles, ascending);
+}
+
+
 bool GDDatabase::table_set_cell_value(const godot::StringName& table_name, int64_t column_index, int64_t row_index, const godot::Variant& value)
 {
    godot::Ref<DBTable> table = get_table(table_name);
@@ -614,6 +820,8 @@ bool GDDatabase::table_set_cell_value(const godot::StringName& table_name, int64
       return false;
    }
 
+   set_table_modified(table_name);
+
    return table->set_value_by_index(column_index, row_index, value);
 }
 
@@ -676,6 +884,88 @@ godot::Dictionary GDDatabase::randomly_pick_row(const godot::StringName& table_n
 }
 
 
+godot::PackedInt64Array GDDatabase::randomly_pick_row_indices(const godot::StringName& table_name, int64_t count, bool with_replacement, const godot::Ref<godot::RandomNumberGenerator>& rng) const
+{
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid())
+   {
+      return godot::PackedInt64Array();
+   }
+
+   return table->pick_random_rows(count, with_replacement, rng);
+}
+
+
+godot::Array GDDatabase::randomly_pick_rows(const godot::StringName& table_name, int64_t count, bool with_replacement, bool expand, const godot::Ref<godot::RandomNumberGenerator>& rng) const
+{
+   godot::Array ret;
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid())
+   {
+      return ret;
+   }
+
+   const godot::PackedInt64Array index_list = table->pick_random_rows(count, with_replacement, rng);
+   const int64_t icount = index_list.size();
+
+   ret.resize(icount);
+   for (int64_t i = 0; i < icount; i++)
+   {
+      godot::Dictionary row = table->make_row(index_list[i]);
+
+      if (expand)
+      {
+         expand_row_cell(table, row);
+      }
+
+      ret[i] = row;
+   }
+
+   return ret;
+}
+
+
+godot::PackedInt64Array GDDatabase::query_indices(const godot::StringName& table_name, const godot::Ref<DBQuery>& query) const
+{
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid() || !query.is_valid())
+   {
+      return godot::PackedInt64Array();
+   }
+
+   return query->find_indices(table);
+}
+
+
+godot::Array GDDatabase::query_rows(const godot::StringName& table_name, const godot::Ref<DBQuery>& query, bool expand) const
+{
+   godot::Array ret;
+   godot::Ref<DBTable> table = get_table(table_name);
+   if (!table.is_valid() || !query.is_valid())
+   {
+      return ret;
+   }
+
+   const godot::PackedInt64Array index_list = query->find_indices(table);
+   const int64_t icount = index_list.size();
+
+   ret.resize(icount);
+   for (int64_t i = 0; i < icount; i++)
+   {
+      godot::Dictionary row = query->make_row(*table.ptr(), index_list[i]);
+
+      if (expand)
+      {
+         expand_row_cell(table, row);
+      }
+
+      ret[i] = row;
+   }
+
+   return ret;
+}
+
+
 bool GDDatabase::is_table_referenced_by(const godot::StringName& table_name, const godot::StringName& other_table) const
 {
    ERR_FAIL_COND_V_MSG(!has_table(table_name) || !has_table(other_table), false, "While attempting to check if a table references another, both must exist in the Database.");
@@ -771,6 +1061,11 @@ bool GDDatabase::is_table_referenced_by(const godot::StringName& table_name, con
 
 void GDDatabase::export_to_json(const godot::String& directory, bool monolithic, const godot::String& indent) const
 {
+   if (!load_all_tables())
+   {
+      return;
+   }
+
    const godot::Array tbkeys = m_table.keys();
    const int64_t tcount = tbkeys.size();
 
@@ -790,7 +1085,7 @@ void GDDatabase::export_to_json(const godot::String& directory, bool monolithic,
          tbl_out["table"] = table->get_table_name();
 
          // GDDatabase is declared as friend of DBTable. Yes, I know the line bellow is not the ideal thing, but...
-         tbl_out["rows"] = table->m_row_list;
+         tbl_out["rows"] = table->get_row_list();
 
          data.append(tbl_out);
       }
@@ -817,7 +1112,7 @@ void GDDatabase::export_to_json(const godot::String& directory, bool monolithic,
 
          godot::Dictionary out;
          out["table"] = table->get_table_name();
-         out["rows"] = table->m_row_list;
+         out["rows"] = table->get_row_list();
 
          const godot::String fname = godot::vformat("%s.json", table->get_table_name());
          godot::Ref<godot::FileAccess> file = godot::FileAccess::open(directory.path_join(fname), godot::FileAccess::WRITE);
@@ -838,6 +1133,8 @@ godot::Dictionary GDDatabase::get_db_info() const
    godot::Dictionary ret;
    godot::Array table_data;
 
+   load_all_tables();
+
    const godot::Array k = m_table.keys();
    const int ks = k.size();
    for (int i = 0; i < ks; i++)
@@ -871,6 +1168,46 @@ godot::Dictionary GDDatabase::get_db_info() const
 }
 
 
+void GDDatabase::unload_unused_tables()
+{
+   if (m_lazy_path.is_empty())
+   {
+      return;
+   }
+
+   const godot::Array name_list = m_table.keys();
+   for (int64_t i = 0; i < name_list.size(); i++)
+   {
+      if (can_unload_table(name_list[i]))
+      {
+         m_table.erase(name_list[i]);
+      }
+   }
+}
+
+
+int64_t GDDatabase::get_loaded_memory_usage() const
+{
+   int64_t ret = 0;
+
+   const godot::Array table_list = m_table.values();
+   for (int64_t i = 0; i < table_list.size(); i++)
+   {
+      const DBTable* table = godot::Object::cast_to<DBTable>((godot::Object*)table_list[i]);
+      ret += table->get_data_memory_usage();
+   }
+
+   return ret;
+}
+
+
+void GDDatabase::set_memory_budget(int64_t bytes)
+{
+   m_memory_budget = MAX(bytes, int64_t(0));
+   enforce_memory_budget(godot::StringName());
+}
+
+
 void GDDatabase::fill_external_candidates_for(int type, const godot::StringName& table_name, godot::PackedStringArray& out_list) const
 {
    godot::Ref<DBTable> table = get_table(table_name);
@@ -944,19 +1281,528 @@ godot::Dictionary GDDatabase::get_row_from_patched(const godot::Ref<DBTable>& pa
 }
 
 
+// Binary format (.gddb) layout. Every block starts at a multiple of 8 bytes
+// - Header: magic (4 bytes), format version (u32), table count (u64) and the size of header plus directory (u64)
+// - Table directory, one entry per table: offset (u64) and size (u64) of the table block, ID type (u32), then the table
+//   name and the names of the tables it references. This is enough to setup the database without loading the tables
+// - Table blocks, as written by DBTable::write_binary()
+static const char GDDB_MAGIC[4] = { 'G', 'D', 'D', 'B' };
+static const uint32_t GDDB_VERSION = 1;
+static const int64_t GDDB_HEADER_SIZE = 24;
+
+
+godot::Error GDDatabase::read_directory(const uint8_t* data, int64_t size, godot::Vector<TableEntry>& out_list, int64_t& out_size)
+{
+   DBBinaryReader reader(data, size);
+
+   char magic[sizeof(GDDB_MAGIC)];
+   reader.read_bytes(magic, sizeof(GDDB_MAGIC));
+   const uint32_t version = reader.read_u32();
+   const uint64_t tb_count = reader.read_u64();
+   const uint64_t dir_size = reader.read_u64();
+
+   ERR_FAIL_COND_V_MSG(reader.has_error() || memcmp(magic, GDDB_MAGIC, sizeof(GDDB_MAGIC)) != 0, godot::ERR_FILE_UNRECOGNIZED, "Attempting to decode data that is not a binary database.");
+   ERR_FAIL_COND_V_MSG(version > GDDB_VERSION, godot::ERR_FILE_UNRECOGNIZED, godot::vformat("Binary database format version %d is not supported.", version));
+   ERR_FAIL_COND_V_MSG(dir_size > uint64_t(size), godot::ERR_FILE_CORRUPT, "Binary database table directory is truncated.");
+
+   out_list.clear();
+   for (uint64_t i = 0; i < tb_count; i++)
+   {
+      TableEntry entry;
+      entry.offset = reader.read_u64();
+      entry.size = reader.read_u64();
+      entry.id_type = reader.read_u32();
+      reader.read_u32();
+      entry.name = reader.read_string();
+
+      const uint32_t ref_count = reader.read_u32();
+      for (uint32_t r = 0; r < ref_count && !reader.has_error(); r++)
+      {
+         entry.reference_list.append(reader.read_string());
+      }
+      reader.align();
+      entry.last_used = 0;
+      entry.modified = false;
+
+      ERR_FAIL_COND_V_MSG(reader.has_error() || reader.get_position() > int64_t(dir_size), godot::ERR_FILE_CORRUPT, "Binary database table directory is truncated.");
+
+      out_list.push_back(entry);
+   }
+
+   out_size = dir_size;
+   return godot::OK;
+}
+
+
+godot::Ref<DBTable> GDDatabase::decode_table(const uint8_t* data, int64_t size)
+{
+   DBBinaryReader reader(data, size);
+   godot::Ref<DBTable> table = godot::Ref<DBTable>(memnew(DBTable));
+   if (!table->read_binary(reader))
+   {
+      return godot::Ref<DBTable>();
+   }
+
+   return table;
+}
+
+
+godot::Error GDDatabase::read_file_directory(const godot::String& path, godot::Vector<TableEntry>& out_list)
+{
+   godot::Ref<godot::FileAccess> file = godot::FileAccess::open(path, godot::FileAccess::READ);
+   ERR_FAIL_COND_V_MSG(file.is_null(), godot::ERR_FILE_CANT_OPEN, "Cannot open database file '" + path + "'.");
+
+   // The header tells how big the directory is
+   const godot::PackedByteArray header = file->get_buffer(GDDB_HEADER_SIZE);
+   ERR_FAIL_COND_V_MSG(header.size() != GDDB_HEADER_SIZE, godot::ERR_FILE_UNRECOGNIZED, "File '" + path + "' is not a binary database.");
+
+   uint64_t dir_size = 0;
+   memcpy(&dir_size, header.ptr() + GDDB_HEADER_SIZE - sizeof(uint64_t), sizeof(uint64_t));
+   ERR_FAIL_COND_V_MSG(dir_size < uint64_t(GDDB_HEADER_SIZE) || dir_size > file->get_length(), godot::ERR_FILE_CORRUPT, "File '" + path + "' is not a valid binary database.");
+
+   file->seek(0);
+   const godot::PackedByteArray data = file->get_buffer(dir_size);
+
+   int64_t read_size = 0;
+   return read_directory(data.ptr(), data.size(), out_list, read_size);
+}
+
+
+godot::Ref<DBTable> GDDatabase::read_table_block(const godot::String& path, const TableEntry& entry)
+{
+   godot::Ref<godot::FileAccess> file = godot::FileAccess::open(path, godot::FileAccess::READ);
+   ERR_FAIL_COND_V_MSG(file.is_null(), godot::Ref<DBTable>(), godot::vformat("Cannot open database file '%s' to load table '%s'.", path, entry.name));
+
+   // Directory entries come from the file, so make sure the block is within it before allocating anything
+   const uint64_t file_size = file->get_length();
+   ERR_FAIL_COND_V_MSG(entry.offset > file_size || entry.size > file_size - entry.offset, godot::Ref<DBTable>(), godot::vformat("Block of table '%s' is out of bounds of database file '%s'.", entry.name, path));
+
+   // Only the block of the requested table is read
+   file->seek(entry.offset);
+   const godot::PackedByteArray data = file->get_buffer(entry.size);
+   ERR_FAIL_COND_V_MSG(uint64_t(data.size()) != entry.size, godot::Ref<DBTable>(), godot::vformat("Database file '%s' is truncated, cannot load table '%s'.", path, entry.name));
+
+   godot::Ref<DBTable> table = decode_table(data.ptr(), data.size());
+   ERR_FAIL_COND_V_MSG(!table.is_valid(), godot::Ref<DBTable>(), godot::vformat("Failed to decode table '%s' from database file '%s'.", entry.name, path));
+
+   return table;
+}
+
+
+godot::Ref<DBTable> GDDatabase::load_lazy_table(const godot::StringName& table_name, bool enforce_budget) const
+{
+   godot::HashMap<godot::StringName, TableEntry>::ConstIterator iter = m_lazy_table.find(table_name);
+   if (iter == m_lazy_table.end())
+   {
+      return godot::Ref<DBTable>();
+   }
+
+   godot::Ref<DBTable> table = read_table_block(m_lazy_path, iter->value);
+   if (!table.is_valid())
+   {
+      return table;
+   }
+
+   // Tables referencing this one come from the directory, which also covers those that are not loaded
+   for (godot::HashMap<godot::StringName, TableEntry>::ConstIterator other = m_lazy_table.begin(); other != m_lazy_table.end(); ++other)
+   {
+      if (other->value.reference_list.has(table_name))
+      {
+         table->add_referencer(other->key);
+      }
+   }
+
+   m_table[table_name] = table;
+
+   if (enforce_budget)
+   {
+      enforce_memory_budget(table_name);
+   }
+
+   return table;
+}
+
+
+void GDDatabase::enforce_memory_budget(const godot::StringName& keep) const
+{
+   if (m_lazy_path.is_empty() || m_memory_budget <= 0)
+   {
+      return;
+   }
+
+   const godot::Array name_list = m_table.keys();
+   const int64_t tb_count = name_list.size();
+
+   godot::Vector<int64_t> usage;
+   usage.resize(tb_count);
+
+   int64_t total = 0;
+   for (int64_t i = 0; i < tb_count; i++)
+   {
+      const DBTable* table = godot::Object::cast_to<DBTable>((godot::Object*)m_table[name_list[i]]);
+      usage.ptrw()[i] = table->get_data_memory_usage();
+      total += usage[i];
+   }
+
+   while (total > m_memory_budget)
+   {
+      // Locate the least recently used table that can be unloaded
+      int64_t pick = -1;
+      uint64_t pick_used = 0;
+      for (int64_t i = 0; i < tb_count; i++)
+      {
+         const godot::StringName tbname = name_list[i];
+         if (usage[i] < 0 || tbname == keep)
+         {
+            continue;
+         }
+
+         if (!can_unload_table(tbname))
+         {
+            continue;
+         }
+
+         const uint64_t used = m_lazy_table.has(tbname) ? m_lazy_table[tbname].last_used : 0;
+         if (pick == -1 || used < pick_used)
+         {
+            pick = i;
+            pick_used = used;
+         }
+      }
+
+      if (pick == -1)
+      {
+         // Everything else is in use
+         break;
+      }
+
+      total -= usage[pick];
+      usage.ptrw()[pick] = -1;
+      m_table.erase(name_list[pick]);
+   }
+}
+
+
+void GDDatabase::set_table_modified(const godot::StringName& table_name)
+{
+   godot::HashMap<godot::StringName, TableEntry>::Iterator iter = m_lazy_table.find(table_name);
+   if (iter != m_lazy_table.end())
+   {
+      iter->value.modified = true;
+   }
+}
+
+
+bool GDDatabase::can_unload_table(const godot::StringName& table_name) const
+{
+   godot::HashMap<godot::StringName, TableEntry>::ConstIterator iter = m_lazy_table.find(table_name);
+   if (iter != m_lazy_table.end() && iter->value.modified)
+   {
+      return false;
+   }
+
+   // Only the Dictionary holds a reference to it, so nothing is using the table
+   const DBTable* table = godot::Object::cast_to<DBTable>((godot::Object*)m_table[table_name]);
+   return table && table->get_reference_count() <= 1;
+}
+
+
+bool GDDatabase::load_all_tables() const
+{
+   if (m_lazy_path.is_empty())
+   {
+      return true;
+   }
+
+   bool failed = false;
+   for (godot::HashMap<godot::StringName, TableEntry>::ConstIterator iter = m_lazy_table.begin(); iter != m_lazy_table.end(); ++iter)
+   {
+      if (!m_table.has(iter->key) && !load_lazy_table(iter->key, false).is_valid())
+      {
+         failed = true;
+      }
+   }
+
+   // Leaving lazy mode without every table would drop the ones that failed from the database
+   ERR_FAIL_COND_V_MSG(failed, false, godot::vformat("Failed to load every table from '%s', the database remains in lazy mode.", m_lazy_path));
+
+   // Referencers were set from the directory while loading, so there is no need to setup the tables again
+   m_lazy_path = "";
+   m_lazy_table.clear();
+
+   return true;
+}
+
+
+godot::PackedByteArray GDDatabase::encode_binary() const
+{
+   if (!load_all_tables())
+   {
+      return godot::PackedByteArray();
+   }
+
+   const godot::Array name_list = m_table.keys();
+   const int64_t tb_count = name_list.size();
+
+   DBBinaryWriter writer;
+   writer.write_bytes(GDDB_MAGIC, sizeof(GDDB_MAGIC));
+   writer.write_u32(GDDB_VERSION);
+   writer.write_u64(tb_count);
+   writer.write_u64(0);
+
+   // Offsets and sizes are only known after writing the tables, so keep where each directory entry is
+   godot::Vector<int64_t> entry;
+   entry.resize(tb_count);
+   for (int64_t i = 0; i < tb_count; i++)
+   {
+      const godot::Ref<DBTable> table = m_table[name_list[i]];
+      const godot::PackedStringArray reflist = table->get_reference_list();
+
+      entry.ptrw()[i] = writer.get_position();
+      writer.write_u64(0);
+      writer.write_u64(0);
+      writer.write_u32(table->get_id_type());
+      writer.write_u32(0);
+      writer.write_string(name_list[i]);
+
+      writer.write_u32(reflist.size());
+      for (int64_t r = 0; r < reflist.size(); r++)
+      {
+         writer.write_string(reflist[r]);
+      }
+      writer.align();
+   }
+   writer.patch_u64(GDDB_HEADER_SIZE - sizeof(uint64_t), writer.get_position());
+
+   for (int64_t i = 0; i < tb_count; i++)
+   {
+      const godot::Ref<DBTable> table = m_table[name_list[i]];
+      const int64_t offset = writer.get_position();
+
+      table->write_binary(writer);
+      writer.align();
+
+      writer.patch_u64(entry[i], offset);
+      writer.patch_u64(entry[i] + sizeof(uint64_t), writer.get_position() - offset);
+   }
+
+   return writer.get_data();
+}
+
+
+godot::Error GDDatabase::decode_binary(const godot::PackedByteArray& data)
+{
+   godot::Vector<TableEntry> directory;
+   int64_t dir_size = 0;
+   const godot::Error err = read_directory(data.ptr(), data.size(), directory, dir_size);
+   if (err != godot::OK)
+   {
+      return err;
+   }
+
+   godot::Dictionary table_list;
+   const int64_t tb_count = directory.size();
+   for (int64_t i = 0; i < tb_count; i++)
+   {
+      const TableEntry& entry = directory[i];
+      ERR_FAIL_COND_V_MSG(entry.offset > uint64_t(data.size()) || entry.size > uint64_t(data.size()) - entry.offset, godot::ERR_FILE_CORRUPT, godot::vformat("Binary database block of table '%s' is out of bounds.", entry.name));
+
+      // Each table gets its own reader, limited to its block
+      godot::Ref<DBTable> table = decode_table(data.ptr() + entry.offset, entry.size);
+      ERR_FAIL_COND_V_MSG(!table.is_valid(), godot::ERR_FILE_CORRUPT, godot::vformat("Failed to decode table '%s' from binary database.", entry.name));
+
+      table_list[table->get_table_name()] = table;
+   }
+
+   m_lazy_path = "";
+   m_lazy_table.clear();
+   m_table = table_list;
+   check_table_setup();
+
+   return godot::OK;
+}
+
+
+godot::Ref<GDDatabase> GDDatabase::load_lazy(const godot::String& path, int64_t memory_budget)
+{
+   godot::Vector<TableEntry> directory;
+   if (read_file_directory(path, directory) != godot::OK)
+   {
+      return godot::Ref<GDDatabase>();
+   }
+
+   godot::Ref<GDDatabase> db = godot::Ref<GDDatabase>(memnew(GDDatabase));
+   db->m_lazy_path = path;
+   db->m_memory_budget = MAX(memory_budget, int64_t(0));
+   for (int64_t i = 0; i < directory.size(); i++)
+   {
+      db->m_lazy_table.insert(directory[i].name, directory[i]);
+   }
+   db->check_table_setup();
+
+   return db;
+}
+
+
+void GDDatabase::async_load_table(uint32_t index)
+{
+   m_async.result.ptrw()[index] = read_table_block(m_async.path, m_async.directory[index]);
+
+   const uint32_t count = m_async.directory.size();
+   const uint32_t done = m_async.done.increment();
+
+   // Signals must be emitted from the main thread. The counter is read there, as this task might be preempted before
+   // deferring the call, which could then end up after the one of the task finishing last
+   callable_mp(this, &GDDatabase::emit_async_progress).call_deferred();
+
+   if (done == count)
+   {
+      callable_mp(this, &GDDatabase::finish_async_load).call_deferred();
+   }
+}
+
+
+void GDDatabase::emit_async_progress()
+{
+   if (!m_async.running)
+   {
+      return;
+   }
+
+   const uint32_t done = m_async.done.get();
+   if (done <= m_async.reported)
+   {
+      return;
+   }
+
+   m_async.reported = done;
+   emit_signal("load_progress", int64_t(done), int64_t(m_async.directory.size()));
+}
+
+
+void GDDatabase::finish_async_load()
+{
+   if (m_async.group_id >= 0)
+   {
+      // Every task is done at this point, but the group must still be waited so the pool releases it
+      godot::WorkerThreadPool::get_singleton()->wait_for_group_task_completion(m_async.group_id);
+   }
+
+   godot::Error err = godot::OK;
+   godot::Dictionary table_list;
+
+   const int64_t tb_count = m_async.result.size();
+   for (int64_t i = 0; i < tb_count; i++)
+   {
+      const godot::Ref<DBTable> table = m_async.result[i];
+      if (!table.is_valid())
+      {
+         err = godot::ERR_FILE_CORRUPT;
+         break;
+      }
+
+      table_list[table->get_table_name()] = table;
+   }
+
+   if (err == godot::OK)
+   {
+      m_lazy_path = "";
+      m_lazy_table.clear();
+      m_table = table_list;
+      check_table_setup();
+   }
+
+   // The reference must outlive the signal emission as it might be the last one
+   const godot::Ref<GDDatabase> keep_alive = m_async.keep_alive;
+
+   // Progress deferred by tasks may still be pending, but those are ignored once the load is not running. So report the
+   // final count here, making sure it arrives before the completion
+   const uint32_t count = m_async.directory.size();
+   if (m_async.reported < count)
+   {
+      m_async.reported = count;
+      emit_signal("load_progress", int64_t(count), int64_t(count));
+   }
+
+   m_async.path = "";
+   m_async.directory.clear();
+   m_async.result.clear();
+   m_async.group_id = -1;
+   m_async.keep_alive.unref();
+   m_async.running = false;
+
+   emit_signal("load_completed", int64_t(err));
+}
+
+
+godot::Error GDDatabase::load_async(const godot::String& path)
+{
+   ERR_FAIL_COND_V_MSG(m_async.running, godot::ERR_BUSY, "Attempting to load a database while a previous load is still running.");
+
+   // The directory is small, so it's read right away. This also catches invalid files before starting any task
+   godot::Vector<TableEntry> directory;
+   const godot::Error err = read_file_directory(path, directory);
+   if (err != godot::OK)
+   {
+      return err;
+   }
+
+   const uint32_t tb_count = directory.size();
+
+   m_async.path = path;
+   m_async.directory = directory;
+   m_async.result.clear();
+   m_async.result.resize(tb_count);
+   m_async.done.set(0);
+   m_async.reported = 0;
+   m_async.group_id = -1;
+   m_async.keep_alive = godot::Ref<GDDatabase>(this);
+   m_async.running = true;
+
+   if (tb_count == 0)
+   {
+      callable_mp(this, &GDDatabase::finish_async_load).call_deferred();
+      return godot::OK;
+   }
+
+   // The result entries are written by the tasks, so make sure the array is not shared before those start
+   m_async.result.ptrw();
+
+   m_async.group_id = godot::WorkerThreadPool::get_singleton()->add_group_task(callable_mp(this, &GDDatabase::async_load_table), tb_count, -1, false, "Load GDDatabase tables");
+
+   return godot::OK;
+}
+
+
+double GDDatabase::get_load_progress() const
+{
+   const int64_t tb_count = m_async.directory.size();
+   if (!m_async.running || tb_count == 0)
+   {
+      return 1.0;
+   }
+
+   return double(m_async.done.get()) / double(tb_count);
+}
+
+
 GDDatabase::GDDatabase()
 {
    m_table = godot::Dictionary();
+   m_use_counter = 0;
+   m_memory_budget = 0;
+   m_async.group_id = -1;
+   m_async.reported = 0;
+   m_async.running = false;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// ResourceFormatLoaderGDDatabase
-/*godot::PackedStringArray ResourceFormatLoaderGDDatabase::_get_recognized_extensions() const
+godot::PackedStringArray ResourceFormatLoaderGDDatabase::_get_recognized_extensions() const
 {
    godot::PackedStringArray ret;
-   ret.push_back("tgddb");       // Text format
    ret.push_back("gddb");        // Binary format
    return ret;
 }
@@ -969,7 +1815,7 @@ bool ResourceFormatLoaderGDDatabase::_handles_type(const godot::StringName& type
 godot::String ResourceFormatLoaderGDDatabase::_get_resource_type(const godot::String& path) const
 {
    const godot::String exl = path.get_extension().to_lower();
-   if (exl == "tgddb" || exl == "gddb")
+   if (exl == "gddb")
    {
       return "GDDatabase";
    }
@@ -979,32 +1825,38 @@ godot::String ResourceFormatLoaderGDDatabase::_get_resource_type(const godot::St
 
 godot::Variant ResourceFormatLoaderGDDatabase::_load(const godot::String& path, const godot::String& original_path, bool use_sub_threads, int32_t cache_mode) const
 {
-   const godot::String exl = path.get_extension().to_lower();
+   // The entire file is read in one go. Tables then copy their typed blocks directly from this buffer
+   const godot::PackedByteArray data = godot::FileAccess::get_file_as_bytes(path);
+   ERR_FAIL_COND_V_MSG(data.size() == 0, godot::Variant(int64_t(godot::ERR_FILE_CANT_OPEN)), "Cannot open database file '" + path + "'.");
 
-   godot::UtilityFunctions::print(godot::vformat("Loading GDDatabase. Is it in binary? %s", exl == "gddb"));
+   godot::Ref<GDDatabase> db = godot::Ref<GDDatabase>(memnew(GDDatabase));
+   const godot::Error err = db->decode_binary(data);
+   if (err != godot::OK)
+   {
+      return godot::Variant(int64_t(err));
+   }
 
-   return godot::Variant();
-}*/
+   return db;
+}
 
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// ResourceFormatSaverGDDatabase
-/*godot::Error ResourceFormatSaverGDDatabase::_save(const godot::Ref<godot::Resource>& resource, const godot::String& path, uint32_t flags)
+godot::Error ResourceFormatSaverGDDatabase::_save(const godot::Ref<godot::Resource>& resource, const godot::String& path, uint32_t flags)
 {
-   godot::Error err;
-   godot::Ref<godot::FileAccess> file = godot::FileAccess::open(path, godot::FileAccess::WRITE);
-   err = godot::FileAccess::get_open_error();
-   ERR_FAIL_COND_V_MSG(err, godot::Error::ERR_CANT_OPEN, "Cannot save database file '" + path + "'.");
-
+   godot::Ref<GDDatabase> db = resource;
+   ERR_FAIL_COND_V_MSG(!db.is_valid(), godot::ERR_INVALID_PARAMETER, "Attempting to save a resource that is not a GDDatabase as '" + path + "'.");
 
-   // Write "header" - title
-   {
-      godot::String title = "[gd_resource type=\"GDDatabase\" format=1]\n";
+   // Encode before opening the file so a failure doesn't leave a truncated file behind
+   const godot::PackedByteArray data = db->encode_binary();
+   ERR_FAIL_COND_V_MSG(data.is_empty(), godot::ERR_FILE_CORRUPT, "Failed to encode the database to be saved as '" + path + "'.");
 
-      file->store_string(title);
-   }
+   godot::Ref<godot::FileAccess> file = godot::FileAccess::open(path, godot::FileAccess::WRITE);
+   ERR_FAIL_COND_V_MSG(file.is_null(), godot::Error::ERR_CANT_OPEN, "Cannot save database file '" + path + "'.");
 
+   file->store_buffer(data);
+   file->close();
 
    return godot::OK;
 }
@@ -1015,7 +1867,6 @@ godot::PackedStringArray ResourceFormatSaverGDDatabase::_get_recognized_extensio
    godot::Ref<GDDatabase> db = resource;
    if (db.is_valid())
    {
-      ret.push_back("tgddb");
       ret.push_back("gddb");
    }
 
@@ -1029,8 +1880,7 @@ bool ResourceFormatSaverGDDatabase::_recognize(const godot::Ref<godot::Resource>
    // Unfortunately "get_class_name()" does not exist in extension space. So...
    godot::Ref<GDDatabase> db = resource;
    return db.is_valid();
-}*/
-
+}
 
 
 
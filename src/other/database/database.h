@@ -27,8 +27,12 @@
 #ifndef DATABASE_DISABLED
 
 #include "dbtable.h"
+#include "dbquery.h"
 
 #include <godot_cpp/classes/resource.hpp>
+#include <godot_cpp/classes/resource_format_loader.hpp>
+#include <godot_cpp/classes/resource_format_saver.hpp>
+#include <godot_cpp/templates/safe_refcount.hpp>
 
 /// Regarding the storage of the data. There are two options, which are shown bellow with "pros" and "cons".
 /// 1) Use godot::Dictionary and godot::Array to store the data.
@@ -66,6 +70,11 @@
 /// which is to implement the EditorExportPlugin. The "cost" becomes even higher considering the low amount of information
 /// regarding this system. My initial attempts to make the plugin work simply failed, so the implementation here
 /// is going with option (1)
+///
+/// Later on a binary format (.gddb) has been added through the ResourceFormatLoaderGDDatabase and
+/// ResourceFormatSaverGDDatabase. It doesn't replace option (1), which still handles .tres and .res files. Instead it
+/// writes the typed column storage and the prebuilt indexes of each table as they are, so loading is a single bulk read
+/// followed by a few memory copies per column. Being binary already, no export plugin is required for it.
 
 
 
@@ -77,7 +86,9 @@ private:
    // Key = StringName holding DBTable name
    // Value = Instance of DBTable. More specifically, a Ref<DBTable>
    // Using Dictionary to take advantage of automatic Resource save/load system
-   godot::Dictionary m_table;
+   // In lazy mode this holds only the tables that are currently loaded. Tables are loaded when requested, even from
+   // const functions, which is why this is mutable
+   mutable godot::Dictionary m_table;
    
    // The next two containers are dynamically generated and not stored. They are mostly used to help keep internal structure of
    // the DB consistent (as well as to provide some data to external code). The first is used to store table names that use
@@ -85,11 +96,102 @@ private:
    godot::Vector<godot::StringName> m_strid_list;
    godot::Vector<godot::StringName> m_intid_list;
 
+   // Entry of the table directory of a binary database
+   struct TableEntry
+   {
+      godot::StringName name;
+
+      // Location of the table block within the file
+      uint64_t offset;
+      uint64_t size;
+
+      int id_type;
+
+      // Names of the tables referenced by this one
+      godot::PackedStringArray reference_list;
+
+      // Value of the use counter when the table was last requested. Least recently used tables are unloaded first
+      uint64_t last_used;
+
+      // Set when the table is changed through the database. Modified tables are never unloaded, otherwise the changes
+      // would be lost
+      bool modified;
+   };
+
+   // When opened through load_lazy() this holds the path of the .gddb file and the table directory read from it. The
+   // path is empty when not in lazy mode
+   mutable godot::String m_lazy_path;
+   mutable godot::HashMap<godot::StringName, TableEntry> m_lazy_table;
+   mutable uint64_t m_use_counter;
+
+   // In lazy mode, if this is bigger than 0, tables are unloaded when the loaded ones use more than this amount of bytes
+   int64_t m_memory_budget;
+
+   // State of a load started by load_async(). Each table is decoded by a separate WorkerThreadPool task, which writes
+   // the result into its own entry of 'result'. The task finishing last defers the completion into the main thread
+   struct AsyncLoad
+   {
+      godot::String path;
+      godot::Vector<TableEntry> directory;
+      godot::Vector<godot::Ref<DBTable>> result;
+      int64_t group_id;
+      godot::SafeNumeric<uint32_t> done;
+
+      // Number of decoded tables last given through the "load_progress" signal. Only used in the main thread
+      uint32_t reported;
+
+      // Keeps the database alive while there are tasks referring to it
+      godot::Ref<GDDatabase> keep_alive;
+
+      bool running;
+   } m_async;
+
    /// Exposed variables
 
    /// Internal functions
    void check_table_setup();
 
+   // Parse the header and the table directory of binary data, which must start at the beginning of the file.
+   // 'out_size' receives the number of bytes taken by the header and directory
+   static godot::Error read_directory(const uint8_t* data, int64_t size, godot::Vector<TableEntry>& out_list, int64_t& out_size);
+
+   // Given the block of a table, decode it
+   static godot::Ref<DBTable> decode_table(const uint8_t* data, int64_t size);
+
+   // Read only the header and the table directory of the given binary database file
+   static godot::Error read_file_directory(const godot::String& path, godot::Vector<TableEntry>& out_list);
+
+   // Read and decode a single table block from the given file. Returns an invalid reference on failure
+   static godot::Ref<DBTable> read_table_block(const godot::String& path, const TableEntry& entry);
+
+   // Executed by the WorkerThreadPool, once per table, during load_async()
+   void async_load_table(uint32_t index);
+
+   // Deferred into the main thread by each task of load_async(). Emits "load_progress" with the current counter, unless
+   // that has already been reported (or the load has finished), so listeners never see the progress going backwards
+   void emit_async_progress();
+
+   // Deferred into the main thread once all tables of load_async() are decoded
+   void finish_async_load();
+
+   // Load a table of the lazy database. Returns an invalid reference on failure
+   godot::Ref<DBTable> load_lazy_table(const godot::StringName& table_name, bool enforce_budget) const;
+
+   // Unload the least recently used tables until the memory budget is respected. Tables referenced outside of the
+   // database are never unloaded, neither is 'keep'
+   void enforce_memory_budget(const godot::StringName& keep) const;
+
+   // In lazy mode flag the given table as modified, so it is kept in memory. Every function changing table data must call this
+   void set_table_modified(const godot::StringName& table_name);
+
+   // Returns true if the loaded table can be unloaded. That is, it's not modified and nothing outside of the database
+   // holds a reference to it
+   bool can_unload_table(const godot::StringName& table_name) const;
+
+   // Load all tables that are not loaded yet then leave lazy mode. Called before changes to the database structure. If
+   // any table fails to load the database remains in lazy mode, keeping the directory, and false is returned
+   bool load_all_tables() const;
+
    // When retrieving a row, it's possible to "expand" data from a referenced table. This function performs this expansion
    void expand_row_cell(const godot::Ref<DBTable>& table, godot::Dictionary& out_row) const;
 
@@ -114,11 +216,12 @@ public:
    /// Exposed functions
    bool save(const godot::String& path, bool include_tables);
 
-   bool has_table(const godot::StringName& table_name) const { return m_table.has(table_name); }
+   bool has_table(const godot::StringName& table_name) const { return m_table.has(table_name) || m_lazy_table.has(table_name); }
 
    // If int_id is false then the added table will use Strings as row IDs instead of integers
-   // If the table is created, true will be returned. Also, it will be embedded
-   bool add_table(const godot::StringName& table_name, bool int_id, bool locked_id = false);
+   // If the table is created, true will be returned. Also, it will be embedded. Integer ID tables can be created in dense
+   // ID mode, where new rows get sequential IDs and lookups by ID are direct array accesses
+   bool add_table(const godot::StringName& table_name, bool int_id, bool locked_id = false, bool dense_id = false);
 
 
    // Given a DBTable resource, attempt to add it as a table managed by this database
@@ -131,10 +234,10 @@ public:
    bool rename_table(const godot::StringName& from, const godot::StringName& to);
 
    // Obtain an array containing the names of all tables within this database
-   godot::PackedStringArray get_table_list() const { return m_table.keys(); }
+   godot::PackedStringArray get_table_list() const;
 
-   // Retrieve a table instance given its name
-   godot::Ref<DBTable> get_table(const godot::StringName& table_name) const { return m_table.get(table_name, godot::Ref<DBTable>()); }
+   // Retrieve a table instance given its name. In lazy mode the table is loaded if it's not already
+   godot::Ref<DBTable> get_table(const godot::StringName& table_name) const;
 
    // Removes a table from the database, given its name. Attention, this cannot be undone!
    bool remove_table(const godot::StringName& table_name);
@@ -163,6 +266,9 @@ public:
    // Change the value type of a column within a table, given its name. Returns true if something changed
    bool table_change_column_value_type(const godot::StringName& table_name, int64_t column_index, DBTable::ValueType to_type);
 
+   // Declare (or remove) a secondary index on a column of the given table
+   bool table_set_column_index(const godot::StringName& table_name, int64_t column_index, DBTable::IndexType type);
+
    // Given a table name, return true if the corresponding table has the random weight system setup within it
    bool table_has_random_setup(const godot::StringName& table_name) const;
 
@@ -170,6 +276,11 @@ public:
    // If the index is negative then the row will be appended. Returns the index where the row has been inserted. -1 if error
    int64_t table_insert_row(const godot::StringName& table_name, const godot::Dictionary& values, int64_t index);
 
+   // Insert multiple rows, given as an Array of Dictionaries in the same format used by table_insert_row(), starting at
+   // the given index. Internal indexing is updated once for the entire batch, which is way faster than inserting rows one
+   // by one. Returns the index of the first inserted row. -1 if error
+   int64_t table_insert_rows(const godot::StringName& table_name, const godot::Array& rows, int64_t index);
+
    // Move a row from 'from' index into 'to' index, in the specified table. Returns true if something actually changed
    bool table_move_row(const godot::StringName& table_name, int64_t from, int64_t to);
 
@@ -186,6 +297,11 @@ public:
    // Sort the rows of the specified table by the specified column index
    bool table_sort_rows(const godot::StringName& table_name, int64_t column_index, bool ascending = true);
 
+   // Sort rows of the specified table by multiple columns, given by their titles ("id" can be used for the row IDs). Each
+   // subsequent column only orders rows that are equal in all previous ones. Entries in 'ascending' give the direction of
+   // the corresponding columns, missing entries meaning ascending. Returns true on success
+   bool table_sort_rows_by_columns(const godot::StringName& table_name, const godot::PackedStringArray& column_titles, const godot::Array& ascending);
+
    // Change the value of the cell in the specified table. Returns true if something changed.
    bool table_set_cell_value(const godot::StringName& table_name, int64_t column_index, int64_t row_index, const godot::Variant& value);
 
@@ -204,6 +320,20 @@ public:
    // A custom random number generator can be provided, which gives more control over seed and state
    godot::Dictionary randomly_pick_row(const godot::StringName& table_name, bool expand, const godot::Ref<godot::RandomNumberGenerator>& rng = godot::Ref<godot::RandomNumberGenerator>()) const;
 
+   // Randomly pick 'count' rows from the specified table in a single call, returning their indices. Check DBTable::pick_random_rows()
+   godot::PackedInt64Array randomly_pick_row_indices(const godot::StringName& table_name, int64_t count, bool with_replacement, const godot::Ref<godot::RandomNumberGenerator>& rng = godot::Ref<godot::RandomNumberGenerator>()) const;
+
+   // Same as above, but returns an array containing the picked rows (Dictionaries), optionally expanded
+   godot::Array randomly_pick_rows(const godot::StringName& table_name, int64_t count, bool with_replacement, bool expand, const godot::Ref<godot::RandomNumberGenerator>& rng = godot::Ref<godot::RandomNumberGenerator>()) const;
+
+
+   // Execute a query on the specified table, returning the indices of the resulting rows
+   godot::PackedInt64Array query_indices(const godot::StringName& table_name, const godot::Ref<DBQuery>& query) const;
+
+   // Execute a query on the specified table, returning the resulting rows. If 'expand' is true then referenced rows of
+   // other tables are expanded, like in get_row_from()
+   godot::Array query_rows(const godot::StringName& table_name, const godot::Ref<DBQuery>& query, bool expand = false) const;
+
 
    // Returns true if the given table name is referenced by the other table name
    bool is_table_referenced_by(const godot::StringName& table_name, const godot::StringName& other_table) const;
@@ -219,7 +349,41 @@ public:
    // Build a Dictionary containing information related to the Database. This might be useful for debugging
    godot::Dictionary get_db_info() const;
 
+   // Open a binary database (.gddb) in lazy mode. Only the table directory is read, each table being loaded the first
+   // time it's requested. If 'memory_budget' is bigger than 0 then tables not used for the longest time are unloaded
+   // whenever the loaded ones use more than that amount of bytes. Tables referenced outside of the database and tables
+   // changed through the table_*() functions (or by their reference upkeep) are never unloaded. Changes done directly
+   // on a DBTable are not tracked, so those are lost if the table is unloaded after the last outside reference is gone.
+   // Changes to the structure (adding, renaming or removing tables, linking columns) and saving load all tables and
+   // leave lazy mode
+   static godot::Ref<GDDatabase> load_lazy(const godot::String& path, int64_t memory_budget = 0);
+
+   bool is_lazy() const { return !m_lazy_path.is_empty(); }
+
+   // Returns true if the table is in memory. Always true for existing tables when not in lazy mode
+   bool is_table_loaded(const godot::StringName& table_name) const { return m_table.has(table_name); }
+
+   // Unload every table that is not referenced outside of the database and was not modified. Only does something in lazy mode
+   void unload_unused_tables();
+
+   // Approximate number of bytes used by the row data of the loaded tables
+   int64_t get_loaded_memory_usage() const;
+
+   // Load a binary database (.gddb) into this instance without blocking the calling thread. Tables, including their
+   // row, unique value, weight and secondary indexes, are decoded in WorkerThreadPool tasks, one table per task. The
+   // "load_progress" signal is emitted after each table and "load_completed" once the database is ready, both in the
+   // main thread. Existing tables are only replaced if everything is successfully loaded. The database should not be
+   // used until completion
+   godot::Error load_async(const godot::String& path);
+
+   bool is_loading() const { return m_async.running; }
+
+   // Ratio, in the [0..1] range, of tables already decoded by load_async(). 1 if not loading
+   double get_load_progress() const;
+
    /// Setters/Getters
+   void set_memory_budget(int64_t bytes);
+   int64_t get_memory_budget() const { return m_memory_budget; }
 
 
    /// Public non exposed functions
@@ -231,6 +395,12 @@ public:
    // tables without applying into the "main table"
    godot::Dictionary get_row_from_patched(const godot::Ref<DBTable>& patched, int64_t index, bool expand) const;
 
+   // Binary database format (.gddb), used by the resource loader and saver. All tables are embedded in the data.
+   // Decoding replaces every table currently in this database. Encoding returns an empty array if tables of a lazy
+   // database fail to load
+   godot::PackedByteArray encode_binary() const;
+   godot::Error decode_binary(const godot::PackedByteArray& data);
+
 
    //void set_table(const godot::Dictionary table) { m_table = table; }
    //godot::Dictionary get_table() const { return m_table; }
@@ -241,7 +411,8 @@ public:
 
 
 
-/*class ResourceFormatLoaderGDDatabase : public godot::ResourceFormatLoader
+// Handles the binary .gddb format. Text databases keep using the core .tres format
+class ResourceFormatLoaderGDDatabase : public godot::ResourceFormatLoader
 {
    // This must be registered within the ClassDB, otherwise it will be completely ignored by the ResourceSaver singleton!
    // But for the registration to work, this GDCLASS() macro must be used. This macro also enforces the creation of _bind_methods()
@@ -271,7 +442,7 @@ public:
 
 
    ResourceFormatSaverGDDatabase() {}
-};*/
+};
 
 
 
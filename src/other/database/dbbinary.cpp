@@ -0,0 +1,226 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DATABASE_DISABLED
+
+#include "dbbinary.h"
+
+#include <godot_cpp/variant/utility_functions.hpp>
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// DBBinaryWriter
+uint8_t* DBBinaryWriter::grow(int64_t bytes)
+{
+   const int64_t required = m_size + bytes;
+   int64_t capacity = m_data.size();
+   if (required > capacity)
+   {
+      capacity = MAX(capacity * 2, int64_t(4096));
+      while (capacity < required)
+      {
+         capacity *= 2;
+      }
+      m_data.resize(capacity);
+   }
+
+   uint8_t* ret = m_data.ptrw() + m_size;
+   m_size = required;
+   return ret;
+}
+
+
+void DBBinaryWriter::write_bytes(const void* src, int64_t bytes)
+{
+   if (bytes <= 0)
+   {
+      return;
+   }
+
+   memcpy(grow(bytes), src, bytes);
+}
+
+
+void DBBinaryWriter::write_string(const godot::String& str)
+{
+   const godot::CharString utf8 = str.utf8();
+   write_u32(utf8.length());
+   write_bytes(utf8.get_data(), utf8.length());
+}
+
+
+void DBBinaryWriter::write_variant(const godot::Variant& value)
+{
+   const godot::PackedByteArray bytes = godot::UtilityFunctions::var_to_bytes(value);
+   write_u64(bytes.size());
+   write_bytes(bytes.ptr(), bytes.size());
+}
+
+
+void DBBinaryWriter::align()
+{
+   const int64_t pad = (8 - (m_size & 7)) & 7;
+   if (pad > 0)
+   {
+      memset(grow(pad), 0, pad);
+   }
+}
+
+
+void DBBinaryWriter::patch_u64(int64_t position, uint64_t value)
+{
+   ERR_FAIL_COND_MSG(position < 0 || position + int64_t(sizeof(uint64_t)) > m_size, "Attempting to patch data outside of the written range.");
+   memcpy(m_data.ptrw() + position, &value, sizeof(uint64_t));
+}
+
+
+godot::PackedByteArray DBBinaryWriter::get_data()
+{
+   m_data.resize(m_size);
+   return m_data;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// DBBinaryReader
+uint8_t DBBinaryReader::read_u8()
+{
+   const uint8_t* src = read_block(1);
+   return src ? *src : 0;
+}
+
+
+uint32_t DBBinaryReader::read_u32()
+{
+   uint32_t ret = 0;
+   read_bytes(&ret, sizeof(uint32_t));
+   return ret;
+}
+
+
+uint64_t DBBinaryReader::read_u64()
+{
+   uint64_t ret = 0;
+   read_bytes(&ret, sizeof(uint64_t));
+   return ret;
+}
+
+
+int64_t DBBinaryReader::read_i64()
+{
+   int64_t ret = 0;
+   read_bytes(&ret, sizeof(int64_t));
+   return ret;
+}
+
+
+double DBBinaryReader::read_double()
+{
+   double ret = 0.0;
+   read_bytes(&ret, sizeof(double));
+   return ret;
+}
+
+
+bool DBBinaryReader::read_bytes(void* dest, int64_t bytes)
+{
+   const uint8_t* src = read_block(bytes);
+   if (!src)
+   {
+      return false;
+   }
+
+   if (bytes > 0)
+   {
+      memcpy(dest, src, bytes);
+   }
+   return true;
+}
+
+
+const uint8_t* DBBinaryReader::read_block(int64_t bytes)
+{
+   // Written this way so a huge (corrupted) size doesn't overflow the sum
+   if (m_error || bytes < 0 || bytes > m_size - m_position)
+   {
+      m_error = true;
+      return nullptr;
+   }
+
+   const uint8_t* ret = m_ptr + m_position;
+   m_position += bytes;
+   return ret;
+}
+
+
+godot::String DBBinaryReader::read_string()
+{
+   const uint32_t length = read_u32();
+   const uint8_t* src = read_block(length);
+   if (!src || length == 0)
+   {
+      return godot::String();
+   }
+
+   return godot::String::utf8((const char*)src, length);
+}
+
+
+godot::Variant DBBinaryReader::read_variant()
+{
+   const uint64_t size = read_u64();
+   const uint8_t* src = read_block(int64_t(size));
+   if (!src)
+   {
+      return godot::Variant();
+   }
+
+   godot::PackedByteArray bytes;
+   bytes.resize(size);
+   memcpy(bytes.ptrw(), src, size);
+
+   return godot::UtilityFunctions::bytes_to_var(bytes);
+}
+
+
+void DBBinaryReader::align()
+{
+   const int64_t pad = (8 - (m_position & 7)) & 7;
+   read_block(pad);
+}
+
+
+void DBBinaryReader::seek(int64_t position)
+{
+   if (position < 0 || position > m_size)
+   {
+      m_error = true;
+      return;
+   }
+
+   m_position = position;
+}
+
+
+#endif  //DATABASE_DISABLED
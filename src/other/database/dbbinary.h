@@ -0,0 +1,154 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _kehother_dbbinary_h_included
+#define _kehother_dbbinary_h_included 1
+
+#ifndef DATABASE_DISABLED
+
+#include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/packed_byte_array.hpp>
+#include <godot_cpp/variant/string.hpp>
+#include <godot_cpp/variant/variant.hpp>
+
+
+// Helpers used to write and read the binary database format (.gddb). Numbers are stored in the native byte order, which
+// is little endian on every platform supported by Godot. Typed blocks are aligned to 8 bytes so those can be copied
+// straight into the column storage with a single memcpy per block.
+class DBBinaryWriter
+{
+private:
+   godot::PackedByteArray m_data;
+
+   // Number of bytes actually written. The buffer above grows in bigger steps to avoid resizing it on every write
+   int64_t m_size;
+
+   // Ensure there is room for 'bytes' more bytes and return a pointer to where those should be written
+   uint8_t* grow(int64_t bytes);
+
+public:
+   void write_u8(uint8_t value) { *grow(1) = value; }
+   void write_u32(uint32_t value) { write_bytes(&value, sizeof(uint32_t)); }
+   void write_u64(uint64_t value) { write_bytes(&value, sizeof(uint64_t)); }
+   void write_i64(int64_t value) { write_bytes(&value, sizeof(int64_t)); }
+   void write_double(double value) { write_bytes(&value, sizeof(double)); }
+
+   void write_bytes(const void* src, int64_t bytes);
+
+   // Length (in bytes) followed by the UTF-8 encoded string
+   void write_string(const godot::String& str);
+
+   // Size followed by the bytes generated by var_to_bytes(). Objects are not encoded
+   void write_variant(const godot::Variant& value);
+
+   // Pad with 0 until the position is a multiple of 8
+   void align();
+
+   int64_t get_position() const { return m_size; }
+
+   // Overwrite a value that has been previously written at the given position. Used to fill offsets that are only
+   // known after writing the data they point to
+   void patch_u64(int64_t position, uint64_t value);
+
+   // Retrieve the written data. This trims the excess of the internal buffer
+   godot::PackedByteArray get_data();
+
+   DBBinaryWriter() : m_size(0) {}
+};
+
+
+
+// Reads data written by the DBBinaryWriter from memory. Reading past the end of the data doesn't crash, instead the error
+// flag is set and "empty" values are returned. Callers are expected to check has_error() after reading a block.
+class DBBinaryReader
+{
+private:
+   const uint8_t* m_ptr;
+   int64_t m_size;
+   int64_t m_position;
+   bool m_error;
+
+public:
+   uint8_t read_u8();
+   uint32_t read_u32();
+   uint64_t read_u64();
+   int64_t read_i64();
+   double read_double();
+
+   bool read_bytes(void* dest, int64_t bytes);
+
+   // Pointer to the next 'bytes' bytes, advancing the position. Returns nullptr (and sets the error flag) if there isn't
+   // enough data
+   const uint8_t* read_block(int64_t bytes);
+
+   godot::String read_string();
+   godot::Variant read_variant();
+
+   void align();
+
+   int64_t get_position() const { return m_position; }
+   int64_t get_size() const { return m_size; }
+   void seek(int64_t position);
+
+   bool has_error() const { return m_error; }
+
+   // The data must remain valid while this reader is used
+   DBBinaryReader(const uint8_t* data, int64_t size) : m_ptr(data), m_size(size), m_position(0), m_error(false) {}
+};
+
+
+// Typed blocks. The element count is followed by the raw contents of the array
+template <typename T>
+void db_write_vector(DBBinaryWriter& writer, const godot::Vector<T>& vec)
+{
+   writer.write_u64(vec.size());
+   writer.write_bytes(vec.ptr(), vec.size() * sizeof(T));
+   writer.align();
+}
+
+
+template <typename T>
+bool db_read_vector(DBBinaryReader& reader, godot::Vector<T>& out_vec)
+{
+   const uint64_t count = reader.read_u64();
+
+   // Reject counts that can't possibly fit in the remaining data before attempting to allocate anything
+   if (reader.has_error() || count > uint64_t(reader.get_size() - reader.get_position()) / sizeof(T))
+   {
+      return false;
+   }
+
+   out_vec.resize(count);
+   if (!reader.read_bytes(out_vec.ptrw(), count * sizeof(T)))
+   {
+      return false;
+   }
+
+   reader.align();
+   return !reader.has_error();
+}
+
+
+#endif  //DATABASE_DISABLED
+
+#endif   // _kehother_dbbinary_h_included
@@ -0,0 +1,1536 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DATABASE_DISABLED
+
+#include "dbcolumn.h"
+#include "dbbinary.h"
+
+#include <godot_cpp/templates/sort_array.hpp>
+
+
+// Helpers dealing with the typed arrays, regardless of which one is used by the column
+template <typename T>
+static void vector_move(godot::Vector<T>& vec, int64_t from, int64_t to)
+{
+   const T value = vec[from];
+   vec.remove_at(from);
+   vec.insert(to, value);
+}
+
+
+template <typename T>
+static void vector_permute(godot::Vector<T>& vec, const int64_t* permutation)
+{
+   const int64_t count = vec.size();
+   godot::Vector<T> result;
+   result.resize(count);
+
+   const T* src = vec.ptr();
+   T* dest = result.ptrw();
+   for (int64_t i = 0; i < count; i++)
+   {
+      dest[i] = src[permutation[i]];
+   }
+
+   vec = result;
+}
+
+
+template <typename T>
+static bool compare_values(const T& a, const T& b, DBColumn::CompareOp op)
+{
+   switch (op)
+   {
+      case DBColumn::CO_Equal: return a == b;
+      case DBColumn::CO_NotEqual: return a != b;
+      case DBColumn::CO_Less: return a < b;
+      case DBColumn::CO_LessEqual: return !(b < a);
+      case DBColumn::CO_Greater: return b < a;
+      case DBColumn::CO_GreaterEqual: return !(a < b);
+   }
+
+   return false;
+}
+
+
+// Filter loop over a typed array. The comparison switch is predictable as the operation doesn't change within the loop
+template <typename T>
+static int64_t filter_values(const T* data, const T& value, DBColumn::CompareOp op, const int64_t* in_rows, int64_t count, int64_t* out_rows)
+{
+   int64_t ret = 0;
+   for (int64_t i = 0; i < count; i++)
+   {
+      const int64_t row = in_rows ? in_rows[i] : i;
+      if (compare_values(data[row], value, op))
+      {
+         out_rows[ret++] = row;
+      }
+   }
+
+   return ret;
+}
+
+
+static bool color_is_less(const godot::Color& a, const godot::Color& b)
+{
+   if (a.get_h() < b.get_h())
+   {
+      return true;
+   }
+   else if (a.get_h() == b.get_h())
+   {
+      if (a.get_s() < b.get_s())
+      {
+         return true;
+      }
+      else if (a.get_s() == b.get_s())
+      {
+         if (a.get_v() < b.get_v())
+         {
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// DBStringPool
+uint32_t DBStringPool::acquire(const godot::String& str)
+{
+   godot::HashMap<godot::String, uint32_t>::Iterator iter = m_handle.find(str);
+   if (iter != m_handle.end())
+   {
+      m_ref_count.ptrw()[iter->value]++;
+      return iter->value;
+   }
+
+   uint32_t handle;
+   if (m_free.size() > 0)
+   {
+      handle = m_free[m_free.size() - 1];
+      m_free.remove_at(m_free.size() - 1);
+
+      m_string.set(handle, str);
+      m_ref_count.set(handle, 1);
+   }
+   else
+   {
+      handle = (uint32_t)m_string.size();
+      m_string.push_back(str);
+      m_ref_count.push_back(1);
+   }
+
+   m_handle[str] = handle;
+
+   return handle;
+}
+
+
+void DBStringPool::release(uint32_t handle)
+{
+#ifdef DEBUG_ENABLED
+   ERR_FAIL_INDEX_MSG(handle, m_string.size(), "Attempting to release an invalid string handle.");
+   ERR_FAIL_COND_MSG(m_ref_count[handle] == 0, "Attempting to release a string handle that is not in use.");
+#endif
+
+   uint32_t* ref_count = m_ref_count.ptrw();
+   ref_count[handle]--;
+
+   if (ref_count[handle] == 0)
+   {
+      m_handle.erase(m_string[handle]);
+      m_string.set(handle, godot::String());
+      m_free.push_back(handle);
+   }
+}
+
+
+int64_t DBStringPool::get_memory_usage() const
+{
+   int64_t ret = 0;
+   for (godot::HashMap<godot::String, uint32_t>::ConstIterator iter = m_handle.begin(); iter != m_handle.end(); ++iter)
+   {
+      ret += (iter->key.length() + 1) * sizeof(char32_t);
+   }
+
+   return ret;
+}
+
+
+int64_t DBStringPool::find(const godot::String& str) const
+{
+   godot::HashMap<godot::String, uint32_t>::ConstIterator iter = m_handle.find(str);
+   if (iter == m_handle.end())
+   {
+      return -1;
+   }
+
+   return iter->value;
+}
+
+
+void DBStringPool::write(DBBinaryWriter& writer) const
+{
+   // Released slots are kept so the handles remain the same. Only their reference count (0) is written
+   const int64_t count = m_string.size();
+   db_write_vector(writer, m_ref_count);
+
+   const godot::String* str = m_string.ptr();
+   const uint32_t* ref_count = m_ref_count.ptr();
+   for (int64_t i = 0; i < count; i++)
+   {
+      if (ref_count[i] > 0)
+      {
+         writer.write_string(str[i]);
+      }
+   }
+   writer.align();
+}
+
+
+bool DBStringPool::read(DBBinaryReader& reader)
+{
+   clear();
+
+   if (!db_read_vector(reader, m_ref_count))
+   {
+      return false;
+   }
+
+   const int64_t count = m_ref_count.size();
+   m_string.resize(count);
+
+   godot::String* str = m_string.ptrw();
+   const uint32_t* ref_count = m_ref_count.ptr();
+   for (int64_t i = 0; i < count; i++)
+   {
+      if (ref_count[i] > 0)
+      {
+         str[i] = reader.read_string();
+         m_handle.insert(str[i], i);
+      }
+      else
+      {
+         m_free.push_back(i);
+      }
+   }
+   reader.align();
+
+   return !reader.has_error();
+}
+
+
+void DBStringPool::clear()
+{
+   m_string.clear();
+   m_ref_count.clear();
+   m_free.clear();
+   m_handle.clear();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// DBColumn
+int64_t DBColumn::size() const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int.size();
+      case ST_Float: return m_float.size();
+      case ST_Bool: return m_bool.size();
+      case ST_String: return m_string.size();
+      case ST_Color: return m_color.size();
+      case ST_Variant: return m_variant.size();
+   }
+
+   return 0;
+}
+
+
+godot::Variant DBColumn::get(int64_t row) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int[row];
+      case ST_Float: return m_float[row];
+      case ST_Bool: return m_bool[row] != 0;
+      case ST_String: return m_pool->get(m_string[row]);
+      case ST_Color: return m_color[row];
+      case ST_Variant: return m_variant[row];
+   }
+
+   return godot::Variant();
+}
+
+
+int64_t DBColumn::get_as_int(int64_t row) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int[row];
+      case ST_Float: return (int64_t)m_float[row];
+      case ST_Bool: return m_bool[row];
+      default: return get(row);
+   }
+}
+
+
+double DBColumn::get_as_float(int64_t row) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return (double)m_int[row];
+      case ST_Float: return m_float[row];
+      case ST_Bool: return m_bool[row];
+      default: return get(row);
+   }
+}
+
+
+bool DBColumn::get_as_bool(int64_t row) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int[row] != 0;
+      case ST_Float: return m_float[row] != 0.0;
+      case ST_Bool: return m_bool[row] != 0;
+      default: return get(row);
+   }
+}
+
+
+godot::String DBColumn::get_as_string(int64_t row) const
+{
+   if (m_storage == ST_String)
+   {
+      return m_pool->get(m_string[row]);
+   }
+
+   return get(row);
+}
+
+
+void DBColumn::set(int64_t row, const godot::Variant& value)
+{
+   switch (m_storage)
+   {
+      case ST_Integer:
+      {
+         m_int.set(row, (int64_t)value);
+      } break;
+
+      case ST_Float:
+      {
+         m_float.set(row, (double)value);
+      } break;
+
+      case ST_Bool:
+      {
+         m_bool.set(row, (bool)value ? 1 : 0);
+      } break;
+
+      case ST_String:
+      {
+         // Acquire before releasing so setting the same string doesn't temporarily remove it from the pool
+         const uint32_t handle = m_pool->acquire(value);
+         m_pool->release(m_string[row]);
+         m_string.set(row, handle);
+      } break;
+
+      case ST_Color:
+      {
+         m_color.set(row, (godot::Color)value);
+      } break;
+
+      case ST_Variant:
+      {
+         m_variant.set(row, value);
+      } break;
+   }
+}
+
+
+void DBColumn::insert(int64_t row, const godot::Variant& value)
+{
+   switch (m_storage)
+   {
+      case ST_Integer:
+      {
+         m_int.insert(row, (int64_t)value);
+      } break;
+
+      case ST_Float:
+      {
+         m_float.insert(row, (double)value);
+      } break;
+
+      case ST_Bool:
+      {
+         m_bool.insert(row, (bool)value ? 1 : 0);
+      } break;
+
+      case ST_String:
+      {
+         m_string.insert(row, m_pool->acquire(value));
+      } break;
+
+      case ST_Color:
+      {
+         m_color.insert(row, (godot::Color)value);
+      } break;
+
+      case ST_Variant:
+      {
+         m_variant.insert(row, value);
+      } break;
+   }
+}
+
+
+// Open a gap of 'count' entries at 'row', shifting the subsequent entries a single time. Returns the pointer to the first
+// entry of the gap
+template <typename T>
+static T* db_open_gap(godot::Vector<T>& vec, int64_t row, int64_t count)
+{
+   const int64_t old_size = vec.size();
+   vec.resize(old_size + count);
+   T* data = vec.ptrw();
+
+   for (int64_t i = old_size - 1; i >= row; i--)
+   {
+      data[i + count] = data[i];
+   }
+
+   return data + row;
+}
+
+
+void DBColumn::insert_range(int64_t row, const godot::Vector<godot::Variant>& values)
+{
+   const int64_t count = values.size();
+   if (count == 0)
+   {
+      return;
+   }
+
+   const godot::Variant* src = values.ptr();
+
+   switch (m_storage)
+   {
+      case ST_Integer:
+      {
+         int64_t* dest = db_open_gap(m_int, row, count);
+         for (int64_t i = 0; i < count; i++) { dest[i] = (int64_t)src[i]; }
+      } break;
+
+      case ST_Float:
+      {
+         double* dest = db_open_gap(m_float, row, count);
+         for (int64_t i = 0; i < count; i++) { dest[i] = (double)src[i]; }
+      } break;
+
+      case ST_Bool:
+      {
+         uint8_t* dest = db_open_gap(m_bool, row, count);
+         for (int64_t i = 0; i < count; i++) { dest[i] = (bool)src[i] ? 1 : 0; }
+      } break;
+
+      case ST_String:
+      {
+         uint32_t* dest = db_open_gap(m_string, row, count);
+         for (int64_t i = 0; i < count; i++) { dest[i] = m_pool->acquire(src[i]); }
+      } break;
+
+      case ST_Color:
+      {
+         godot::Color* dest = db_open_gap(m_color, row, count);
+         for (int64_t i = 0; i < count; i++) { dest[i] = (godot::Color)src[i]; }
+      } break;
+
+      case ST_Variant:
+      {
+         godot::Variant* dest = db_open_gap(m_variant, row, count);
+         for (int64_t i = 0; i < count; i++) { dest[i] = src[i]; }
+      } break;
+   }
+}
+
+
+void DBColumn::remove(int64_t row)
+{
+   switch (m_storage)
+   {
+      case ST_Integer: m_int.remove_at(row); break;
+      case ST_Float: m_float.remove_at(row); break;
+      case ST_Bool: m_bool.remove_at(row); break;
+      case ST_String:
+      {
+         m_pool->release(m_string[row]);
+         m_string.remove_at(row);
+      } break;
+      case ST_Color: m_color.remove_at(row); break;
+      case ST_Variant: m_variant.remove_at(row); break;
+   }
+}
+
+
+template <typename T>
+static void db_compact(godot::Vector<T>& vec, const uint8_t* removed)
+{
+   const int64_t count = vec.size();
+   T* data = vec.ptrw();
+   int64_t write = 0;
+
+   for (int64_t i = 0; i < count; i++)
+   {
+      if (removed[i])
+      {
+         continue;
+      }
+
+      if (write != i)
+      {
+         data[write] = data[i];
+      }
+      write++;
+   }
+
+   vec.resize(write);
+}
+
+
+void DBColumn::remove_marked(const uint8_t* removed)
+{
+   switch (m_storage)
+   {
+      case ST_Integer: db_compact(m_int, removed); break;
+      case ST_Float: db_compact(m_float, removed); break;
+      case ST_Bool: db_compact(m_bool, removed); break;
+      case ST_String:
+      {
+         const int64_t count = m_string.size();
+         for (int64_t i = 0; i < count; i++)
+         {
+            if (removed[i])
+            {
+               m_pool->release(m_string[i]);
+            }
+         }
+
+         db_compact(m_string, removed);
+      } break;
+      case ST_Color: db_compact(m_color, removed); break;
+      case ST_Variant: db_compact(m_variant, removed); break;
+   }
+}
+
+
+void DBColumn::move(int64_t from, int64_t to)
+{
+   switch (m_storage)
+   {
+      case ST_Integer: vector_move(m_int, from, to); break;
+      case ST_Float: vector_move(m_float, from, to); break;
+      case ST_Bool: vector_move(m_bool, from, to); break;
+      case ST_String: vector_move(m_string, from, to); break;
+      case ST_Color: vector_move(m_color, from, to); break;
+      case ST_Variant: vector_move(m_variant, from, to); break;
+   }
+}
+
+
+void DBColumn::apply_permutation(const int64_t* permutation)
+{
+   switch (m_storage)
+   {
+      case ST_Integer: vector_permute(m_int, permutation); break;
+      case ST_Float: vector_permute(m_float, permutation); break;
+      case ST_Bool: vector_permute(m_bool, permutation); break;
+      case ST_String: vector_permute(m_string, permutation); break;
+      case ST_Color: vector_permute(m_color, permutation); break;
+      case ST_Variant: vector_permute(m_variant, permutation); break;
+   }
+}
+
+
+bool DBColumn::is_less(int64_t a, int64_t b) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int[a] < m_int[b];
+      case ST_Float: return m_float[a] < m_float[b];
+      case ST_Bool: return m_bool[a] < m_bool[b];
+      case ST_String: return m_pool->get(m_string[a]) < m_pool->get(m_string[b]);
+      case ST_Color: return color_is_less(m_color[a], m_color[b]);
+      case ST_Variant: return m_variant[a] < m_variant[b];
+   }
+
+   return false;
+}
+
+
+void DBColumn::get_sort_keys(int64_t* out_key) const
+{
+   const int64_t count = size();
+
+   switch (m_storage)
+   {
+      case ST_Integer:
+      {
+         memcpy(out_key, m_int.ptr(), count * sizeof(int64_t));
+      } break;
+
+      case ST_Float:
+      {
+         // Flipping all bits but the signal of negative numbers makes the IEEE representation follow the float order
+         // when compared as signed integers
+         const double* value = m_float.ptr();
+         for (int64_t i = 0; i < count; i++)
+         {
+            const double v = value[i] == 0.0 ? 0.0 : value[i];
+            int64_t bits;
+            memcpy(&bits, &v, sizeof(int64_t));
+            out_key[i] = bits < 0 ? bits ^ INT64_MAX : bits;
+         }
+      } break;
+
+      case ST_Bool:
+      {
+         const uint8_t* value = m_bool.ptr();
+         for (int64_t i = 0; i < count; i++)
+         {
+            out_key[i] = value[i];
+         }
+      } break;
+
+      case ST_String:
+      {
+         // The pool holds each string once, so sorting the distinct handles gives the rank of each string
+         const int64_t slot_count = m_pool->get_slot_count();
+         godot::Vector<int64_t> rank;
+         rank.resize(slot_count);
+         int64_t* rptr = rank.ptrw();
+         for (int64_t i = 0; i < slot_count; i++)
+         {
+            rptr[i] = -1;
+         }
+
+         const uint32_t* handle = m_string.ptr();
+         godot::Vector<uint32_t> distinct;
+         for (int64_t i = 0; i < count; i++)
+         {
+            if (rptr[handle[i]] < 0)
+            {
+               rptr[handle[i]] = 0;
+               distinct.push_back(handle[i]);
+            }
+         }
+
+         struct HandleComparator
+         {
+            const DBStringPool* pool;
+            bool operator()(uint32_t a, uint32_t b) const { return pool->get(a) < pool->get(b); }
+         };
+
+         godot::SortArray<uint32_t, HandleComparator> sorter;
+         sorter.compare.pool = m_pool;
+         sorter.sort(distinct.ptrw(), distinct.size());
+
+         const int64_t dcount = distinct.size();
+         for (int64_t i = 0; i < dcount; i++)
+         {
+            rptr[distinct[i]] = i;
+         }
+
+         for (int64_t i = 0; i < count; i++)
+         {
+            out_key[i] = rptr[handle[i]];
+         }
+      } break;
+
+      case ST_Color:
+      case ST_Variant:
+      {
+         // No direct integer representation. Sort the rows once then assign the ranks, giving the same rank to equal values
+         godot::Vector<int64_t> order;
+         order.resize(count);
+         int64_t* optr = order.ptrw();
+         for (int64_t i = 0; i < count; i++)
+         {
+            optr[i] = i;
+         }
+
+         struct RowComparator
+         {
+            const DBColumn* column;
+            bool operator()(int64_t a, int64_t b) const { return column->is_less(a, b); }
+         };
+
+         godot::SortArray<int64_t, RowComparator> sorter;
+         sorter.compare.column = this;
+         sorter.sort(optr, count);
+
+         int64_t rank = 0;
+         for (int64_t i = 0; i < count; i++)
+         {
+            if (i > 0 && is_less(optr[i - 1], optr[i]))
+            {
+               rank++;
+            }
+            out_key[optr[i]] = rank;
+         }
+      } break;
+   }
+}
+
+
+godot::Variant DBColumn::convert(const godot::Variant& value) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return (int64_t)value;
+      case ST_Float: return (double)value;
+      case ST_Bool: return (bool)value;
+      case ST_String: return (godot::String)value;
+      case ST_Color: return (godot::Color)value;
+      case ST_Variant: return value;
+   }
+
+   return value;
+}
+
+
+bool DBColumn::is_less_than(int64_t row, const godot::Variant& value) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int[row] < (int64_t)value;
+      case ST_Float: return m_float[row] < (double)value;
+      case ST_Bool: return m_bool[row] < ((bool)value ? 1 : 0);
+      case ST_String: return m_pool->get(m_string[row]) < (godot::String)value;
+      case ST_Color: return color_is_less(m_color[row], value);
+      case ST_Variant: return m_variant[row] < value;
+   }
+
+   return false;
+}
+
+
+bool DBColumn::is_greater_than(int64_t row, const godot::Variant& value) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return (int64_t)value < m_int[row];
+      case ST_Float: return (double)value < m_float[row];
+      case ST_Bool: return ((bool)value ? 1 : 0) < m_bool[row];
+      case ST_String: return (godot::String)value < m_pool->get(m_string[row]);
+      case ST_Color: return color_is_less(value, m_color[row]);
+      case ST_Variant: return value < m_variant[row];
+   }
+
+   return false;
+}
+
+
+bool DBColumn::is_equal(int64_t row, const godot::Variant& value) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int[row] == (int64_t)value;
+      case ST_Float: return m_float[row] == (double)value;
+      case ST_Bool: return (m_bool[row] != 0) == (bool)value;
+      case ST_String: return m_pool->get(m_string[row]) == (godot::String)value;
+      case ST_Color: return m_color[row] == (godot::Color)value;
+      case ST_Variant: return m_variant[row] == value;
+   }
+
+   return false;
+}
+
+
+int64_t DBColumn::filter(CompareOp op, const godot::Variant& value, const int64_t* in_rows, int64_t count, int64_t* out_rows) const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return filter_values<int64_t>(m_int.ptr(), value, op, in_rows, count, out_rows);
+      case ST_Float: return filter_values<double>(m_float.ptr(), value, op, in_rows, count, out_rows);
+      case ST_Bool: return filter_values<uint8_t>(m_bool.ptr(), (bool)value ? 1 : 0, op, in_rows, count, out_rows);
+
+      case ST_String:
+      {
+         if (op == CO_Equal || op == CO_NotEqual)
+         {
+            // Strings are interned, so equality can be checked through the handles
+            const int64_t handle = m_pool->find(value);
+            if (handle < 0)
+            {
+               // No row holds the string
+               if (op == CO_Equal)
+               {
+                  return 0;
+               }
+
+               for (int64_t i = 0; i < count; i++)
+               {
+                  out_rows[i] = in_rows ? in_rows[i] : i;
+               }
+               return count;
+            }
+
+            return filter_values<uint32_t>(m_string.ptr(), (uint32_t)handle, op, in_rows, count, out_rows);
+         }
+      } break;
+
+      default:
+      {
+      }
+   }
+
+   // Everything else goes through the generic comparisons
+   int64_t ret = 0;
+   for (int64_t i = 0; i < count; i++)
+   {
+      const int64_t row = in_rows ? in_rows[i] : i;
+
+      bool pass = false;
+      switch (op)
+      {
+         case CO_Equal: pass = is_equal(row, value); break;
+         case CO_NotEqual: pass = !is_equal(row, value); break;
+         case CO_Less: pass = is_less_than(row, value); break;
+         case CO_LessEqual: pass = !is_greater_than(row, value); break;
+         case CO_Greater: pass = is_greater_than(row, value); break;
+         case CO_GreaterEqual: pass = !is_less_than(row, value); break;
+      }
+
+      if (pass)
+      {
+         out_rows[ret++] = row;
+      }
+   }
+
+   return ret;
+}
+
+
+void DBColumn::clear()
+{
+   if (m_storage == ST_String)
+   {
+      const int64_t count = m_string.size();
+      for (int64_t i = 0; i < count; i++)
+      {
+         m_pool->release(m_string[i]);
+      }
+   }
+
+   m_int.clear();
+   m_float.clear();
+   m_bool.clear();
+   m_string.clear();
+   m_color.clear();
+   m_variant.clear();
+}
+
+
+int64_t DBColumn::get_memory_usage() const
+{
+   switch (m_storage)
+   {
+      case ST_Integer: return m_int.size() * sizeof(int64_t);
+      case ST_Float: return m_float.size() * sizeof(double);
+      case ST_Bool: return m_bool.size() * sizeof(uint8_t);
+      case ST_String: return m_string.size() * sizeof(uint32_t);
+      case ST_Color: return m_color.size() * sizeof(godot::Color);
+      case ST_Variant: return m_variant.size() * sizeof(godot::Variant);
+   }
+
+   return 0;
+}
+
+
+void DBColumn::write(DBBinaryWriter& writer) const
+{
+   writer.write_u32(m_storage);
+   writer.write_u32(0);
+
+   switch (m_storage)
+   {
+      case ST_Integer: db_write_vector(writer, m_int); break;
+      case ST_Float: db_write_vector(writer, m_float); break;
+      case ST_Bool: db_write_vector(writer, m_bool); break;
+      case ST_String: db_write_vector(writer, m_string); break;
+      case ST_Color: db_write_vector(writer, m_color); break;
+      case ST_Variant:
+      {
+         const int64_t count = m_variant.size();
+         godot::Array values;
+         values.resize(count);
+         for (int64_t i = 0; i < count; i++)
+         {
+            values[i] = m_variant[i];
+         }
+
+         writer.write_variant(values);
+         writer.align();
+      } break;
+   }
+}
+
+
+bool DBColumn::read(DBBinaryReader& reader)
+{
+   const uint32_t storage = reader.read_u32();
+   reader.read_u32();
+
+   ERR_FAIL_COND_V_MSG(reader.has_error() || storage != uint32_t(m_storage), false, "Reading column values, however the stored data doesn't match the column type.");
+
+   switch (m_storage)
+   {
+      case ST_Integer: return db_read_vector(reader, m_int);
+      case ST_Float: return db_read_vector(reader, m_float);
+      case ST_Bool: return db_read_vector(reader, m_bool);
+      case ST_Color: return db_read_vector(reader, m_color);
+
+      case ST_String:
+      {
+         if (!db_read_vector(reader, m_string))
+         {
+            return false;
+         }
+
+         // Handles are used to directly index the pool, so make sure corrupted data doesn't result in a crash later
+         const int64_t count = m_string.size();
+         const uint32_t* handle = m_string.ptr();
+         for (int64_t i = 0; i < count; i++)
+         {
+            if (!m_pool->is_valid(handle[i]))
+            {
+               m_string.clear();
+               ERR_FAIL_V_MSG(false, "Reading column values, however found an invalid string handle.");
+            }
+         }
+         return true;
+      }
+
+      case ST_Variant:
+      {
+         const godot::Array values = reader.read_variant();
+         reader.align();
+
+         const int64_t count = values.size();
+         m_variant.resize(count);
+         godot::Variant* dest = m_variant.ptrw();
+         for (int64_t i = 0; i < count; i++)
+         {
+            dest[i] = values[i];
+         }
+         return !reader.has_error();
+      }
+   }
+
+   return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// DBWeightTree
+void DBWeightTree::update_top_mask()
+{
+   const int64_t count = m_node.size();
+
+   m_top_mask = 0;
+   if (count > 0)
+   {
+      m_top_mask = 1;
+      while ((m_top_mask << 1) <= count)
+      {
+         m_top_mask <<= 1;
+      }
+   }
+}
+
+
+void DBWeightTree::build(const double* weight, int64_t count)
+{
+   m_node.resize(count);
+   double* node = m_node.ptrw();
+
+   for (int64_t i = 0; i < count; i++)
+   {
+      node[i] = weight && weight[i] > 0.0 ? weight[i] : 0.0;
+   }
+
+   // Each node pushes its sum into its parent. This results in linear time instead of O(n log n) from 'count' add() calls
+   for (int64_t i = 1; i <= count; i++)
+   {
+      const int64_t parent = i + (i & -i);
+      if (parent <= count)
+      {
+         node[parent - 1] += node[i - 1];
+      }
+   }
+
+   update_top_mask();
+}
+
+
+void DBWeightTree::append(double weight)
+{
+   // The new node covers the range (i - lowbit(i), i], where all but the last row already exist. Their sum is the
+   // difference between two accumulated weights
+   const int64_t i = m_node.size() + 1;
+   const int64_t first = i - (i & -i);
+
+   double value = weight > 0.0 ? weight : 0.0;
+   if (i > 1)
+   {
+      value += get_accumulated(i - 2) - (first > 0 ? get_accumulated(first - 1) : 0.0);
+   }
+
+   m_node.append(value);
+   update_top_mask();
+}
+
+
+void DBWeightTree::add(int64_t row, double delta)
+{
+   ERR_FAIL_INDEX(row, m_node.size());
+
+   const int64_t count = m_node.size();
+   double* node = m_node.ptrw();
+
+   for (int64_t i = row + 1; i <= count; i += (i & -i))
+   {
+      node[i - 1] += delta;
+   }
+}
+
+
+double DBWeightTree::get_accumulated(int64_t row) const
+{
+   ERR_FAIL_INDEX_V(row, m_node.size(), 0.0);
+
+   const double* node = m_node.ptr();
+   double ret = 0.0;
+
+   for (int64_t i = row + 1; i > 0; i -= (i & -i))
+   {
+      ret += node[i - 1];
+   }
+
+   return ret;
+}
+
+
+int64_t DBWeightTree::find(double roll) const
+{
+   const int64_t count = m_node.size();
+   const double* node = m_node.ptr();
+
+   // Descend from the biggest node, skipping every node whose sum does not exceed what is left of the roll
+   int64_t pos = 0;
+   double left = roll;
+   for (int64_t mask = m_top_mask; mask > 0; mask >>= 1)
+   {
+      const int64_t next = pos + mask;
+      if (next <= count && node[next - 1] <= left)
+      {
+         pos = next;
+         left -= node[next - 1];
+      }
+   }
+
+   if (pos < count)
+   {
+      return pos;
+   }
+
+   // The roll reached the total. Search again, now for the first row whose accumulated weight reaches the roll, so
+   // trailing rows without weight are not picked
+   pos = 0;
+   left = roll;
+   for (int64_t mask = m_top_mask; mask > 0; mask >>= 1)
+   {
+      const int64_t next = pos + mask;
+      if (next <= count && node[next - 1] < left)
+      {
+         pos = next;
+         left -= node[next - 1];
+      }
+   }
+
+   return MIN(pos, count - 1);
+}
+
+
+void DBWeightTree::write(DBBinaryWriter& writer) const
+{
+   db_write_vector(writer, m_node);
+}
+
+
+bool DBWeightTree::read(DBBinaryReader& reader)
+{
+   const bool ret = db_read_vector(reader, m_node);
+   if (!ret)
+   {
+      m_node.clear();
+   }
+   update_top_mask();
+
+   return ret;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// DBColumnIndex
+int64_t DBColumnIndex::find_sorted_position(const DBColumn& column, int64_t row) const
+{
+   const int64_t* sorted = m_sorted.ptr();
+   int64_t low = 0;
+   int64_t high = m_sorted.size();
+
+   while (low < high)
+   {
+      const int64_t mid = low + ((high - low) >> 1);
+      const int64_t other = sorted[mid];
+
+      // Order by value, then by row index
+      const bool less = column.is_less(other, row) || (!column.is_less(row, other) && other < row);
+      if (less)
+      {
+         low = mid + 1;
+      }
+      else
+      {
+         high = mid;
+      }
+   }
+
+   return low;
+}
+
+
+void DBColumnIndex::shift_rows(int64_t first, int64_t delta)
+{
+   if (m_ordered)
+   {
+      int64_t* sorted = m_sorted.ptrw();
+      const int64_t count = m_sorted.size();
+      for (int64_t i = 0; i < count; i++)
+      {
+         if (sorted[i] >= first)
+         {
+            sorted[i] += delta;
+         }
+      }
+   }
+   else
+   {
+      for (BucketMapType::Iterator iter = m_bucket.begin(); iter != m_bucket.end(); ++iter)
+      {
+         // Buckets are sorted, so only the tail needs to be changed
+         int64_t* bucket = iter->value.ptrw();
+         for (int64_t i = iter->value.size() - 1; i >= 0 && bucket[i] >= first; i--)
+         {
+            bucket[i] += delta;
+         }
+      }
+   }
+}
+
+
+void DBColumnIndex::build(const DBColumn& column)
+{
+   m_bucket.clear();
+   m_sorted.clear();
+
+   const int64_t rcount = column.size();
+
+   if (m_ordered)
+   {
+      m_sorted.resize(rcount);
+      int64_t* sorted = m_sorted.ptrw();
+      for (int64_t i = 0; i < rcount; i++)
+      {
+         sorted[i] = i;
+      }
+
+      // Sort is not stable, so ties are broken by the row index
+      struct RowComparator
+      {
+         const DBColumn* column;
+         bool operator()(int64_t a, int64_t b) const { return column->is_less(a, b) || (!column->is_less(b, a) && a < b); }
+      };
+
+      godot::SortArray<int64_t, RowComparator> sorter;
+      sorter.compare.column = &column;
+      sorter.sort(sorted, rcount);
+   }
+   else
+   {
+      // Rows are visited in order, so each bucket ends up sorted
+      for (int64_t i = 0; i < rcount; i++)
+      {
+         m_bucket[column.get(i)].push_back(i);
+      }
+   }
+}
+
+
+void DBColumnIndex::insert_row(const DBColumn& column, int64_t row)
+{
+   // Appended rows don't shift anything
+   if (row < column.size() - 1)
+   {
+      shift_rows(row, 1);
+   }
+   add_value(column, row);
+}
+
+
+void DBColumnIndex::remove_row(const DBColumn& column, int64_t row)
+{
+   erase_value(column, row);
+   shift_rows(row + 1, -1);
+}
+
+
+void DBColumnIndex::erase_value(const DBColumn& column, int64_t row)
+{
+   if (m_ordered)
+   {
+      const int64_t position = find_sorted_position(column, row);
+      if (position < m_sorted.size() && m_sorted[position] == row)
+      {
+         m_sorted.remove_at(position);
+      }
+   }
+   else
+   {
+      const godot::Variant value = column.get(row);
+      BucketMapType::Iterator iter = m_bucket.find(value);
+      if (iter == m_bucket.end())
+      {
+         return;
+      }
+
+      const int64_t position = iter->value.bsearch(row, true);
+      if (position < iter->value.size() && iter->value[position] == row)
+      {
+         iter->value.remove_at(position);
+      }
+
+      if (iter->value.is_empty())
+      {
+         m_bucket.erase(value);
+      }
+   }
+}
+
+
+void DBColumnIndex::add_value(const DBColumn& column, int64_t row)
+{
+   if (m_ordered)
+   {
+      m_sorted.insert(find_sorted_position(column, row), row);
+   }
+   else
+   {
+      godot::Vector<int64_t>& bucket = m_bucket[column.get(row)];
+      bucket.insert(bucket.bsearch(row, true), row);
+   }
+}
+
+
+godot::Vector<int64_t> DBColumnIndex::extract_bucket(const godot::Variant& value)
+{
+   godot::Vector<int64_t> ret;
+   ERR_FAIL_COND_V_MSG(m_ordered, ret, "Extracting a bucket requires a hash index.");
+
+   BucketMapType::Iterator iter = m_bucket.find(value);
+   if (iter != m_bucket.end())
+   {
+      ret = iter->value;
+      m_bucket.erase(value);
+   }
+
+   return ret;
+}
+
+
+void DBColumnIndex::merge_bucket(const godot::Variant& value, const godot::Vector<int64_t>& rows)
+{
+   ERR_FAIL_COND_MSG(m_ordered, "Merging into a bucket requires a hash index.");
+
+   if (rows.is_empty())
+   {
+      return;
+   }
+
+   godot::Vector<int64_t>& bucket = m_bucket[value];
+   if (bucket.is_empty())
+   {
+      bucket = rows;
+      return;
+   }
+
+   // Both lists are sorted, so a single merge pass keeps the bucket sorted
+   const int64_t bcount = bucket.size();
+   const int64_t rcount = rows.size();
+   const int64_t* b = bucket.ptr();
+   const int64_t* r = rows.ptr();
+
+   godot::Vector<int64_t> merged;
+   merged.resize(bcount + rcount);
+   int64_t* dest = merged.ptrw();
+
+   int64_t bi = 0;
+   int64_t ri = 0;
+   while (bi < bcount && ri < rcount)
+   {
+      *dest++ = b[bi] < r[ri] ? b[bi++] : r[ri++];
+   }
+   while (bi < bcount) { *dest++ = b[bi++]; }
+   while (ri < rcount) { *dest++ = r[ri++]; }
+
+   bucket = merged;
+}
+
+
+godot::PackedInt64Array DBColumnIndex::find(const DBColumn& column, const godot::Variant& value) const
+{
+   godot::PackedInt64Array ret;
+
+   if (m_ordered)
+   {
+      return find_in_range(column, value, value);
+   }
+
+   BucketMapType::ConstIterator iter = m_bucket.find(value);
+   if (iter != m_bucket.end())
+   {
+      const int64_t count = iter->value.size();
+      ret.resize(count);
+      memcpy(ret.ptrw(), iter->value.ptr(), count * sizeof(int64_t));
+   }
+
+   return ret;
+}
+
+
+godot::PackedInt64Array DBColumnIndex::find_in_range(const DBColumn& column, const godot::Variant& low, const godot::Variant& high) const
+{
+   ERR_FAIL_COND_V_MSG(!m_ordered, godot::PackedInt64Array(), "Range lookups require an ordered index.");
+   return find_range(column, &low, true, &high, true);
+}
+
+
+godot::PackedInt64Array DBColumnIndex::find_range(const DBColumn& column, const godot::Variant* low, bool low_inclusive, const godot::Variant* high, bool high_inclusive) const
+{
+   godot::PackedInt64Array ret;
+   ERR_FAIL_COND_V_MSG(!m_ordered, ret, "Range lookups require an ordered index.");
+
+   const int64_t* sorted = m_sorted.ptr();
+   const int64_t count = m_sorted.size();
+
+   // First entry within the lower bound
+   int64_t first = 0;
+   if (low)
+   {
+      int64_t last = count;
+      while (first < last)
+      {
+         const int64_t mid = first + ((last - first) >> 1);
+         const bool below = low_inclusive ? column.is_less_than(sorted[mid], *low) : !column.is_greater_than(sorted[mid], *low);
+         if (below)
+         {
+            first = mid + 1;
+         }
+         else
+         {
+            last = mid;
+         }
+      }
+   }
+
+   // First entry past the upper bound
+   int64_t end = count;
+   if (high)
+   {
+      int64_t start = first;
+      while (start < end)
+      {
+         const int64_t mid = start + ((end - start) >> 1);
+         const bool above = high_inclusive ? column.is_greater_than(sorted[mid], *high) : !column.is_less_than(sorted[mid], *high);
+         if (above)
+         {
+            end = mid;
+         }
+         else
+         {
+            start = mid + 1;
+         }
+      }
+   }
+
+   if (end > first)
+   {
+      ret.resize(end - first);
+      memcpy(ret.ptrw(), sorted + first, (end - first) * sizeof(int64_t));
+   }
+
+   return ret;
+}
+
+
+
+void DBColumnIndex::write(DBBinaryWriter& writer) const
+{
+   writer.write_u32(m_ordered ? 1 : 0);
+   writer.write_u32(0);
+
+   if (m_ordered)
+   {
+      db_write_vector(writer, m_sorted);
+      return;
+   }
+
+   // Bucket 'b' holds the rows in the [offset[b]..offset[b + 1]) range of the row list. The key of each bucket is not
+   // written, it's taken from the column value at the first row of the bucket
+   godot::Vector<int64_t> offset;
+   godot::Vector<int64_t> rows;
+   offset.resize(m_bucket.size() + 1);
+
+   int64_t* off = offset.ptrw();
+   int64_t bucket = 0;
+   int64_t total = 0;
+   for (BucketMapType::ConstIterator iter = m_bucket.begin(); iter != m_bucket.end(); ++iter)
+   {
+      off[bucket++] = total;
+      total += iter->value.size();
+   }
+   off[bucket] = total;
+
+   rows.resize(total);
+   int64_t* dest = rows.ptrw();
+   for (BucketMapType::ConstIterator iter = m_bucket.begin(); iter != m_bucket.end(); ++iter)
+   {
+      const int64_t count = iter->value.size();
+      memcpy(dest, iter->value.ptr(), count * sizeof(int64_t));
+      dest += count;
+   }
+
+   db_write_vector(writer, offset);
+   db_write_vector(writer, rows);
+}
+
+
+bool DBColumnIndex::read(DBBinaryReader& reader, const DBColumn& column)
+{
+   m_bucket.clear();
+   m_sorted.clear();
+
+   const uint32_t ordered = reader.read_u32();
+   reader.read_u32();
+   ERR_FAIL_COND_V_MSG(reader.has_error() || (ordered != 0) != m_ordered, false, "Reading secondary index, however the stored data doesn't match the index type.");
+
+   const int64_t rcount = column.size();
+
+   if (m_ordered)
+   {
+      if (!db_read_vector(reader, m_sorted) || m_sorted.size() != rcount)
+      {
+         m_sorted.clear();
+         return false;
+      }
+
+      const int64_t* sorted = m_sorted.ptr();
+      for (int64_t i = 0; i < rcount; i++)
+      {
+         if (sorted[i] < 0 || sorted[i] >= rcount)
+         {
+            m_sorted.clear();
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   godot::Vector<int64_t> offset;
+   godot::Vector<int64_t> rows;
+   if (!db_read_vector(reader, offset) || !db_read_vector(reader, rows) || offset.size() == 0 || rows.size() != rcount)
+   {
+      return false;
+   }
+
+   const int64_t bcount = offset.size() - 1;
+   const int64_t* off = offset.ptr();
+   const int64_t* row = rows.ptr();
+
+   if (off[0] != 0 || off[bcount] != rcount)
+   {
+      return false;
+   }
+
+   m_bucket.reserve(bcount);
+   for (int64_t b = 0; b < bcount; b++)
+   {
+      const int64_t first = off[b];
+      const int64_t count = off[b + 1] - first;
+      if (count <= 0 || first + count > rcount)
+      {
+         m_bucket.clear();
+         return false;
+      }
+
+      for (int64_t i = first; i < first + count; i++)
+      {
+         if (row[i] < 0 || row[i] >= rcount)
+         {
+            m_bucket.clear();
+            return false;
+         }
+      }
+
+      godot::Vector<int64_t> bucket;
+      bucket.resize(count);
+      memcpy(bucket.ptrw(), row + first, count * sizeof(int64_t));
+
+      m_bucket.insert(column.get(row[first]), bucket);
+   }
+
+   return true;
+}
+
+
+#endif  //DATABASE_DISABLED
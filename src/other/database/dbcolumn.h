@@ -0,0 +1,326 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _kehother_dbcolumn_h_included
+#define _kehother_dbcolumn_h_included 1
+
+#ifndef DATABASE_DISABLED
+
+
+#include <godot_cpp/templates/hash_map.hpp>
+#include <godot_cpp/templates/vector.hpp>
+#include <godot_cpp/variant/variant.hpp>
+
+
+class DBBinaryWriter;
+class DBBinaryReader;
+
+// Holds each distinct String only once. Columns storing strings keep handles (indices) into this pool, which are
+// reference counted so entries that are not used anymore can be recycled.
+class DBStringPool
+{
+private:
+   godot::Vector<godot::String> m_string;
+   godot::Vector<uint32_t> m_ref_count;
+
+   // Handles that were released and can be reused
+   godot::Vector<uint32_t> m_free;
+
+   // Maps from the String into its handle
+   godot::HashMap<godot::String, uint32_t> m_handle;
+
+public:
+   // Obtain the handle of the given String, adding it into the pool if necessary. Each call must be matched by a
+   // release() once the handle is not used anymore
+   uint32_t acquire(const godot::String& str);
+
+   void release(uint32_t handle);
+
+   const godot::String& get(uint32_t handle) const { return m_string[handle]; }
+
+   // Handle of the given String without adding it into the pool. Returns -1 if it's not held
+   int64_t find(const godot::String& str) const;
+
+   // Number of handles, including the ones that are not in use. Valid handles are always smaller than this
+   int64_t get_slot_count() const { return m_string.size(); }
+
+   // Number of distinct strings currently held
+   int64_t get_count() const { return m_handle.size(); }
+
+   // Returns true if the given handle points to a string that is currently held
+   bool is_valid(uint32_t handle) const { return handle < uint32_t(m_string.size()) && m_ref_count[handle] > 0; }
+
+   // Approximate number of bytes used by the held strings
+   int64_t get_memory_usage() const;
+
+   // Binary format. Handles are preserved, so columns can store theirs as they are
+   void write(DBBinaryWriter& writer) const;
+   bool read(DBBinaryReader& reader);
+
+   void clear();
+};
+
+
+
+// Stores all the values of a single column in a contiguous array, typed based on the kind of value held by the
+// column. The functions dealing with Variant are meant to provide the "Dictionary facade" of the DBTable while the
+// typed pointers are meant for scans.
+class DBColumn
+{
+public:
+   enum StorageType
+   {
+      ST_Integer,
+      ST_Float,
+      ST_Bool,
+      ST_String,           // Handles into a DBStringPool
+      ST_Color,
+      ST_Variant,          // Anything else, like the packed arrays
+   };
+
+   // Comparisons used when filtering rows
+   enum CompareOp
+   {
+      CO_Equal,
+      CO_NotEqual,
+      CO_Less,
+      CO_LessEqual,
+      CO_Greater,
+      CO_GreaterEqual,
+   };
+
+private:
+   StorageType m_storage;
+
+   // Only one of those will be used, depending on the storage type
+   godot::Vector<int64_t> m_int;
+   godot::Vector<double> m_float;
+   godot::Vector<uint8_t> m_bool;
+   godot::Vector<uint32_t> m_string;
+   godot::Vector<godot::Color> m_color;
+   godot::Vector<godot::Variant> m_variant;
+
+   // Owned by the table. Only used when storage is ST_String
+   DBStringPool* m_pool;
+
+public:
+   StorageType get_storage() const { return m_storage; }
+
+   int64_t size() const;
+
+   godot::Variant get(int64_t row) const;
+
+   // Incoming value is converted into the storage type
+   void set(int64_t row, const godot::Variant& value);
+
+   // Insert a value at the given row index. If the index is equal to size() then the value is appended
+   void insert(int64_t row, const godot::Variant& value);
+
+   // Insert all given values starting at the given row index. Subsequent values are shifted only once, regardless of
+   // how many values are inserted
+   void insert_range(int64_t row, const godot::Vector<godot::Variant>& values);
+
+   void remove(int64_t row);
+
+   // Remove every row flagged with a non zero value in 'removed', which must contain exactly size() entries. Remaining
+   // values are compacted in a single pass, keeping their relative order
+   void remove_marked(const uint8_t* removed);
+
+   void move(int64_t from, int64_t to);
+
+   // Reorder the values so the new row 'i' holds the value that was previously at 'permutation[i]'. The permutation
+   // must contain exactly size() entries
+   void apply_permutation(const int64_t* permutation);
+
+   // Returns true if the value at row 'a' should come before the value at row 'b' when sorting in ascending order.
+   // Colors are compared by hue, then saturation and then value
+   bool is_less(int64_t a, int64_t b) const;
+
+   // Fill 'out_key' (which must hold size() entries) with integers following the same order of the stored values, equal
+   // values getting equal keys. Sorting through those avoids going through the storage type on every comparison. Strings
+   // are only compared once per distinct value
+   void get_sort_keys(int64_t* out_key) const;
+
+   // Convert the given value into the type held by the storage
+   godot::Variant convert(const godot::Variant& value) const;
+
+   // Compare the value at 'row' against the given one, which is expected to be converted through convert()
+   bool is_less_than(int64_t row, const godot::Variant& value) const;
+   bool is_greater_than(int64_t row, const godot::Variant& value) const;
+   bool is_equal(int64_t row, const godot::Variant& value) const;
+
+   // Keep only the rows whose values pass the comparison against 'value' (converted through convert()). The rows to
+   // be tested are given by 'in_rows' or, if it's nullptr, are all rows in the [0..count) range. Passing rows are
+   // written into 'out_rows', which may be the same array as 'in_rows'. Returns how many rows passed
+   int64_t filter(CompareOp op, const godot::Variant& value, const int64_t* in_rows, int64_t count, int64_t* out_rows) const;
+
+   // Remove all values, releasing held strings
+   void clear();
+
+   // Typed access to the stored values, meant for scans. Each one returns nullptr if the storage type doesn't match
+   const int64_t* get_int_data() const { return m_storage == ST_Integer ? m_int.ptr() : nullptr; }
+   const double* get_float_data() const { return m_storage == ST_Float ? m_float.ptr() : nullptr; }
+   const uint8_t* get_bool_data() const { return m_storage == ST_Bool ? m_bool.ptr() : nullptr; }
+   const uint32_t* get_string_data() const { return m_storage == ST_String ? m_string.ptr() : nullptr; }
+   const godot::Color* get_color_data() const { return m_storage == ST_Color ? m_color.ptr() : nullptr; }
+   const godot::Variant* get_variant_data() const { return m_storage == ST_Variant ? m_variant.ptr() : nullptr; }
+
+   const godot::String& get_string(int64_t row) const { return m_pool->get(m_string[row]); }
+
+   // Retrieve a single value converted into the requested type, without going through Variant when the storage
+   // already matches (or is trivially convertible)
+   int64_t get_as_int(int64_t row) const;
+   double get_as_float(int64_t row) const;
+   bool get_as_bool(int64_t row) const;
+   godot::String get_as_string(int64_t row) const;
+
+   // Approximate number of bytes used by the values of this column. Strings are held by the pool and only the
+   // handles are counted
+   int64_t get_memory_usage() const;
+
+   // Binary format. When reading, the storage type must match the one given to the constructor and string handles are
+   // expected to point into a pool already loaded with the data written alongside this column. The column must be empty
+   void write(DBBinaryWriter& writer) const;
+   bool read(DBBinaryReader& reader);
+
+   DBColumn(StorageType storage = ST_Variant, DBStringPool* pool = nullptr) : m_storage(storage), m_pool(pool) {}
+};
+
+
+
+// Fenwick tree (binary indexed tree) holding the random weights of a table. Changing a single weight, appending a row,
+// querying an accumulated weight and locating the row corresponding to a roll all take O(log n). Rows inserted or
+// removed in the middle shift the indices of all subsequent rows, so in that case the tree must be rebuilt, which is
+// done in linear time.
+class DBWeightTree
+{
+private:
+   // Node 'i' (1 based) holds the sum of the weights in the rows (i - lowbit(i), i]. This array is 0 based, so node 'i'
+   // is stored at m_node[i - 1]
+   godot::Vector<double> m_node;
+
+   // Highest power of 2 that is not bigger than the number of rows. Starting point when locating a row
+   int64_t m_top_mask;
+
+   void update_top_mask();
+
+public:
+   int64_t size() const { return m_node.size(); }
+
+   // Rebuild the tree from the given weights. Negative weights are treated as 0
+   void build(const double* weight, int64_t count);
+
+   // Add a row at the end
+   void append(double weight);
+
+   // Add 'delta' into the weight of the given row
+   void add(int64_t row, double delta);
+
+   // Sum of the weights of the rows in the [0..row] range
+   double get_accumulated(int64_t row) const;
+
+   double get_total() const { return m_node.size() > 0 ? get_accumulated(m_node.size() - 1) : 0.0; }
+
+   // Locate the first row whose accumulated weight is bigger than the given roll, which is expected to be in the
+   // [0..total] range. If the roll is exactly the total then the last row with weight is returned
+   int64_t find(double roll) const;
+
+   int64_t get_memory_usage() const { return m_node.size() * sizeof(double); }
+
+   void clear() { m_node.clear(); m_top_mask = 0; }
+
+   // Binary format. The nodes are stored as they are, so nothing has to be rebuilt when reading
+   void write(DBBinaryWriter& writer) const;
+   bool read(DBBinaryReader& reader);
+
+   DBWeightTree() : m_top_mask(0) {}
+};
+
+
+
+// Secondary index over the values of a single column. A hash index maps each distinct value into the list of rows
+// holding it, allowing equality lookups. An ordered index keeps the row indices sorted by value, allowing range lookups.
+// Row indices are held, so the index must be notified of every change to the rows of the indexed column.
+class DBColumnIndex
+{
+private:
+   typedef godot::HashMap<godot::Variant, godot::Vector<int64_t>, godot::VariantHasher, godot::VariantComparator> BucketMapType;
+
+   bool m_ordered;
+
+   // Used by hash indexes. Each bucket holds row indices in ascending order
+   BucketMapType m_bucket;
+
+   // Used by ordered indexes. Row indices sorted by value then by index
+   godot::Vector<int64_t> m_sorted;
+
+   // Position within m_sorted where the given row is (or should be) placed
+   int64_t find_sorted_position(const DBColumn& column, int64_t row) const;
+
+   // Add 'delta' into every held row index that is equal or bigger than 'first'
+   void shift_rows(int64_t first, int64_t delta);
+
+public:
+   bool is_ordered() const { return m_ordered; }
+
+   void build(const DBColumn& column);
+
+   // Must be called after a row has been inserted into the column
+   void insert_row(const DBColumn& column, int64_t row);
+
+   // Must be called before the row is removed from the column
+   void remove_row(const DBColumn& column, int64_t row);
+
+   // When changing the value of a cell, call erase_value() before the change and add_value() after it
+   void erase_value(const DBColumn& column, int64_t row);
+   void add_value(const DBColumn& column, int64_t row);
+
+   // Hash indexes only. Remove the bucket of the given value, returning its rows in ascending order. Meant to be used when
+   // all cells holding a value are about to be changed, followed by merge_bucket() once the new value is set
+   godot::Vector<int64_t> extract_bucket(const godot::Variant& value);
+
+   // Hash indexes only. Merge rows, given in ascending order, into the bucket of the given value
+   void merge_bucket(const godot::Variant& value, const godot::Vector<int64_t>& rows);
+
+   // Indices of rows holding the given value. The value is expected to be converted through DBColumn::convert()
+   godot::PackedInt64Array find(const DBColumn& column, const godot::Variant& value) const;
+
+   // Indices of rows with values in the [low..high] range, sorted by value. Only ordered indexes support this
+   godot::PackedInt64Array find_in_range(const DBColumn& column, const godot::Variant& low, const godot::Variant& high) const;
+
+   // More general version of the above. A null bound means the range is not limited in that direction. Bounds are
+   // expected to be converted through DBColumn::convert()
+   godot::PackedInt64Array find_range(const DBColumn& column, const godot::Variant* low, bool low_inclusive, const godot::Variant* high, bool high_inclusive) const;
+
+   // Binary format. Ordered indexes are stored as they are. Hash indexes store the rows grouped by bucket, so reading
+   // only has to hash one value per bucket instead of one per row. The given column must already hold its values
+   void write(DBBinaryWriter& writer) const;
+   bool read(DBBinaryReader& reader, const DBColumn& column);
+
+   DBColumnIndex(bool ordered = false) : m_ordered(ordered) {}
+};
+
+
+#endif  //DATABASE_DISABLED
+
+#endif   // _kehother_dbcolumn_h_included
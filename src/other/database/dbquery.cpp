@@ -0,0 +1,387 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DATABASE_DISABLED
+
+#include "dbquery.h"
+#include "dbrowview.h"
+
+#include <godot_cpp/templates/sort_array.hpp>
+
+
+// Multi column ordering. Ties are broken by row index, which keeps the table order (the sort itself is not stable)
+struct QueryRowComparator
+{
+   const DBColumn* const* column;
+   const bool* ascending;
+   int64_t count;
+
+   bool operator()(int64_t a, int64_t b) const
+   {
+      for (int64_t i = 0; i < count; i++)
+      {
+         if (column[i]->is_less(a, b))
+         {
+            return ascending[i];
+         }
+         if (column[i]->is_less(b, a))
+         {
+            return !ascending[i];
+         }
+      }
+
+      return a < b;
+   }
+};
+
+
+
+const DBColumn* DBQuery::get_column(const DBTable& table, const godot::String& title)
+{
+   if (title == "id")
+   {
+      return &table.m_id_column;
+   }
+
+   return table.get_column_data(title);
+}
+
+
+int64_t DBQuery::fetch_from_index(const DBTable& table, godot::Vector<int64_t>& out_rows) const
+{
+   const int64_t ccount = m_condition.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      const Condition& cond = m_condition[i];
+
+      godot::HashMap<godot::String, DBColumnIndex>::ConstIterator iter = table.m_secondary_index.find(cond.column);
+      const DBColumn* column = table.get_column_data(cond.column);
+      if (iter == table.m_secondary_index.end() || !column)
+      {
+         continue;
+      }
+
+      const DBColumnIndex& cindex = iter->value;
+      const godot::Variant value = column->convert(cond.value);
+      godot::PackedInt64Array rows;
+
+      if (cond.op == OP_Equal)
+      {
+         rows = cindex.find(*column, value);
+      }
+      else if (cindex.is_ordered())
+      {
+         switch (cond.op)
+         {
+            case OP_Less: rows = cindex.find_range(*column, nullptr, false, &value, false); break;
+            case OP_LessEqual: rows = cindex.find_range(*column, nullptr, false, &value, true); break;
+            case OP_Greater: rows = cindex.find_range(*column, &value, false, nullptr, false); break;
+            case OP_GreaterEqual: rows = cindex.find_range(*column, &value, true, nullptr, false); break;
+
+            case OP_Between:
+            {
+               const godot::Variant high = column->convert(cond.high);
+               rows = cindex.find_range(*column, &value, true, &high, true);
+            } break;
+
+            default:
+            {
+               // Not equal can't take advantage of the index
+               continue;
+            }
+         }
+      }
+      else
+      {
+         continue;
+      }
+
+      const int64_t rcount = rows.size();
+      out_rows.resize(rcount);
+      if (rcount > 0)
+      {
+         memcpy(out_rows.ptrw(), rows.ptr(), rcount * sizeof(int64_t));
+
+         // Sorted indexes give the rows ordered by value. Restore the table order
+         godot::SortArray<int64_t> sorter;
+         sorter.sort(out_rows.ptrw(), rcount);
+      }
+
+      return i;
+   }
+
+   return -1;
+}
+
+
+void DBQuery::_bind_methods()
+{
+   using namespace godot;
+
+   ClassDB::bind_method(D_METHOD("where", "column_title", "op", "value"), &DBQuery::where);
+   ClassDB::bind_method(D_METHOD("where_between", "column_title", "low", "high"), &DBQuery::where_between);
+   ClassDB::bind_method(D_METHOD("order_by", "column_title", "ascending"), &DBQuery::order_by, DEFVAL(true));
+   ClassDB::bind_method(D_METHOD("limit", "count"), &DBQuery::limit);
+   ClassDB::bind_method(D_METHOD("offset", "count"), &DBQuery::offset);
+   ClassDB::bind_method(D_METHOD("select", "column_titles"), &DBQuery::select);
+   ClassDB::bind_method(D_METHOD("clear"), &DBQuery::clear);
+   ClassDB::bind_method(D_METHOD("find_indices", "table"), &DBQuery::find_indices);
+   ClassDB::bind_method(D_METHOD("find_rows", "table"), &DBQuery::find_rows);
+   ClassDB::bind_method(D_METHOD("find_views", "table"), &DBQuery::find_views);
+
+   BIND_ENUM_CONSTANT(OP_Equal);
+   BIND_ENUM_CONSTANT(OP_NotEqual);
+   BIND_ENUM_CONSTANT(OP_Less);
+   BIND_ENUM_CONSTANT(OP_LessEqual);
+   BIND_ENUM_CONSTANT(OP_Greater);
+   BIND_ENUM_CONSTANT(OP_GreaterEqual);
+}
+
+
+godot::Ref<DBQuery> DBQuery::where(const godot::String& column_title, Operator op, const godot::Variant& value)
+{
+   ERR_FAIL_COND_V_MSG(op < OP_Equal || op > OP_GreaterEqual, godot::Ref<DBQuery>(this), "Invalid query operator. Use where_between() for ranges.");
+
+   Condition cond;
+   cond.column = column_title;
+   cond.op = op;
+   cond.value = value;
+   m_condition.push_back(cond);
+
+   return godot::Ref<DBQuery>(this);
+}
+
+
+godot::Ref<DBQuery> DBQuery::where_between(const godot::String& column_title, const godot::Variant& low, const godot::Variant& high)
+{
+   Condition cond;
+   cond.column = column_title;
+   cond.op = OP_Between;
+   cond.value = low;
+   cond.high = high;
+   m_condition.push_back(cond);
+
+   return godot::Ref<DBQuery>(this);
+}
+
+
+godot::Ref<DBQuery> DBQuery::order_by(const godot::String& column_title, bool ascending)
+{
+   Ordering ordering;
+   ordering.column = column_title;
+   ordering.ascending = ascending;
+   m_ordering.push_back(ordering);
+
+   return godot::Ref<DBQuery>(this);
+}
+
+
+godot::Ref<DBQuery> DBQuery::limit(int64_t count)
+{
+   m_limit = count < 0 ? -1 : count;
+   return godot::Ref<DBQuery>(this);
+}
+
+
+godot::Ref<DBQuery> DBQuery::offset(int64_t count)
+{
+   m_offset = MAX(count, 0);
+   return godot::Ref<DBQuery>(this);
+}
+
+
+godot::Ref<DBQuery> DBQuery::select(const godot::PackedStringArray& column_titles)
+{
+   m_projection = column_titles;
+   return godot::Ref<DBQuery>(this);
+}
+
+
+void DBQuery::clear()
+{
+   m_condition.clear();
+   m_ordering.clear();
+   m_projection.clear();
+   m_limit = -1;
+   m_offset = 0;
+}
+
+
+godot::PackedInt64Array DBQuery::find_indices(const godot::Ref<DBTable>& table) const
+{
+   godot::PackedInt64Array ret;
+   ERR_FAIL_COND_V_MSG(!table.is_valid(), ret, "Attempting to execute a query without a valid table.");
+
+   const DBTable& tbl = *table.ptr();
+   const int64_t rcount = tbl.get_row_count();
+
+   godot::Vector<int64_t> selection;
+   const int64_t indexed = fetch_from_index(tbl, selection);
+
+   // While this is true the selection has not been filled, meaning that all rows are still selected
+   bool all_rows = indexed < 0;
+   if (all_rows)
+   {
+      selection.resize(rcount);
+   }
+
+   int64_t* rows = selection.ptrw();
+   int64_t scount = all_rows ? rcount : selection.size();
+
+   // Each condition filters the selection over a single column
+   const int64_t ccount = m_condition.size();
+   for (int64_t i = 0; i < ccount && scount > 0; i++)
+   {
+      if (i == indexed)
+      {
+         continue;
+      }
+
+      const Condition& cond = m_condition[i];
+      const DBColumn* column = get_column(tbl, cond.column);
+      ERR_FAIL_NULL_V_MSG(column, ret, godot::vformat("Query references column '%s', which does not exist in table '%s'.", cond.column, tbl.get_table_name()));
+
+      const int64_t* in_rows = all_rows ? nullptr : rows;
+      if (cond.op == OP_Between)
+      {
+         scount = column->filter(DBColumn::CO_GreaterEqual, column->convert(cond.value), in_rows, scount, rows);
+         scount = column->filter(DBColumn::CO_LessEqual, column->convert(cond.high), rows, scount, rows);
+      }
+      else
+      {
+         scount = column->filter((DBColumn::CompareOp)cond.op, column->convert(cond.value), in_rows, scount, rows);
+      }
+
+      all_rows = false;
+   }
+
+   if (all_rows)
+   {
+      for (int64_t i = 0; i < rcount; i++)
+      {
+         rows[i] = i;
+      }
+   }
+
+   // Ordering
+   const int64_t ocount = m_ordering.size();
+   if (ocount > 0 && scount > 1)
+   {
+      godot::Vector<const DBColumn*> key_column;
+      godot::Vector<bool> key_ascending;
+      key_column.resize(ocount);
+      key_ascending.resize(ocount);
+
+      for (int64_t i = 0; i < ocount; i++)
+      {
+         const Ordering& ordering = m_ordering[i];
+         const DBColumn* column = get_column(tbl, ordering.column);
+         ERR_FAIL_NULL_V_MSG(column, ret, godot::vformat("Query orders by column '%s', which does not exist in table '%s'.", ordering.column, tbl.get_table_name()));
+
+         key_column.ptrw()[i] = column;
+         key_ascending.ptrw()[i] = ordering.ascending;
+      }
+
+      godot::SortArray<int64_t, QueryRowComparator> sorter;
+      sorter.compare.column = key_column.ptr();
+      sorter.compare.ascending = key_ascending.ptr();
+      sorter.compare.count = ocount;
+      sorter.sort(rows, scount);
+   }
+
+   // Offset and limit
+   const int64_t first = MIN(m_offset, scount);
+   int64_t count = scount - first;
+   if (m_limit >= 0 && m_limit < count)
+   {
+      count = m_limit;
+   }
+
+   if (count > 0)
+   {
+      ret.resize(count);
+      memcpy(ret.ptrw(), rows + first, count * sizeof(int64_t));
+   }
+
+   return ret;
+}
+
+
+godot::Array DBQuery::find_rows(const godot::Ref<DBTable>& table) const
+{
+   godot::Array ret;
+   const godot::PackedInt64Array index_list = find_indices(table);
+   const int64_t icount = index_list.size();
+
+   ret.resize(icount);
+   for (int64_t i = 0; i < icount; i++)
+   {
+      ret[i] = make_row(*table.ptr(), index_list[i]);
+   }
+
+   return ret;
+}
+
+
+godot::Array DBQuery::find_views(const godot::Ref<DBTable>& table) const
+{
+   godot::Array ret;
+   const godot::PackedInt64Array index_list = find_indices(table);
+   const int64_t icount = index_list.size();
+
+   ret.resize(icount);
+   for (int64_t i = 0; i < icount; i++)
+   {
+      ret[i] = table->get_row_view_by_index(index_list[i]);
+   }
+
+   return ret;
+}
+
+
+godot::Dictionary DBQuery::make_row(const DBTable& table, int64_t row_index) const
+{
+   if (m_projection.is_empty())
+   {
+      return table.make_row(row_index);
+   }
+
+   godot::Dictionary ret;
+   ret["id"] = table.m_id_column.get(row_index);
+
+   const int64_t pcount = m_projection.size();
+   for (int64_t i = 0; i < pcount; i++)
+   {
+      const godot::String& title = m_projection[i];
+      const DBColumn* column = table.get_column_data(title);
+      if (column)
+      {
+         ret[title] = column->get(row_index);
+      }
+   }
+
+   return ret;
+}
+
+
+#endif  //DATABASE_DISABLED
@@ -0,0 +1,131 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _kehother_dbquery_h_included
+#define _kehother_dbquery_h_included 1
+
+#ifndef DATABASE_DISABLED
+
+#include <godot_cpp/classes/ref_counted.hpp>
+
+#include "dbtable.h"
+
+
+// Filters, sorts and slices the rows of a DBTable natively. A query is built once, through the chainable functions,
+// then executed as many times as needed, on any table containing the referenced columns. Conditions are combined with
+// "and". The row ID can be referenced through the "id" column title.
+// When executed, the first condition that can be answered by a secondary index of its column provides the candidate
+// rows. Every other condition then filters the candidates, one column at a time, over the typed column storage.
+class DBQuery : public godot::RefCounted
+{
+   GDCLASS(DBQuery, godot::RefCounted);
+public:
+   // The comparisons must match the order of DBColumn::CompareOp
+   enum Operator
+   {
+      OP_Equal,
+      OP_NotEqual,
+      OP_Less,
+      OP_LessEqual,
+      OP_Greater,
+      OP_GreaterEqual,
+      OP_Between,          // Inclusive range. Only created through where_between()
+   };
+
+private:
+   struct Condition
+   {
+      godot::String column;
+      Operator op;
+      godot::Variant value;
+      godot::Variant high;       // Only used by OP_Between
+   };
+
+   struct Ordering
+   {
+      godot::String column;
+      bool ascending;
+   };
+
+   godot::Vector<Condition> m_condition;
+   godot::Vector<Ordering> m_ordering;
+
+   // Columns to be included in the resulting Dictionaries. If empty then all columns are included
+   godot::PackedStringArray m_projection;
+
+   // -1 means no limit
+   int64_t m_limit;
+   int64_t m_offset;
+
+   // Retrieve the storage of a column, or the ID column if the title is "id"
+   static const DBColumn* get_column(const DBTable& table, const godot::String& title);
+
+   // Attempt to obtain the candidate rows through the secondary index of a condition's column. Returns the index of the
+   // used condition or -1 if no index could be used
+   int64_t fetch_from_index(const DBTable& table, godot::Vector<int64_t>& out_rows) const;
+
+protected:
+   static void _bind_methods();
+
+public:
+   // Add a condition comparing the values of a column against the given value
+   godot::Ref<DBQuery> where(const godot::String& column_title, Operator op, const godot::Variant& value);
+
+   // Add a condition requiring the values of a column to be in the [low..high] range
+   godot::Ref<DBQuery> where_between(const godot::String& column_title, const godot::Variant& low, const godot::Variant& high);
+
+   // Sort the results by the given column. Multiple calls result in sorting by the first column then by the second and
+   // so on. Rows with equal keys keep their table order
+   godot::Ref<DBQuery> order_by(const godot::String& column_title, bool ascending = true);
+
+   godot::Ref<DBQuery> limit(int64_t count);
+   godot::Ref<DBQuery> offset(int64_t count);
+
+   // Only include the given columns (the ID is always included) when building row Dictionaries
+   godot::Ref<DBQuery> select(const godot::PackedStringArray& column_titles);
+
+   // Remove everything that has been set
+   void clear();
+
+   // Execute the query, returning the indices of the resulting rows
+   godot::PackedInt64Array find_indices(const godot::Ref<DBTable>& table) const;
+
+   // Execute the query, returning the resulting rows as Dictionaries
+   godot::Array find_rows(const godot::Ref<DBTable>& table) const;
+
+   // Execute the query, returning read only views (DBRowView) of the resulting rows
+   godot::Array find_views(const godot::Ref<DBTable>& table) const;
+
+   // Build the Dictionary of a single row, taking the projection into account
+   godot::Dictionary make_row(const DBTable& table, int64_t row_index) const;
+
+   DBQuery() : m_limit(-1), m_offset(0) {}
+};
+
+
+VARIANT_ENUM_CAST(DBQuery::Operator);
+
+
+#endif  //DATABASE_DISABLED
+
+#endif  //_kehother_dbquery_h_included
@@ -0,0 +1,113 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DATABASE_DISABLED
+
+#include "dbrowview.h"
+#include "dbtable.h"
+
+
+void DBRowView::_bind_methods()
+{
+   using namespace godot;
+
+   ClassDB::bind_method(D_METHOD("is_valid"), &DBRowView::is_valid);
+   ClassDB::bind_method(D_METHOD("get_row_index"), &DBRowView::get_row_index);
+   ClassDB::bind_method(D_METHOD("get_id"), &DBRowView::get_id);
+   ClassDB::bind_method(D_METHOD("get_value", "column_title"), &DBRowView::get_value);
+   ClassDB::bind_method(D_METHOD("get_int", "column_handle"), &DBRowView::get_int);
+   ClassDB::bind_method(D_METHOD("get_float", "column_handle"), &DBRowView::get_float);
+   ClassDB::bind_method(D_METHOD("get_bool", "column_handle"), &DBRowView::get_bool);
+   ClassDB::bind_method(D_METHOD("get_string", "column_handle"), &DBRowView::get_string);
+   ClassDB::bind_method(D_METHOD("to_dictionary"), &DBRowView::to_dictionary);
+}
+
+
+void DBRowView::setup(const godot::Ref<DBTable>& table, int64_t row)
+{
+   m_table = table;
+   m_row = row;
+   m_version = table.is_valid() ? table->get_row_layout_version() : -1;
+}
+
+
+bool DBRowView::is_valid() const
+{
+   return m_table.is_valid() && m_version == m_table->get_row_layout_version() && m_row >= 0 && m_row < m_table->get_row_count();
+}
+
+
+godot::Variant DBRowView::get_id() const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), godot::Variant(), "Attempting to read from a row view that is not valid anymore.");
+   return m_table->get_row_id(m_row);
+}
+
+
+godot::Variant DBRowView::get_value(const godot::String& column_title) const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), godot::Variant(), "Attempting to read from a row view that is not valid anymore.");
+
+   const int64_t handle = m_table->get_column_handle(column_title);
+   ERR_FAIL_COND_V_MSG(handle < 0, godot::Variant(), godot::vformat("Attempting to read column '%s' from a row view, however the table doesn't have such column.", column_title));
+
+   return m_table->get_value(m_row, handle);
+}
+
+
+int64_t DBRowView::get_int(int64_t column_handle) const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), 0, "Attempting to read from a row view that is not valid anymore.");
+   return m_table->get_int(m_row, column_handle);
+}
+
+
+double DBRowView::get_float(int64_t column_handle) const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), 0.0, "Attempting to read from a row view that is not valid anymore.");
+   return m_table->get_float(m_row, column_handle);
+}
+
+
+bool DBRowView::get_bool(int64_t column_handle) const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), false, "Attempting to read from a row view that is not valid anymore.");
+   return m_table->get_bool(m_row, column_handle);
+}
+
+
+godot::String DBRowView::get_string(int64_t column_handle) const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), godot::String(), "Attempting to read from a row view that is not valid anymore.");
+   return m_table->get_string(m_row, column_handle);
+}
+
+
+godot::Dictionary DBRowView::to_dictionary() const
+{
+   ERR_FAIL_COND_V_MSG(!is_valid(), godot::Dictionary(), "Attempting to read from a row view that is not valid anymore.");
+   return m_table->get_row_by_index(m_row);
+}
+
+
+#endif  //DATABASE_DISABLED
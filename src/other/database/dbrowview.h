@@ -0,0 +1,79 @@
+/***
+ * Copyright (c) 2024 Yuri Sarudiansky
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _kehother_dbrowview_h_included
+#define _kehother_dbrowview_h_included 1
+
+#ifndef DATABASE_DISABLED
+
+#include <godot_cpp/classes/ref_counted.hpp>
+
+class DBTable;
+
+
+// Read only access to a single row of a DBTable, without building a Dictionary. The view references the table storage
+// directly, so it becomes invalid once rows of the table are inserted (not appended), removed, moved or sorted. Column
+// handles are obtained through DBTable::get_column_handle() and stale ones are rejected by the accessors.
+class DBRowView : public godot::RefCounted
+{
+   GDCLASS(DBRowView, godot::RefCounted);
+private:
+   godot::Ref<DBTable> m_table;
+   int64_t m_row;
+
+   // Row layout version of the table when this view was created
+   int64_t m_version;
+
+protected:
+   static void _bind_methods();
+
+public:
+   // Meant to be used by DBTable
+   void setup(const godot::Ref<DBTable>& table, int64_t row);
+
+   // Returns true if the view still points to the row it was created for
+   bool is_valid() const;
+
+   int64_t get_row_index() const { return m_row; }
+
+   godot::Variant get_id() const;
+
+   // Generic access given the column title
+   godot::Variant get_value(const godot::String& column_title) const;
+
+   // Typed access given a column handle
+   int64_t get_int(int64_t column_handle) const;
+   double get_float(int64_t column_handle) const;
+   bool get_bool(int64_t column_handle) const;
+   godot::String get_string(int64_t column_handle) const;
+
+   // Build a Dictionary from the viewed row, like DBTable::get_row_by_index()
+   godot::Dictionary to_dictionary() const;
+
+   DBRowView() : m_row(-1), m_version(-1) {}
+};
+
+
+#endif  //DATABASE_DISABLED
+
+#endif  //_kehother_dbrowview_h_included
@@ -24,84 +24,46 @@
 #ifndef DATABASE_DISABLED
 
 #include "dbtable.h"
+#include "dbrowview.h"
+#include "dbbinary.h"
 //#include "dbtablepatch.h"
 
 #include <godot_cpp/classes/json.hpp>
+#include <godot_cpp/templates/sort_array.hpp>
 
 #include <godot_cpp/variant/utility_functions.hpp>
 
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// DBTable::Sorter
-bool DBTable::Sorter::ascending_color(const godot::Dictionary& a, const godot::Dictionary& b) const
+/// DBTable
+void DBTable::column_set_external(const godot::String& other, godot::Dictionary& out_column)
 {
-   const godot::Color ca = a[column];
-   const godot::Color cb = b[column];
-
-   if (ca.get_h() < cb.get_h())
-   {
-      return true;
-   }
-   else if (ca.get_h() == cb.get_h())
+   if (other.is_empty())
    {
-      if (ca.get_s() < cb.get_s())
-      {
-         return true;
-      }
-      else if (ca.get_s() == cb.get_s())
+      if (out_column.has("extid"))
       {
-         if (ca.get_v() < cb.get_v())
-         {
-            return true;
-         }
+         out_column.erase("extid");
       }
    }
-   return false;
-}
-
-
-bool DBTable::Sorter::descending_color(const godot::Dictionary& a, const godot::Dictionary& b) const
-{
-   const godot::Color ca = a[column];
-   const godot::Color cb = b[column];
-
-   if (cb.get_h() < ca.get_h())
-   {
-      return true;
-   }
-   else if (cb.get_h() == ca.get_h())
+   else
    {
-      if (cb.get_s() < ca.get_s())
-      {
-         return true;
-      }
-      else if (cb.get_s() == ca.get_s())
-      {
-         if (cb.get_v() < ca.get_v())
-         {
-            return true;
-         }
-      }
+      out_column["extid"] = other;
    }
-   return false;
 }
 
 
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-/// DBTable
-void DBTable::column_set_external(const godot::String& other, godot::Dictionary& out_column)
+void DBTable::column_set_index_type(IndexType type, godot::Dictionary& out_column)
 {
-   if (other.is_empty())
+   if (type == IT_None)
    {
-      if (out_column.has("extid"))
+      if (out_column.has("index"))
       {
-         out_column.erase("extid");
+         out_column.erase("index");
       }
    }
    else
    {
-      out_column["extid"] = other;
+      out_column["index"] = type;
    }
 }
 
@@ -166,8 +128,9 @@ void DBTable::set_auto_weight(const godot::String& title, bool is_new)
    if (title.is_empty())
    {
       m_rand_weight.column = "";
-      m_rand_weight.acc_weight.clear();
-      m_rand_weight.acc_weight.resize(0);
+      m_rand_weight.tree.clear();
+      m_rand_weight.alias_prob.clear();
+      m_rand_weight.alias_index.clear();
    }
    else
    {
@@ -181,20 +144,8 @@ void DBTable::set_auto_weight(const godot::String& title, bool is_new)
 
       if (is_new)
       {
-         const int64_t rcount = get_row_count();
-
-         m_rand_weight.total_weight = (double)rcount;
-         m_rand_weight.acc_weight.resize(rcount);
-
-         // godot::Vector<> does not provide non const access through [] operator
-         double* acc_weight = m_rand_weight.acc_weight.ptrw();
-
-         double acc = 1.0;
-         for (int64_t i = 0; i < rcount; i++)
-         {
-            acc_weight[i] = acc;
-            acc += 1.0;
-         }
+         // New weight cells are filled with the default weight, so just build from the column
+         calculate_weights();
       }
    }
 }
@@ -210,27 +161,156 @@ void DBTable::calculate_weights()
 
    const int64_t rcount = get_row_count();
 
-   if (m_rand_weight.acc_weight.size() != rcount)
+   // Weights are held in a contiguous array of doubles, so the tree can be built in a single linear pass. While
+   // loading, the column storage may not be filled yet, in which case the weights are considered 0 for now
+   const DBColumn* wcolumn = get_column_data(m_rand_weight.column);
+   const double* weight = (wcolumn && wcolumn->size() == rcount) ? wcolumn->get_float_data() : nullptr;
+
+   m_rand_weight.tree.build(weight, rcount);
+   m_rand_weight.total_weight = m_rand_weight.tree.get_total();
+
+   // Don't rebuild the alias table right away. Multiple changes may happen before the next pick
+   m_rand_weight.alias_dirty = true;
+}
+
+
+void DBTable::update_row_weight(int64_t row_index, double old_weight, double new_weight)
+{
+   if (m_rand_weight.tree.size() != get_row_count())
    {
-      m_rand_weight.acc_weight.resize(rcount);
+      calculate_weights();
+      return;
    }
 
-   // godot::Vector<> does not provide non const access through [] operator. Obtain raw pointer to
-   // allow [] usage
-   double* acc_weight = m_rand_weight.acc_weight.ptrw();
-   double acc = 0.0;
+   m_rand_weight.tree.add(row_index, MAX(new_weight, 0.0) - MAX(old_weight, 0.0));
+   m_rand_weight.total_weight = m_rand_weight.tree.get_total();
+   m_rand_weight.alias_dirty = true;
+}
+
+
+void DBTable::build_alias_table() const
+{
+   const int64_t rcount = get_row_count();
+   const double total = m_rand_weight.total_weight;
+
+   m_rand_weight.alias_prob.resize(rcount);
+   m_rand_weight.alias_index.resize(rcount);
+   m_rand_weight.alias_dirty = false;
+
+   if (rcount == 0 || total <= 0.0)
+   {
+      return;
+   }
+
+   double* prob = m_rand_weight.alias_prob.ptrw();
+   int64_t* alias = m_rand_weight.alias_index.ptrw();
+
+   const DBColumn* wcolumn = get_column_data(m_rand_weight.column);
+   const double* weight = wcolumn ? wcolumn->get_float_data() : nullptr;
+
+   // Both work lists of Vose's method share a single array. Rows with scaled weight below 1 ("small") are stacked
+   // from the front while the others ("large") are stacked from the back
+   godot::Vector<int64_t> work;
+   work.resize(rcount);
+   int64_t* stack = work.ptrw();
+   int64_t small_count = 0;
+   int64_t large_first = rcount;
 
+   // Scale the weights so the average becomes 1
+   const double scale = (double)rcount / total;
    for (int64_t i = 0; i < rcount; i++)
    {
-      const godot::Dictionary row = m_row_list[i];
+      const double w = weight ? weight[i] : 0.0;
+      prob[i] = w > 0.0 ? w * scale : 0.0;
+      alias[i] = i;
 
-      const double w = row.get(m_rand_weight.column, 0.0);
-      acc += w;
+      if (prob[i] < 1.0)
+      {
+         stack[small_count++] = i;
+      }
+      else
+      {
+         stack[--large_first] = i;
+      }
+   }
+
+   // Each small row gets its remaining probability filled by a large one
+   while (small_count > 0 && large_first < rcount)
+   {
+      const int64_t s = stack[--small_count];
+      const int64_t l = stack[large_first];
 
-      acc_weight[i] = acc;
+      alias[s] = l;
+      prob[l] = (prob[l] + prob[s]) - 1.0;
+
+      if (prob[l] < 1.0)
+      {
+         // The large row became small. There is always room for it as one small row has just been removed
+         large_first++;
+         stack[small_count++] = l;
+      }
    }
 
-   m_rand_weight.total_weight = acc;
+   // Whatever is left should have probability 1, bar floating point errors
+   for (int64_t i = 0; i < small_count; i++)
+   {
+      prob[stack[i]] = 1.0;
+   }
+   for (int64_t i = large_first; i < rcount; i++)
+   {
+      prob[stack[i]] = 1.0;
+   }
+}
+
+
+int64_t DBTable::roll_row_index(const godot::Ref<godot::RandomNumberGenerator>& rng) const
+{
+   const godot::Ref<godot::RandomNumberGenerator>& randgen = rng.is_valid() ? rng : m_rand_gen;
+   const int64_t rcount = get_row_count();
+
+   if (rcount == 0)
+   {
+      return -1;
+   }
+
+   if (m_rand_weight.column.is_empty())
+   {
+      return randgen->randi_range(0, rcount - 1);
+   }
+
+   if (m_rand_weight.total_weight <= 0.0)
+   {
+      return -1;
+   }
+
+   if (m_rand_weight.pick_mode == RPM_Alias)
+   {
+      if (m_rand_weight.alias_dirty || m_rand_weight.alias_prob.size() != rcount)
+      {
+         build_alias_table();
+      }
+
+      const int64_t index = randgen->randi_range(0, rcount - 1);
+      return randgen->randf() < m_rand_weight.alias_prob[index] ? index : m_rand_weight.alias_index[index];
+   }
+
+   // Locate the first row whose accumulated weight is bigger than the roll by descending the weight tree
+   const double roll = randgen->randf_range(0.0, m_rand_weight.total_weight);
+   return m_rand_weight.tree.find(roll);
+}
+
+
+void DBTable::set_random_pick_mode(RandomPickMode mode)
+{
+   m_rand_weight.pick_mode = mode;
+
+   if (mode != RPM_Alias)
+   {
+      // Release the memory. If the mode is changed back the table will be rebuilt on the next pick
+      m_rand_weight.alias_prob.clear();
+      m_rand_weight.alias_index.clear();
+   }
+   m_rand_weight.alias_dirty = true;
 }
 
 
@@ -239,6 +319,13 @@ void DBTable::build_column_index()
    m_column_index.clear();
    const int64_t ccount = m_column_array.size();
 
+   // Column storage is rebuilt too. Values will be added when the row list is set
+   for (int64_t i = 0; i < m_column_data.size(); i++)
+   {
+      m_column_data.ptrw()[i].clear();
+   }
+   m_column_data.clear();
+
    for (int64_t i = 0; i < ccount; i++)
    {
       const godot::Dictionary column = m_column_array[i];
@@ -247,6 +334,7 @@ void DBTable::build_column_index()
       ERR_FAIL_COND_MSG(title.is_empty(), "Building column index, however retrieved a column without a title!");
    #endif
       m_column_index[title] = column;
+      m_column_data.push_back(DBColumn(get_storage_type(column_get_type(column)), &m_string_pool));
 
       const ValueType type = column_get_type(column);
       if (type == VT_RandomWeight)
@@ -254,6 +342,9 @@ void DBTable::build_column_index()
          set_auto_weight(title, true);
       }
    }
+
+   build_column_slots();
+   build_secondary_index();
 }
 
 
@@ -282,12 +373,11 @@ void DBTable::build_unique_index()
       ValueSetType& uset = m_unique_indexing[title];
       uset.clear();
 
-      const int64_t rcount = get_row_count();
-      for (int64_t i = 0; i < rcount; i++)
+      const DBColumn& cdata = m_column_data[i];
+      const int64_t rcount = cdata.size();
+      for (int64_t r = 0; r < rcount; r++)
       {
-         const godot::Dictionary row = m_row_list[i];
-         const godot::Variant value = row.get(title, nullptr);
-         uset.insert(value);
+         uset.insert(cdata.get(r));
       }
    }
 }
@@ -296,16 +386,358 @@ void DBTable::build_unique_index()
 void DBTable::build_row_index()
 {
    m_row_index.clear();
+   m_dense_row.clear();
+   m_free_id.clear();
+   m_next_id = 0;
+   reindex_rows(0);
+
+   if (m_dense_id)
+   {
+      // Gaps bellow the next ID are given to new rows first. Pushed from the end so the lowest ones are taken first
+      for (int64_t i = m_next_id - 1; i >= 0; i--)
+      {
+         if (m_dense_row[i] < 0)
+         {
+            m_free_id.push_back(i);
+         }
+      }
+   }
+}
+
+
+int64_t DBTable::find_row(const godot::Variant& id) const
+{
+   if (m_dense_id)
+   {
+      if (id.get_type() != godot::Variant::INT)
+      {
+         return -1;
+      }
+
+      const int64_t iid = id;
+      return (iid >= 0 && iid < m_dense_row.size()) ? m_dense_row[iid] : -1;
+   }
+
+   RowIndexType::ConstIterator iter = m_row_index.find(id);
+   return iter != m_row_index.end() ? iter->value : -1;
+}
+
+
+void DBTable::set_row_entry(const godot::Variant& id, int64_t index)
+{
+   if (!m_dense_id)
+   {
+      m_row_index[id] = index;
+      return;
+   }
+
+   const int64_t iid = id;
+#ifdef DEBUG_ENABLED
+   ERR_FAIL_COND_MSG(iid < 0, "Setting row indexing in dense ID mode, however got a negative ID.");
+#endif
+
+   const int64_t old_size = m_dense_row.size();
+   if (iid >= old_size)
+   {
+      // Grow geometrically so appending rows one by one doesn't resize the array every time
+      m_dense_row.resize(MAX(iid + 1, old_size * 2));
+      int64_t* entry = m_dense_row.ptrw();
+      for (int64_t i = old_size; i < m_dense_row.size(); i++)
+      {
+         entry[i] = -1;
+      }
+   }
+
+   m_dense_row.set(iid, index);
+   m_next_id = MAX(m_next_id, iid + 1);
+}
+
+
+void DBTable::erase_row_entry(const godot::Variant& id)
+{
+   if (!m_dense_id)
+   {
+      m_row_index.erase(id);
+      return;
+   }
+
+   const int64_t iid = id;
+   if (iid >= 0 && iid < m_dense_row.size() && m_dense_row[iid] >= 0)
+   {
+      m_dense_row.set(iid, -1);
+      m_free_id.push_back(iid);
+   }
+}
+
+
+int64_t DBTable::find_invalid_dense_id() const
+{
    const int64_t rcount = get_row_count();
+   const int64_t* id = m_id_column.get_int_data();
    for (int64_t i = 0; i < rcount; i++)
    {
-      const godot::Dictionary row = m_row_list[i];
-      const godot::Variant id = row.get("id", nullptr);
+      if (!is_dense_id_valid(id[i]))
+      {
+         return i;
+      }
+   }
+
+   return -1;
+}
+
+
+void DBTable::validate_loaded_dense_id()
+{
+   if (!m_dense_id)
+   {
+      return;
+   }
+
+   const int64_t invalid = find_invalid_dense_id();
+   if (invalid >= 0)
+   {
+      WARN_PRINT(godot::vformat("Table '%s' is flagged to use dense IDs, however row ID %d is either negative or too big. Falling back to the hash row indexing.", m_table_name, m_id_column.get(invalid)));
+      m_dense_id = false;
+   }
+}
+
+
+DBTable::IndexType DBTable::column_get_built_index_type(const godot::Dictionary& column) const
+{
+   const IndexType type = column_get_index_type(column);
+   if (type == IT_None && !column_get_external(column).is_empty())
+   {
+      return IT_Hash;
+   }
+
+   return type;
+}
+
+
+void DBTable::build_secondary_index()
+{
+   m_secondary_index.clear();
+
+   const int64_t ccount = m_column_array.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      const godot::Dictionary column = m_column_array[i];
+      const IndexType type = column_get_built_index_type(column);
+      if (type == IT_None)
+      {
+         continue;
+      }
+
+      DBColumnIndex& cindex = m_secondary_index.insert(column_get_title(column), DBColumnIndex(type == IT_Sorted))->value;
+      cindex.build(m_column_data[i]);
+   }
+}
+
+
+void DBTable::rebuild_secondary_index(const godot::String& column_title)
+{
+   godot::HashMap<godot::String, DBColumnIndex>::Iterator iter = m_secondary_index.find(column_title);
+   const DBColumn* cdata = get_column_data(column_title);
+   if (iter == m_secondary_index.end() || !cdata)
+   {
+      return;
+   }
+
+   iter->value.build(*cdata);
+}
+
+
+void DBTable::secondary_index_row_inserted(int64_t row_index)
+{
+   for (godot::HashMap<godot::String, DBColumnIndex>::Iterator iter = m_secondary_index.begin(); iter != m_secondary_index.end(); ++iter)
+   {
+      const DBColumn* cdata = get_column_data(iter->key);
+      if (cdata)
+      {
+         iter->value.insert_row(*cdata, row_index);
+      }
+   }
+}
+
+
+void DBTable::secondary_index_row_removed(int64_t row_index)
+{
+   for (godot::HashMap<godot::String, DBColumnIndex>::Iterator iter = m_secondary_index.begin(); iter != m_secondary_index.end(); ++iter)
+   {
+      const DBColumn* cdata = get_column_data(iter->key);
+      if (cdata)
+      {
+         iter->value.remove_row(*cdata, row_index);
+      }
+   }
+}
+
+
+void DBTable::reindex_rows(int64_t first)
+{
+   m_row_layout_version++;
+
+   const int64_t rcount = get_row_count();
+   for (int64_t i = first; i < rcount; i++)
+   {
+      const godot::Variant id = m_id_column.get(i);
    #ifdef DEBUG_ENABLED
-      ERR_FAIL_COND_MSG(id.get_type() == godot::Variant::NIL, "Building row index, however found a row without ID");
       ERR_FAIL_COND_MSG(id.get_type() != m_id_type, "Building row indexing, however got row ID with type that doesn't match that of the table");
    #endif
-      m_row_index[id] = row;
+      set_row_entry(id, i);
+   }
+}
+
+
+void DBTable::build_column_slots()
+{
+   m_column_layout_version++;
+   m_column_slot.clear();
+   const int64_t ccount = m_column_array.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      const godot::Dictionary column = m_column_array[i];
+      m_column_slot[column_get_title(column)] = i;
+   }
+}
+
+
+int64_t DBTable::get_column_slot(int64_t column_handle) const
+{
+   // Handles hold the slot in the lower 32 bits and the column layout version in the upper ones
+   const int64_t slot = column_handle & 0xFFFFFFFF;
+   const int64_t version = column_handle >> 32;
+
+   ERR_FAIL_COND_V_MSG(column_handle < 0 || slot >= m_column_data.size(), -1, godot::vformat("Column handle %d is not valid for table '%s'.", column_handle, m_table_name));
+   ERR_FAIL_COND_V_MSG(version != (m_column_layout_version & 0x7FFFFFFF), -1, godot::vformat("Column handle %d of table '%s' was obtained before its columns changed. Retrieve it again through get_column_handle().", column_handle, m_table_name));
+
+   return slot;
+}
+
+
+DBColumn::StorageType DBTable::get_storage_type(ValueType type)
+{
+   switch (type)
+   {
+      case VT_UniqueInteger:
+      case VT_LockedUniqueInteger:
+      case VT_ExternalInteger:
+      case VT_Integer:
+         return DBColumn::ST_Integer;
+
+      case VT_RandomWeight:
+      case VT_Float:
+         return DBColumn::ST_Float;
+
+      case VT_Bool:
+         return DBColumn::ST_Bool;
+
+      case VT_UniqueString:
+      case VT_LockedUniqueString:
+      case VT_ExternalString:
+      case VT_String:
+      case VT_Texture:
+      case VT_Audio:
+      case VT_GenericRes:
+      case VT_MultiLineString:
+         return DBColumn::ST_String;
+
+      case VT_Color:
+         return DBColumn::ST_Color;
+   }
+
+   // The array types (and anything unknown) are kept as Variants. Packed arrays are already contiguous anyway
+   return DBColumn::ST_Variant;
+}
+
+
+DBColumn* DBTable::get_column_data(const godot::String& title)
+{
+   godot::HashMap<godot::String, int64_t>::ConstIterator iter = m_column_slot.find(title);
+   if (iter == m_column_slot.end())
+   {
+      return nullptr;
+   }
+
+   return m_column_data.ptrw() + iter->value;
+}
+
+
+const DBColumn* DBTable::get_column_data(const godot::String& title) const
+{
+   godot::HashMap<godot::String, int64_t>::ConstIterator iter = m_column_slot.find(title);
+   if (iter == m_column_slot.end())
+   {
+      return nullptr;
+   }
+
+   return m_column_data.ptr() + iter->value;
+}
+
+
+godot::Dictionary DBTable::make_row(int64_t index) const
+{
+   godot::Dictionary ret;
+   ret["id"] = m_id_column.get(index);
+
+   const int64_t ccount = m_column_data.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      const godot::Dictionary column = m_column_array[i];
+      ret[column_get_title(column)] = m_column_data[i].get(index);
+   }
+
+   return ret;
+}
+
+
+godot::Array DBTable::get_row_list() const
+{
+   godot::Array ret;
+
+   const int64_t rcount = get_row_count();
+   for (int64_t i = 0; i < rcount; i++)
+   {
+      ret.append(make_row(i));
+   }
+
+   return ret;
+}
+
+
+void DBTable::set_row_list(const godot::Array& list)
+{
+   m_id_column.clear();
+   m_id_column = DBColumn(m_id_type == godot::Variant::STRING ? DBColumn::ST_String : DBColumn::ST_Integer, &m_string_pool);
+
+   const int64_t ccount = m_column_array.size();
+   for (int64_t c = 0; c < ccount; c++)
+   {
+      m_column_data.ptrw()[c].clear();
+   }
+
+   const int64_t rcount = list.size();
+   for (int64_t r = 0; r < rcount; r++)
+   {
+      const godot::Dictionary row = list[r];
+      const godot::Variant id = row.get("id", nullptr);
+
+      ERR_CONTINUE_MSG(id.get_type() != m_id_type, "Loading table rows, however found a row without ID or with ID type that doesn't match that of the table");
+
+      const int64_t index = m_id_column.size();
+      m_id_column.insert(index, id);
+
+      for (int64_t c = 0; c < ccount; c++)
+      {
+         const godot::Dictionary column = m_column_array[c];
+         godot::Variant value = row.get(column_get_title(column), nullptr);
+         if (value.get_type() == godot::Variant::NIL)
+         {
+            value = get_default_value(column);
+         }
+
+         m_column_data.ptrw()[c].insert(index, value);
+      }
    }
 }
 
@@ -341,6 +773,24 @@ godot::String DBTable::make_random_string(int32_t length)
 // So relying on the "ordinary" random number generator. It's good enough for this purpose anyway.
 int64_t DBTable::generate_int_id()
 {
+   if (m_dense_id)
+   {
+      // Reuse IDs of removed rows first. Entries may have been taken by set_row_id() in the mean time, so skip those
+      while (m_free_id.size() > 0)
+      {
+         const int64_t last = m_free_id.size() - 1;
+         const int64_t id = m_free_id[last];
+         m_free_id.remove_at(last);
+
+         if (id < m_dense_row.size() && m_dense_row[id] < 0)
+         {
+            return id;
+         }
+      }
+
+      return m_next_id++;
+   }
+
    int64_t ret = m_rand_gen->randi();
 
    while (ret < 0 || m_row_index.has(ret))
@@ -366,13 +816,13 @@ godot::String DBTable::generate_str_id()
 
 void DBTable::add_row(const godot::Variant& id, const godot::Dictionary& values, int64_t index)
 {
-   if (index < 0 || index > m_row_list.size())
+   const int64_t rcount = get_row_count();
+   if (index < 0 || index > rcount)
    {
-      index = m_row_list.size();
+      index = rcount;
    }
 
-   godot::Dictionary row;
-   row["id"] = id;
+   m_id_column.insert(index, id);
 
    // Assume there is a column with random weights and the new row does not contain a value for it
    double rweight = 1.0;
@@ -402,7 +852,7 @@ void DBTable::add_row(const godot::Variant& id, const godot::Dictionary& values,
          }
       }
 
-      row[title] = value;
+      m_column_data.ptrw()[i].insert(index, value);
 
       if (title == m_rand_weight.column)
       {
@@ -410,9 +860,12 @@ void DBTable::add_row(const godot::Variant& id, const godot::Dictionary& values,
       }
    }
 
-   if (index < m_row_list.size())
+   secondary_index_row_inserted(index);
+
+   if (index < rcount)
    {
-      m_row_list.insert(index, row);
+      // The row has been inserted, so the subsequent rows got their indices shifted
+      reindex_rows(index);
 
       // The row has been inserted, which basically affects all subsequent accumulated weights (if any).
       // Rebuild everything (although it would be better to recalculated only the ones from this new row
@@ -421,20 +874,17 @@ void DBTable::add_row(const godot::Variant& id, const godot::Dictionary& values,
    }
    else
    {
-      m_row_list.append(row);
-      
+      set_row_entry(id, index);
+
       // Since the row has been appended, updating the weights is simpler - if there are any weights that is
       if (!m_rand_weight.column.is_empty())
       {
-         const double nacc = m_rand_weight.total_weight + rweight;
-
-         m_rand_weight.acc_weight.append(nacc);
+         m_rand_weight.tree.append(rweight);
 
-         m_rand_weight.total_weight = nacc;
+         m_rand_weight.total_weight = m_rand_weight.tree.get_total();
+         m_rand_weight.alias_dirty = true;
       }
    }
-
-   m_row_index[id] = row;
 }
 
 
@@ -726,53 +1176,64 @@ godot::Color DBTable::convert_to_color(const godot::Variant& value) const
 
 void DBTable::convert_value_type(const godot::String& column_title, ValueType to_type)
 {
+   DBColumn* cdata = get_column_data(column_title);
+   if (!cdata)
+   {
+      return;
+   }
+
+   // The storage may change, so build a new column with the converted values then replace the old one
+   DBColumn converted(get_storage_type(to_type), &m_string_pool);
+
    /// NOTE: In here not using any of the Unique* types because those are not meant to be changed after creation
    const int64_t rcount = get_row_count();
    for (int64_t i = 0; i < rcount; i++)
    {
-      godot::Dictionary row = m_row_list[i];
-      godot::Variant value = row[column_title];
-      if (value.get_type() == godot::Variant::NIL)
-      {
-         continue;
-      }
+      godot::Variant value = cdata->get(i);
 
       /// FIXME: Add the various "array" types
       switch (to_type)
       {
          case VT_String:
          {
-            row[column_title] = convert_to_string(value);
+            value = convert_to_string(value);
          } break;
 
          case VT_Bool:
          {
-            row[column_title] = convert_to_bool(value);
+            value = convert_to_bool(value);
          } break;
 
          case VT_Integer:
          {
-            row[column_title] = convert_to_int(value);
+            value = convert_to_int(value);
          } break;
 
          case VT_Float:
          {
-            row[column_title] = convert_to_double(value);
+            value = convert_to_double(value);
          } break;
 
          case VT_Texture:
          case VT_Audio:
          case VT_GenericRes:
          {
-            row[column_title] = convert_to_path(value);
+            value = convert_to_path(value);
          } break;
 
          case VT_Color:
          {
-            row[column_title] = convert_to_color(value);
+            value = convert_to_color(value);
          }
       }
+
+      converted.insert(i, value);
    }
+
+   cdata->clear();
+   *cdata = converted;
+
+   rebuild_secondary_index(column_title);
 }
 
 
@@ -817,16 +1278,41 @@ void DBTable::referenced_row_id_changed(const godot::String& other_table, const
       return;
    }
 
+   DBColumn* cdata = get_column_data(column_name);
+   if (!cdata)
+   {
+      return;
+   }
+
+   const godot::Variant from = cdata->convert(id_from);
+   const godot::Variant to = cdata->convert(id_to);
+
+   godot::HashMap<godot::String, DBColumnIndex>::Iterator sindex = m_secondary_index.find(column_name);
+   if (sindex != m_secondary_index.end() && !sindex->value.is_ordered())
+   {
+      // The reverse reference index directly gives the rows pointing to the changed ID, so only those are touched
+      const godot::Vector<int64_t> rows = sindex->value.extract_bucket(from);
+      const int64_t count = rows.size();
+      for (int64_t i = 0; i < count; i++)
+      {
+         cdata->set(rows[i], to);
+      }
+
+      sindex->value.merge_bucket(to, rows);
+      return;
+   }
+
    // Go through all cells and update the changed ID
    const int64_t rcount = get_row_count();
    for (int64_t i = 0; i < rcount; i++)
    {
-      godot::Dictionary row = m_row_list[i];
-      if (row[column_name] == id_from)
+      if (cdata->is_equal(i, from))
       {
-         row[column_name] = id_to;
+         cdata->set(i, to);
       }
    }
+
+   rebuild_secondary_index(column_name);
 }
 
 
@@ -842,17 +1328,45 @@ void DBTable::referenced_rows_removed(const godot::String& other_table, const Va
    godot::Dictionary column = m_column_index[column_name];
    const godot::Variant def_val = get_default_value(column);
 
+   DBColumn* cdata = get_column_data(column_name);
+   if (!cdata)
+   {
+      return;
+   }
+
+   godot::HashMap<godot::String, DBColumnIndex>::Iterator sindex = m_secondary_index.find(column_name);
+   if (sindex != m_secondary_index.end() && !sindex->value.is_ordered())
+   {
+      // Gather the rows pointing to any of the removed IDs from the reverse reference index. Each row holds a single value,
+      // so the buckets don't overlap
+      godot::Vector<int64_t> rows;
+      for (ValueSetType::Iterator iter = id_list.begin(); iter != id_list.end(); ++iter)
+      {
+         rows.append_array(sindex->value.extract_bucket(cdata->convert(*iter)));
+      }
+
+      rows.sort();
+
+      const int64_t count = rows.size();
+      for (int64_t i = 0; i < count; i++)
+      {
+         cdata->set(rows[i], def_val);
+      }
+
+      sindex->value.merge_bucket(cdata->convert(def_val), rows);
+      return;
+   }
+
    const int64_t rcount = get_row_count();
    for (int64_t i = 0; i < rcount; i++)
    {
-      godot::Dictionary row = m_row_list[i];
-      const godot::Variant stored = row.get(column_name, nullptr);
-
-      if (id_list.has(stored))
+      if (id_list.has(cdata->get(i)))
       {
-         row[column_name] = def_val;
+         cdata->set(i, def_val);
       }
    }
+
+   rebuild_secondary_index(column_name);
 }
 
 
@@ -864,6 +1378,7 @@ void DBTable::_get_property_list(godot::List<godot::PropertyInfo>* out_list) con
    out_list->push_back(PropertyInfo(Variant::STRING, "table_name", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
    out_list->push_back(PropertyInfo(Variant::INT, "id_type", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
    out_list->push_back(PropertyInfo(Variant::BOOL, "locked_row_id", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
+   out_list->push_back(PropertyInfo(Variant::BOOL, "dense_row_id", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
    out_list->push_back(PropertyInfo(Variant::ARRAY, "column", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
    out_list->push_back(PropertyInfo(Variant::DICTIONARY, "ref_table", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
    out_list->push_back(PropertyInfo(Variant::ARRAY, "row_list", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_STORAGE));
@@ -885,11 +1400,19 @@ bool DBTable::_set(const godot::StringName& prop_name, const godot::Variant& val
    else if (prop_name == godot::StringName("id_type"))
    {
       m_id_type = value;
+
+      m_id_column.clear();
+      m_id_column = DBColumn(m_id_type == godot::Variant::STRING ? DBColumn::ST_String : DBColumn::ST_Integer, &m_string_pool);
    }
    else if (prop_name == godot::StringName("locked_row_id"))
    {
       m_locked_id = value;
    }
+   else if (prop_name == godot::StringName("dense_row_id"))
+   {
+      // Row list comes later, so the row indexing will be built in the correct mode
+      m_dense_id = (bool)value && m_id_type == godot::Variant::INT;
+   }
    else if (prop_name == godot::StringName("column"))
    {
       m_column_array = value;
@@ -901,9 +1424,11 @@ bool DBTable::_set(const godot::StringName& prop_name, const godot::Variant& val
    }
    else if (prop_name == godot::StringName("row_list"))
    {
-      m_row_list = value;
+      set_row_list(value);
       build_unique_index();
+      validate_loaded_dense_id();
       build_row_index();
+      build_secondary_index();
       calculate_weights();
    }
    else
@@ -935,6 +1460,10 @@ bool DBTable::_get(const godot::StringName& prop_name, godot::Variant& out_value
    {
       out_value = m_locked_id;
    }
+   else if (prop_name == godot::StringName("dense_row_id"))
+   {
+      out_value = m_dense_id;
+   }
    else if (prop_name == godot::StringName("column"))
    {
       out_value = m_column_array;
@@ -945,7 +1474,7 @@ bool DBTable::_get(const godot::StringName& prop_name, godot::Variant& out_value
    }
    else if (prop_name == godot::StringName("row_list"))
    {
-      out_value = m_row_list;
+      out_value = get_row_list();
    }
    else
    {
@@ -965,6 +1494,8 @@ void DBTable::_bind_methods()
    ClassDB::bind_method(D_METHOD("get_table_name"), &DBTable::get_table_name);
    ClassDB::bind_method(D_METHOD("get_id_type"), &DBTable::get_id_type);
    ClassDB::bind_method(D_METHOD("is_row_id_locked"), &DBTable::is_row_id_locked);
+   ClassDB::bind_method(D_METHOD("set_dense_id", "enabled"), &DBTable::set_dense_id);
+   ClassDB::bind_method(D_METHOD("is_dense_id"), &DBTable::is_dense_id);
    ClassDB::bind_method(D_METHOD("get_column_count"), &DBTable::get_column_count);
    ClassDB::bind_method(D_METHOD("get_column_by_index", "index"), &DBTable::get_column_by_index);
    ClassDB::bind_method(D_METHOD("get_column_by_title", "title"), &DBTable::get_column_by_title);
@@ -976,17 +1507,35 @@ void DBTable::_bind_methods()
    ClassDB::bind_method(D_METHOD("get_row", "row_id"), &DBTable::get_row);
    ClassDB::bind_method(D_METHOD("get_row_by_index", "row_index"), &DBTable::get_row_by_index);
    ClassDB::bind_method(D_METHOD("get_cell_value", "row_id", "column_title"), &DBTable::get_cell_value);
+   ClassDB::bind_method(D_METHOD("get_row_index", "row_id"), &DBTable::get_row_index);
+   ClassDB::bind_method(D_METHOD("get_column_handle", "title"), &DBTable::get_column_handle);
+   ClassDB::bind_method(D_METHOD("get_value", "row_index", "column_handle"), &DBTable::get_value);
+   ClassDB::bind_method(D_METHOD("get_int", "row_index", "column_handle"), &DBTable::get_int);
+   ClassDB::bind_method(D_METHOD("get_float", "row_index", "column_handle"), &DBTable::get_float);
+   ClassDB::bind_method(D_METHOD("get_bool", "row_index", "column_handle"), &DBTable::get_bool);
+   ClassDB::bind_method(D_METHOD("get_string", "row_index", "column_handle"), &DBTable::get_string);
+   ClassDB::bind_method(D_METHOD("set_column_index", "column_title", "type"), &DBTable::set_column_index);
+   ClassDB::bind_method(D_METHOD("get_column_index_type", "column_title"), &DBTable::get_column_index_type);
+   ClassDB::bind_method(D_METHOD("find_rows", "column_title", "value"), &DBTable::find_rows);
+   ClassDB::bind_method(D_METHOD("find_rows_in_range", "column_title", "low", "high"), &DBTable::find_rows_in_range);
+   ClassDB::bind_method(D_METHOD("get_row_view", "row_id"), &DBTable::get_row_view);
+   ClassDB::bind_method(D_METHOD("get_row_view_by_index", "row_index"), &DBTable::get_row_view_by_index);
    ClassDB::bind_method(D_METHOD("pick_random_row", "random_number_generator"), &DBTable::pick_random_row, DEFVAL(nullptr));
+   ClassDB::bind_method(D_METHOD("pick_random_rows", "count", "with_replacement", "random_number_generator"), &DBTable::pick_random_rows, DEFVAL(true), DEFVAL(nullptr));
    ClassDB::bind_method(D_METHOD("get_random_weight_column_title"), &DBTable::get_random_weight_column_title);
    ClassDB::bind_method(D_METHOD("get_row_accumulated_weight", "row_index"), &DBTable::get_row_accumulated_weight);
    ClassDB::bind_method(D_METHOD("get_row_probability", "row_index"), &DBTable::get_row_probability);
    ClassDB::bind_method(D_METHOD("get_total_weight_sum"), &DBTable::get_total_weight_sum);
+   ClassDB::bind_method(D_METHOD("set_row_weight", "row_index", "weight"), &DBTable::set_row_weight);
+   ClassDB::bind_method(D_METHOD("set_random_pick_mode", "mode"), &DBTable::set_random_pick_mode);
+   ClassDB::bind_method(D_METHOD("get_random_pick_mode"), &DBTable::get_random_pick_mode);
    ClassDB::bind_method(D_METHOD("get_reference_list"), &DBTable::get_reference_list);
    ClassDB::bind_method(D_METHOD("get_referenced_by_list"), &DBTable::get_referenced_by_list);
    ClassDB::bind_method(D_METHOD("is_referencing", "other_table_name"), &DBTable::is_referencing);
    ClassDB::bind_method(D_METHOD("is_referenced_by", "other_table_name"), &DBTable::is_referenced_by);
    //ClassDB::bind_method(D_METHOD("merge_from_table", "other_table", "allow_overwrite"), &DBTable::merge_from_table);
    ClassDB::bind_method(D_METHOD("get_data_as_json", "indent"), &DBTable::get_data_as_json, DEFVAL(""));
+   ClassDB::bind_method(D_METHOD("get_data_memory_usage"), &DBTable::get_data_memory_usage);
 
 
    BIND_ENUM_CONSTANT(VT_UniqueString);
@@ -1016,6 +1565,13 @@ void DBTable::_bind_methods()
    BIND_ENUM_CONSTANT(VT_AudioArray);
    BIND_ENUM_CONSTANT(VT_GenericResArray);
    BIND_ENUM_CONSTANT(VT_ColorArray);
+
+   BIND_ENUM_CONSTANT(IT_None);
+   BIND_ENUM_CONSTANT(IT_Hash);
+   BIND_ENUM_CONSTANT(IT_Sorted);
+
+   BIND_ENUM_CONSTANT(RPM_Alias);
+   BIND_ENUM_CONSTANT(RPM_BinarySearch);
 }
 
 
@@ -1037,137 +1593,386 @@ godot::Dictionary DBTable::get_column_by_index(int64_t index) const
    ret["value_type"] = column_get_type(column);
    ret["extid"] = column_get_external(column);
 
-   return ret;
+   return ret;
+}
+
+
+godot::Dictionary DBTable::get_column_by_title(const godot::String& title) const
+{
+   godot::Dictionary ret = godot::Dictionary();
+
+   ColumnIndexType::ConstIterator iter = m_column_index.find(title);
+   if (iter != m_column_index.end())
+   {
+      const godot::Dictionary column = iter->value;
+
+      ret["title"] = column_get_title(column);
+      ret["value_type"] = column_get_type(column);
+      ret["extid"] = column_get_external(column);
+   }
+
+   return ret;
+}
+
+
+godot::String DBTable::get_column_title(int64_t index) const
+{
+   if (index < 0 || index >= m_column_array.size())
+   {
+      return "";
+   }
+
+   const godot::Dictionary column = m_column_array[index];
+
+   return column_get_title(column);
+}
+
+
+DBTable::ValueType DBTable::get_column_value_type(const godot::String& column_title) const
+{
+   ColumnIndexType::ConstIterator iter = m_column_index.find(column_title);
+   if (iter == m_column_index.end())
+   {
+      return VT_Invalid;
+   }
+
+   return column_get_type(iter->value);
+}
+
+
+godot::Dictionary DBTable::get_row(const godot::Variant& id) const
+{
+   godot::Dictionary ret;
+
+   // Because this function is exposed, this verification can't be removed from release builds
+   ERR_FAIL_COND_V_MSG(id.get_type() != m_id_type, ret, godot::vformat("Attempting to retrieve row from table '%s', however ID types don't match.", m_table_name));
+
+   // Rows are not stored as Dictionaries anymore, so a new one is built, which also means external modifications
+   // don't affect the stored data
+   const int64_t index = find_row(id);
+   if (index >= 0)
+   {
+      ret = make_row(index);
+   }
+
+   return ret;
+}
+
+
+godot::Dictionary DBTable::get_row_by_index(int64_t index) const
+{
+   godot::Dictionary ret;
+
+   if (index < 0 || index >= get_row_count())
+   {
+      return ret;
+   }
+
+   ret = make_row(index);
+
+   return ret;
+}
+
+
+godot::Variant DBTable::get_cell_value(const godot::Variant& id, const godot::String& column_title) const
+{
+   godot::Variant ret;
+
+   ERR_FAIL_COND_V_MSG(id.get_type() != m_id_type, ret, godot::vformat("Attempting to retrieve cell from table '%s', column '%s', however provided ID type don't match the one of the table.", m_table_name, column_title));
+
+   const int64_t index = find_row(id);
+   const DBColumn* cdata = get_column_data(column_title);
+   if (index >= 0 && cdata)
+   {
+      ret = cdata->get(index);
+   }
+
+   return ret;
+}
+
+
+int64_t DBTable::get_row_index(const godot::Variant& id) const
+{
+   return find_row(id);
+}
+
+
+int64_t DBTable::get_column_handle(const godot::String& title) const
+{
+   godot::HashMap<godot::String, int64_t>::ConstIterator iter = m_column_slot.find(title);
+   if (iter == m_column_slot.end())
+   {
+      return -1;
+   }
+
+   return ((m_column_layout_version & 0x7FFFFFFF) << 32) | iter->value;
+}
+
+
+godot::Variant DBTable::get_value(int64_t row_index, int64_t column_handle) const
+{
+   const int64_t slot = get_column_slot(column_handle);
+   ERR_FAIL_COND_V(slot < 0, godot::Variant());
+   ERR_FAIL_INDEX_V(row_index, get_row_count(), godot::Variant());
+
+   return m_column_data[slot].get(row_index);
+}
+
+
+int64_t DBTable::get_int(int64_t row_index, int64_t column_handle) const
+{
+   const int64_t slot = get_column_slot(column_handle);
+   ERR_FAIL_COND_V(slot < 0, 0);
+   ERR_FAIL_INDEX_V(row_index, get_row_count(), 0);
+
+   return m_column_data[slot].get_as_int(row_index);
+}
+
+
+double DBTable::get_float(int64_t row_index, int64_t column_handle) const
+{
+   const int64_t slot = get_column_slot(column_handle);
+   ERR_FAIL_COND_V(slot < 0, 0.0);
+   ERR_FAIL_INDEX_V(row_index, get_row_count(), 0.0);
+
+   return m_column_data[slot].get_as_float(row_index);
 }
 
 
-godot::Dictionary DBTable::get_column_by_title(const godot::String& title) const
+bool DBTable::get_bool(int64_t row_index, int64_t column_handle) const
 {
-   godot::Dictionary ret = godot::Dictionary();
+   const int64_t slot = get_column_slot(column_handle);
+   ERR_FAIL_COND_V(slot < 0, false);
+   ERR_FAIL_INDEX_V(row_index, get_row_count(), false);
 
-   ColumnIndexType::ConstIterator iter = m_column_index.find(title);
-   if (iter != m_column_index.end())
-   {
-      const godot::Dictionary column = iter->value;
+   return m_column_data[slot].get_as_bool(row_index);
+}
 
-      ret["title"] = column_get_title(column);
-      ret["value_type"] = column_get_type(column);
-      ret["extid"] = column_get_external(column);
-   }
 
-   return ret;
+godot::String DBTable::get_string(int64_t row_index, int64_t column_handle) const
+{
+   const int64_t slot = get_column_slot(column_handle);
+   ERR_FAIL_COND_V(slot < 0, godot::String());
+   ERR_FAIL_INDEX_V(row_index, get_row_count(), godot::String());
+
+   return m_column_data[slot].get_as_string(row_index);
 }
 
 
-godot::String DBTable::get_column_title(int64_t index) const
+bool DBTable::set_column_index(const godot::String& column_title, IndexType type)
 {
-   if (index < 0 || index >= m_column_array.size())
+   ColumnIndexType::Iterator col_iter = m_column_index.find(column_title);
+   ERR_FAIL_COND_V_MSG(col_iter == m_column_index.end(), false, godot::vformat("Attempting to set the index of column '%s', which does not exist in table '%s'.", column_title, m_table_name));
+
+   // The Dictionary in the column index shares data with the one in the column array, which is the stored one
+   column_set_index_type(type, col_iter->value);
+
+   const IndexType built = column_get_built_index_type(col_iter->value);
+   if (built == IT_None)
    {
-      return "";
+      m_secondary_index.erase(column_title);
+   }
+   else
+   {
+      m_secondary_index.insert(column_title, DBColumnIndex(built == IT_Sorted));
+      rebuild_secondary_index(column_title);
    }
 
-   const godot::Dictionary column = m_column_array[index];
-
-   return column_get_title(column);
+   return true;
 }
 
 
-DBTable::ValueType DBTable::get_column_value_type(const godot::String& column_title) const
+DBTable::IndexType DBTable::get_column_index_type(const godot::String& column_title) const
 {
-   ColumnIndexType::ConstIterator iter = m_column_index.find(column_title);
-   if (iter == m_column_index.end())
+   ColumnIndexType::ConstIterator col_iter = m_column_index.find(column_title);
+   if (col_iter == m_column_index.end())
    {
-      return VT_Invalid;
+      return IT_None;
    }
 
-   return column_get_type(iter->value);
+   return column_get_index_type(col_iter->value);
 }
 
 
-godot::Dictionary DBTable::get_row(const godot::Variant& id) const
+godot::PackedInt64Array DBTable::find_rows(const godot::String& column_title, const godot::Variant& value) const
 {
-   godot::Dictionary ret;
+   godot::PackedInt64Array ret;
 
-   // Because this function is exposed, this verification can't be removed from release builds
-   ERR_FAIL_COND_V_MSG(id.get_type() != m_id_type, ret, godot::vformat("Attempting to retrieve row from table '%s', however ID types don't match.", m_table_name));
+   const DBColumn* cdata = get_column_data(column_title);
+   ERR_FAIL_NULL_V_MSG(cdata, ret, godot::vformat("Attempting to find rows by column '%s', which does not exist in table '%s'.", column_title, m_table_name));
 
-   // While it would be possible to directly return the stored row, Dictionaries are always passed as references.
-   // To prevent possible errors due to external modifications, copy the row values into the 'ret' Dictionary
-   RowIndexType::ConstIterator iter = m_row_index.find(id);
-   if (iter != m_row_index.end())
+   const godot::Variant converted = cdata->convert(value);
+
+   godot::HashMap<godot::String, DBColumnIndex>::ConstIterator iter = m_secondary_index.find(column_title);
+   if (iter != m_secondary_index.end())
+   {
+      return iter->value.find(*cdata, converted);
+   }
+
+   const int64_t rcount = get_row_count();
+   for (int64_t i = 0; i < rcount; i++)
    {
-      const godot::Dictionary row = iter->value;
-      ret = row.duplicate();
+      if (cdata->is_equal(i, converted))
+      {
+         ret.append(i);
+      }
    }
 
    return ret;
 }
 
 
-godot::Dictionary DBTable::get_row_by_index(int64_t index) const
+godot::PackedInt64Array DBTable::find_rows_in_range(const godot::String& column_title, const godot::Variant& low, const godot::Variant& high) const
 {
-   godot::Dictionary ret;
+   godot::PackedInt64Array ret;
 
-   if (index < 0 || index >= m_row_list.size())
+   const DBColumn* cdata = get_column_data(column_title);
+   ERR_FAIL_NULL_V_MSG(cdata, ret, godot::vformat("Attempting to find rows by column '%s', which does not exist in table '%s'.", column_title, m_table_name));
+
+   const godot::Variant clow = cdata->convert(low);
+   const godot::Variant chigh = cdata->convert(high);
+
+   godot::HashMap<godot::String, DBColumnIndex>::ConstIterator iter = m_secondary_index.find(column_title);
+   if (iter != m_secondary_index.end() && iter->value.is_ordered())
    {
-      return ret;
+      return iter->value.find_in_range(*cdata, clow, chigh);
    }
 
-   // While it would be possible to directly return the stored row, Dictionaries are always passed as references.
-   // To prevent possible errors due to external modifications, copy the row values into the 'ret' Dictionary
-   const godot::Dictionary row = m_row_list[index];
-   ret = row.duplicate();
+   const int64_t rcount = get_row_count();
+   for (int64_t i = 0; i < rcount; i++)
+   {
+      if (!cdata->is_less_than(i, clow) && !cdata->is_greater_than(i, chigh))
+      {
+         ret.append(i);
+      }
+   }
 
    return ret;
 }
 
 
-godot::Variant DBTable::get_cell_value(const godot::Variant& id, const godot::String& column_title) const
+godot::Ref<DBRowView> DBTable::get_row_view(const godot::Variant& id)
 {
-   godot::Variant ret;
-
-   ERR_FAIL_COND_V_MSG(id.get_type() != m_id_type, ret, godot::vformat("Attempting to retrieve cell from table '%s', column '%s', however provided ID type don't match the one of the table.", m_table_name, column_title));
-
-   // While it would be possible to directly return the stored row, Dictionaries are always passed as references.
-   // To prevent possible errors due to external modifications, copy the row values into the 'ret' Dictionary
-   RowIndexType::ConstIterator iter = m_row_index.find(id);
-   if (iter != m_row_index.end())
+   const int64_t index = get_row_index(id);
+   if (index < 0)
    {
-      const godot::Dictionary row = iter->value;
-      ret = row.get(column_title, nullptr);
+      return godot::Ref<DBRowView>();
    }
 
+   return get_row_view_by_index(index);
+}
+
+
+godot::Ref<DBRowView> DBTable::get_row_view_by_index(int64_t index)
+{
+   ERR_FAIL_INDEX_V(index, get_row_count(), godot::Ref<DBRowView>());
+
+   godot::Ref<DBRowView> ret;
+   ret.instantiate();
+   ret->setup(godot::Ref<DBTable>(this), index);
+
    return ret;
 }
 
 
 godot::Dictionary DBTable::pick_random_row(const godot::Ref<godot::RandomNumberGenerator>& rng) const
 {
-   godot::Dictionary ret;
-   godot::Ref<godot::RandomNumberGenerator> randgen = rng.is_valid() ? rng : m_rand_gen;
+   // If the random weight system is not set roll_row_index() picks a random index instead
+   const int64_t index = roll_row_index(rng);
+   if (index < 0)
+   {
+      return godot::Dictionary();
+   }
 
-   if (m_rand_weight.column.is_empty())
+   return make_row(index);
+}
+
+
+// Used when sampling without replacement. Each candidate row gets a random key and the ones with smallest keys are picked
+struct SampleKey
+{
+   double key;
+   int64_t index;
+};
+
+struct SampleKeyComparator
+{
+   bool operator()(const SampleKey& a, const SampleKey& b) const { return a.key < b.key; }
+};
+
+
+godot::PackedInt64Array DBTable::pick_random_rows(int64_t count, bool with_replacement, const godot::Ref<godot::RandomNumberGenerator>& rng) const
+{
+   godot::PackedInt64Array ret;
+   ERR_FAIL_COND_V_MSG(count < 0, ret, "The number of rows to pick must not be negative.");
+
+   const godot::Ref<godot::RandomNumberGenerator>& randgen = rng.is_valid() ? rng : m_rand_gen;
+   const int64_t rcount = get_row_count();
+
+   if (count == 0 || rcount == 0)
    {
-      // No random weight system set. Pick a random index instead
-      const int64_t index = randgen->randi_range(0, m_row_list.size());
-      const godot::Dictionary row = m_row_list[index];
-      ret = row.duplicate();
+      return ret;
    }
-   else
+
+   if (with_replacement)
    {
-      const double roll = randgen->randf_range(0.0, m_rand_weight.total_weight);
+      ret.resize(count);
+      int64_t* out = ret.ptrw();
 
-      const int64_t rcount = get_row_count();
-      for (int64_t i = 0; i < rcount; i++)
+      for (int64_t i = 0; i < count; i++)
       {
-         const double acc = m_rand_weight.acc_weight[i];
-         if (acc > roll)
+         const int64_t index = roll_row_index(randgen);
+         if (index < 0)
          {
-            const godot::Dictionary row = m_row_list[i];
-            ret = row.duplicate();
+            // Nothing can be picked (total weight is 0)
+            ret.clear();
             break;
          }
+
+         out[i] = index;
+      }
+
+      return ret;
+   }
+
+   // Without replacement use exponential keys (Efraimidis-Spirakis): each row gets key = E / weight, where E is an
+   // exponentially distributed random value. Taking the rows with the smallest keys gives the same result as picking one
+   // row at a time, proportionally to the weights, and removing it from the candidates. Rows without weight are skipped
+   const DBColumn* wcolumn = m_rand_weight.column.is_empty() ? nullptr : get_column_data(m_rand_weight.column);
+   const double* weight = wcolumn ? wcolumn->get_float_data() : nullptr;
+
+   godot::Vector<SampleKey> candidate;
+   candidate.resize(rcount);
+   SampleKey* key = candidate.ptrw();
+   int64_t ccount = 0;
+
+   for (int64_t i = 0; i < rcount; i++)
+   {
+      const double w = weight ? weight[i] : 1.0;
+      if (w <= 0.0)
+      {
+         continue;
       }
+
+      key[ccount].key = -godot::Math::log(randgen->randf()) / w;
+      key[ccount].index = i;
+      ccount++;
+   }
+
+   const int64_t pcount = MIN(count, ccount);
+   if (pcount == 0)
+   {
+      return ret;
+   }
+
+   godot::SortArray<SampleKey, SampleKeyComparator> sorter;
+   sorter.partial_sort(0, ccount, pcount, key);
+
+   ret.resize(pcount);
+   int64_t* out = ret.ptrw();
+   for (int64_t i = 0; i < pcount; i++)
+   {
+      out[i] = key[i].index;
    }
 
    return ret;
@@ -1176,24 +1981,24 @@ godot::Dictionary DBTable::pick_random_row(const godot::Ref<godot::RandomNumberG
 
 double DBTable::get_row_accumulated_weight(int64_t row_index) const
 {
-   if (row_index < 0 || row_index >= m_row_list.size() || m_rand_weight.acc_weight.size() == 0)
+   if (row_index < 0 || row_index >= get_row_count() || m_rand_weight.tree.size() != get_row_count())
    {
       return -1.0;
    }
 
-   return m_rand_weight.acc_weight[row_index];
+   return m_rand_weight.tree.get_accumulated(row_index);
 }
 
 
 double DBTable::get_row_probability(int64_t row_index) const
 {
-   if (row_index < 0 || row_index >= m_row_list.size() || m_rand_weight.acc_weight.size() == 0)
+   if (row_index < 0 || row_index >= get_row_count() || m_rand_weight.tree.size() == 0)
    {
       return -1.0;
    }
 
-   const godot::Dictionary row = m_row_list[row_index];
-   const double w = row.get(m_rand_weight.column, -1.0);
+   const DBColumn* wcolumn = get_column_data(m_rand_weight.column);
+   const double w = wcolumn ? (double)wcolumn->get(row_index) : -1.0;
 
    if (w >= 0.0)
    {
@@ -1324,7 +2129,136 @@ godot::String DBTable::get_data_as_json(const godot::String& indent) const
    godot::Ref<godot::JSON> json;
    json.instantiate();
 
-   return json->stringify(m_row_list, indent, false);
+   return json->stringify(get_row_list(), indent, false);
+}
+
+
+int64_t DBTable::get_data_memory_usage() const
+{
+   int64_t ret = m_id_column.get_memory_usage() + m_string_pool.get_memory_usage() + m_rand_weight.tree.get_memory_usage();
+   ret += m_dense_row.size() * sizeof(int64_t);
+   ret += m_free_id.size() * sizeof(int64_t);
+
+   const int64_t ccount = m_column_data.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      ret += m_column_data[i].get_memory_usage();
+   }
+
+   return ret;
+}
+
+
+void DBTable::write_binary(DBBinaryWriter& writer) const
+{
+   writer.write_string(m_table_id);
+   writer.write_string(m_table_name);
+   writer.write_u32(m_id_type);
+   // Flags. Bit 0 = locked IDs, bit 1 = dense IDs
+   writer.write_u32((m_locked_id ? 1 : 0) | (m_dense_id ? 2 : 0));
+   writer.write_variant(m_column_array);
+   writer.write_variant(m_ref_table);
+   writer.align();
+
+   // Column blocks. The string pool comes first because the string columns hold handles into it
+   const int64_t ccount = m_column_data.size();
+   writer.write_u64(get_row_count());
+   writer.write_u64(ccount);
+   m_string_pool.write(writer);
+   m_id_column.write(writer);
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      m_column_data[i].write(writer);
+   }
+
+   // Index blocks. The row index and the unique value sets are hashed by value, so those are rebuilt when reading
+   m_rand_weight.tree.write(writer);
+
+   writer.write_u64(m_secondary_index.size());
+   for (godot::HashMap<godot::String, DBColumnIndex>::ConstIterator iter = m_secondary_index.begin(); iter != m_secondary_index.end(); ++iter)
+   {
+      writer.write_string(iter->key);
+      writer.align();
+      iter->value.write(writer);
+   }
+}
+
+
+bool DBTable::read_binary(DBBinaryReader& reader)
+{
+   m_table_id = reader.read_string();
+   m_table_name = reader.read_string();
+   m_id_type = reader.read_u32();
+   const uint32_t flags = reader.read_u32();
+   m_locked_id = (flags & 1) != 0;
+   const godot::Array column_array = reader.read_variant();
+   m_ref_table = reader.read_variant();
+   reader.align();
+
+   ERR_FAIL_COND_V_MSG(reader.has_error(), false, "Reading table, however the data is truncated.");
+   ERR_FAIL_COND_V_MSG(m_id_type != godot::Variant::INT && m_id_type != godot::Variant::STRING, false, "Reading table, however its ID type is not valid.");
+   m_dense_id = (flags & 2) != 0 && m_id_type == godot::Variant::INT;
+
+   // This creates the (empty) column storage and setup the random weight column, if there is one
+   m_column_array = column_array;
+   build_column_index();
+
+   const int64_t rcount = reader.read_u64();
+   const uint64_t ccount = reader.read_u64();
+   ERR_FAIL_COND_V_MSG(reader.has_error() || ccount != uint64_t(m_column_data.size()), false, godot::vformat("Reading table '%s', however the stored columns don't match its column list.", m_table_name));
+   ERR_FAIL_COND_V_MSG(!m_string_pool.read(reader), false, godot::vformat("Reading table '%s', however failed to read its strings.", m_table_name));
+
+   m_id_column = DBColumn(m_id_type == godot::Variant::STRING ? DBColumn::ST_String : DBColumn::ST_Integer, &m_string_pool);
+   ERR_FAIL_COND_V_MSG(!m_id_column.read(reader) || m_id_column.size() != rcount, false, godot::vformat("Reading table '%s', however failed to read row IDs.", m_table_name));
+
+   for (int64_t i = 0; i < int64_t(ccount); i++)
+   {
+      DBColumn& cdata = m_column_data.ptrw()[i];
+      ERR_FAIL_COND_V_MSG(!cdata.read(reader) || cdata.size() != rcount, false, godot::vformat("Reading table '%s', however failed to read values of column '%s'.", m_table_name, get_column_title(i)));
+   }
+
+   build_unique_index();
+   validate_loaded_dense_id();
+   build_row_index();
+
+   // Weights are taken as they are if they match the rows, otherwise just rebuild from the column
+   ERR_FAIL_COND_V_MSG(!m_rand_weight.tree.read(reader), false, godot::vformat("Reading table '%s', however failed to read random weights.", m_table_name));
+   if (m_rand_weight.column.is_empty())
+   {
+      m_rand_weight.tree.clear();
+   }
+   else if (m_rand_weight.tree.size() == rcount)
+   {
+      m_rand_weight.total_weight = m_rand_weight.tree.get_total();
+      m_rand_weight.alias_dirty = true;
+   }
+   else
+   {
+      calculate_weights();
+   }
+
+   // Secondary indexes have been created (empty) when building the column index. Fill those from the stored data
+   const uint64_t icount = reader.read_u64();
+   ERR_FAIL_COND_V_MSG(reader.has_error() || icount > uint64_t(m_secondary_index.size()), false, godot::vformat("Reading table '%s', however the stored indexes don't match the column list.", m_table_name));
+
+   for (uint64_t i = 0; i < icount; i++)
+   {
+      const godot::String title = reader.read_string();
+      reader.align();
+
+      godot::HashMap<godot::String, DBColumnIndex>::Iterator iter = m_secondary_index.find(title);
+      const DBColumn* cdata = get_column_data(title);
+      ERR_FAIL_COND_V_MSG(iter == m_secondary_index.end() || !cdata, false, godot::vformat("Reading table '%s', however found an index for an unknown column.", m_table_name));
+      ERR_FAIL_COND_V_MSG(!iter->value.read(reader, *cdata), false, godot::vformat("Reading table '%s', however failed to read the index of column '%s'.", m_table_name, title));
+   }
+
+   if (icount != uint64_t(m_secondary_index.size()))
+   {
+      // Some declared index was not stored
+      build_secondary_index();
+   }
+
+   return !reader.has_error();
 }
 
 
@@ -1381,28 +2315,39 @@ int64_t DBTable::add_column(const godot::String& title, const ColumnInfo& settin
    column_set_type(settings.type, column);
    column_set_external(ext, column);
 
+   DBColumn cdata(get_storage_type(settings.type), &m_string_pool);
+
+   const int64_t rcount = get_row_count();
+   for (int64_t i = 0; i < rcount; i++)
+   {
+      const godot::Variant defval = get_default_value(column);
+      cdata.insert(i, defval);
+
+      if (require_unique_values(column))
+      {
+         set_used(column, defval);
+      }
+   }
+
    if (index < m_column_array.size())
    {
       m_column_array.insert(index, column);
+      m_column_data.insert(index, cdata);
    }
    else
    {
       m_column_array.append(column);
+      m_column_data.push_back(cdata);
    }
 
    m_column_index[title] = column;
+   build_column_slots();
 
-   const int64_t rcount = get_row_count();
-   for (int64_t i = 0; i < rcount; i++)
+   if (!ext.is_empty())
    {
-      const godot::Variant defval = get_default_value(column);
-      godot::Dictionary row = m_row_list[i];
-      row[title] = defval;
-
-      if (require_unique_values(column))
-      {
-         set_used(column, defval);
-      }
+      // The reverse reference index
+      m_secondary_index.insert(title, DBColumnIndex(false));
+      rebuild_secondary_index(title);
    }
 
    if (settings.type == VT_RandomWeight)
@@ -1427,11 +2372,17 @@ bool DBTable::remove_column(int64_t column_index)
    m_column_index.erase(title);
    m_column_array.remove_at(column_index);
 
+   m_column_data.ptrw()[column_index].clear();
+   m_column_data.remove_at(column_index);
+   build_column_slots();
+
    if (require_unique_values(column))
    {
       m_unique_indexing.erase(title);
    }
 
+   m_secondary_index.erase(title);
+
    const godot::String ext = column_get_external(column);
    if (!ext.is_empty())
    {
@@ -1471,14 +2422,8 @@ bool DBTable::rename_column(int64_t column_index, const godot::String& new_title
    // The column itself must be updated
    column_set_title(new_title, column);
 
-   // Must remove this column from each existing row
-   const int64_t rcount = get_row_count();
-   for (int64_t i = 0; i < rcount; i++)
-   {
-      godot::Dictionary row = m_row_list[i];
-      row[new_title] = row[old_name];
-      row.erase(old_name);
-   }
+   // Values are stored by column index, so only the mapping from title must be updated
+   build_column_slots();
 
    // Finally check if this column references another table. If that's the case must update the reference table list
    const godot::String ext = column_get_external(column);
@@ -1494,6 +2439,14 @@ bool DBTable::rename_column(int64_t column_index, const godot::String& new_title
       m_rand_weight.column = new_title;
    }
 
+   // Secondary indexes are keyed by title. The declaration itself is held by the column Dictionary
+   if (m_secondary_index.has(old_name))
+   {
+      const DBColumnIndex cindex = m_secondary_index[old_name];
+      m_secondary_index.erase(old_name);
+      m_secondary_index.insert(new_title, cindex);
+   }
+
    return true;
 }
 
@@ -1520,19 +2473,26 @@ bool DBTable::move_column(int64_t from, int64_t to)
    godot::Dictionary column = m_column_array[from];
    m_column_array.remove_at(from);
 
+   const DBColumn cdata = m_column_data[from];
+   m_column_data.remove_at(from);
+
    if (to == m_column_array.size())
    {
       // Because the "from" was temporarily removed from the array it is possible the "to" is now pointing
       // past the array boundaries. Just append the column back in
       m_column_array.append(column);
+      m_column_data.push_back(cdata);
    }
    else
    {
       m_column_array.insert(to, column);
+      m_column_data.insert(to, cdata);
    }
 
+   build_column_slots();
+
    // Because dictionaries are always passed by reference there is no need to update the column indexing since
-   // it's directly points into the column dictionaries
+   // it's directly points into the column dictionaries. The storage mapping was rebuilt above
    return true;
 }
 
@@ -1553,52 +2513,190 @@ bool DBTable::change_column_value_type(int64_t column_index, ValueType to_type)
    ERR_FAIL_COND_V_MSG(title.is_empty(), false, "Attempting to change column value type but stored name is invalid");
 #endif
 
-   if (type < 1000)
+   if (type < 1000)
+   {
+      // 1000 is the first "ID" of value types that can be changed. Don't change anything that is bellow it
+      return false;
+   }
+
+   column_set_type(to_type, column);
+   convert_value_type(title, to_type);
+
+   return true;
+}
+
+
+void DBTable::get_column_order(godot::PackedStringArray& out_array) const
+{
+   const int64_t ccount = m_column_array.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      godot::Dictionary column = m_column_array[i];
+
+      out_array.append(column_get_title(column));
+   }
+}
+
+
+int64_t DBTable::add_row(const godot::Dictionary& values, int64_t index)
+{
+   if (index < 0 || index >= get_row_count())
+   {
+      // Incoming desired index is out of bounds. Setup so new row will be appended
+      index = get_row_count();
+   }
+
+   godot::Variant nid;
+   if (m_id_type == godot::Variant::INT)
+   {
+      nid = generate_int_id();
+   }
+   else if (m_id_type == godot::Variant::STRING)
+   {
+      nid = generate_str_id();
+   }
+
+   if (nid.get_type() != godot::Variant::INT && nid.get_type() != godot::Variant::STRING) { return -1; }
+
+   add_row(nid, values, index);
+
+   return index;
+}
+
+
+int64_t DBTable::add_rows(const godot::Array& rows, int64_t index)
+{
+   const int64_t rcount = get_row_count();
+   if (index < 0 || index >= rcount)
+   {
+      index = rcount;
+   }
+
+   const int64_t count = rows.size();
+   if (count == 0)
+   {
+      return index;
+   }
+
+   ERR_FAIL_COND_V_MSG(m_id_type != godot::Variant::INT && m_id_type != godot::Variant::STRING, -1, "Attempting to insert rows, however the table ID type is invalid.");
+
+   // Generate all IDs first. Those must not collide with existing rows nor with each other
+   godot::Vector<godot::Variant> id_list;
+   id_list.resize(count);
+   ValueSetType batch_id;
+
+   for (int64_t r = 0; r < count; r++)
    {
-      // 1000 is the first "ID" of value types that can be changed. Don't change anything that is bellow it
-      return false;
-   }
+      godot::Variant nid = m_id_type == godot::Variant::INT ? godot::Variant(generate_int_id()) : godot::Variant(generate_str_id());
+      while (batch_id.has(nid))
+      {
+         nid = m_id_type == godot::Variant::INT ? godot::Variant(generate_int_id()) : godot::Variant(generate_str_id());
+      }
 
-   column_set_type(to_type, column);
-   convert_value_type(title, to_type);
+      batch_id.insert(nid);
+      id_list.set(r, nid);
+   }
 
-   return true;
-}
+   // Then gather the values column by column, so each column storage is shifted a single time
+   godot::Vector<godot::Variant> values;
+   values.resize(count);
 
+   godot::Vector<double> weight_list;
 
-void DBTable::get_column_order(godot::PackedStringArray& out_array) const
-{
    const int64_t ccount = m_column_array.size();
    for (int64_t i = 0; i < ccount; i++)
    {
-      godot::Dictionary column = m_column_array[i];
+      const godot::Dictionary column = m_column_array[i];
+      const godot::String title = column_get_title(column);
 
-      out_array.append(column_get_title(column));
-   }
-}
+   #ifdef DEBUG_ENABLED
+      ERR_FAIL_COND_V_MSG(title.is_empty(), -1, "While inserting new rows, retrieved a column without a title!");
+   #endif
 
+      DBColumn& cdata = m_column_data.ptrw()[i];
+      const bool unique = require_unique_values(column);
+      ValueSetType* uset = unique ? &m_unique_indexing[title] : nullptr;
 
-int64_t DBTable::add_row(const godot::Dictionary& values, int64_t index)
-{
-   if (index < 0 || index >= m_row_list.size())
-   {
-      // Incoming desired index is out of bounds. Setup so new row will be appended
-      index = m_row_list.size();
+      for (int64_t r = 0; r < count; r++)
+      {
+         const godot::Dictionary row = rows[r];
+         godot::Variant value = row.get(title, nullptr);
+
+         if (value.get_type() == godot::Variant::NIL)
+         {
+            value = get_default_value(column);
+         }
+         else if (unique)
+         {
+            // The unique set holds values as they are stored, so compare using the same conversion
+            value = cdata.convert(value);
+            if (uset->has(value))
+            {
+               value = get_default_value(column);
+            }
+         }
+
+         if (unique)
+         {
+            // Mark right away so later entries of this batch (and generated defaults) don't take the same value
+            uset->insert(value);
+         }
+
+         values.set(r, value);
+      }
+
+      cdata.insert_range(index, values);
+
+      if (title == m_rand_weight.column)
+      {
+         weight_list.resize(count);
+         for (int64_t r = 0; r < count; r++)
+         {
+            weight_list.set(r, values[r]);
+         }
+      }
    }
 
-   godot::Variant nid;
-   if (m_id_type == godot::Variant::INT)
+   m_id_column.insert_range(index, id_list);
+
+   if (index < rcount)
    {
-      nid = generate_int_id();
+      // Everything from the insertion point changed index
+      reindex_rows(index);
    }
-   else if (m_id_type == godot::Variant::STRING)
+   else
    {
-      nid = generate_str_id();
+      // Appended, so existing rows (and row views) are not affected
+      for (int64_t r = 0; r < count; r++)
+      {
+         set_row_entry(id_list[r], index + r);
+      }
    }
 
-   if (nid.get_type() != godot::Variant::INT && nid.get_type() != godot::Variant::STRING) { return -1; }
+   if (!m_rand_weight.column.is_empty())
+   {
+      if (index == rcount && weight_list.size() == count && m_rand_weight.tree.size() == rcount)
+      {
+         for (int64_t r = 0; r < count; r++)
+         {
+            m_rand_weight.tree.append(weight_list[r]);
+         }
 
-   add_row(nid, values, index);
+         m_rand_weight.total_weight = m_rand_weight.tree.get_total();
+         m_rand_weight.alias_dirty = true;
+      }
+      else
+      {
+         calculate_weights();
+      }
+   }
+
+   // Updating secondary indexes row by row would cost O(n) per inserted row on ordered indexes. A single rebuild is
+   // cheaper as soon as the batch is not tiny
+   if (m_secondary_index.size() > 0)
+   {
+      build_secondary_index();
+   }
 
    return index;
 }
@@ -1608,60 +2706,149 @@ void DBTable::remove_row(const godot::Variant row_id)
 {
    ERR_FAIL_COND_MSG(row_id.get_type() != get_id_type(), "Attempting to remove a row, but incoming ID type does not match that of the table.");
 
-   RowIndexType::Iterator iter = m_row_index.find(row_id);
-   if (iter == m_row_index.end())
+   const int64_t index = find_row(row_id);
+   if (index < 0)
    {
       // Perhaps an error message here?
       return;
    }
 
-   const godot::Dictionary row = iter->value;
-   m_row_list.erase(row);
-   m_row_index.erase(row_id);
-
-   godot::HashMap<godot::StringName, ValueSetType>::Iterator unique_iter;
-   for (unique_iter = m_unique_indexing.begin(); unique_iter != m_unique_indexing.end(); ++unique_iter)
-   {
-      // iter->key is the Title of the column that holds unique values.
-      // iter->value holds the Set that contains the list of values of the column
-      // Must remove from the Set the value that has been removed
-      const godot::Variant value = row.get(unique_iter->key, nullptr);
-      unique_iter->value.erase(value);
-   }
-
-   calculate_weights();
+   remove_row_by_index(index);
 }
 
 
 void DBTable::remove_row_by_index(int64_t index)
 {
-   if (index < 0 || index >= m_row_list.size())
+   if (index < 0 || index >= get_row_count())
    {
       return;
    }
 
-   godot::Dictionary row = m_row_list[index];
-   const godot::Variant id = row.get("id", nullptr);
+   const godot::Variant id = m_id_column.get(index);
 
 #ifdef DEBUG_ENABLED
    ERR_FAIL_COND_MSG(id.get_type() == godot::Variant::NIL, "Attempting to remove a row, but its ID is invalid");
    ERR_FAIL_COND_MSG(id.get_type() != m_id_type, "Attempting to remove a row, but its stored ID type doesn't match that of the table.");
 #endif
 
-   m_row_list.remove_at(index);
-   m_row_index.erase(id);
-
    godot::HashMap<godot::StringName, ValueSetType>::Iterator iter;
    for (iter = m_unique_indexing.begin(); iter != m_unique_indexing.end(); ++iter)
    {
       // iter->key is the Title of the column that holds unique values.
       // iter->value holds the Set that contains the list of values of the column
       // Must remove from the Set the value that has been removed
-      const godot::Variant value = row.get(iter->key, nullptr);
-      iter->value.erase(value);
+      const DBColumn* cdata = get_column_data(iter->key);
+      if (cdata)
+      {
+         iter->value.erase(cdata->get(index));
+      }
+   }
+
+   // Secondary indexes must locate the removed values, so update them before removing from the columns
+   secondary_index_row_removed(index);
+
+   m_id_column.remove(index);
+   const int64_t ccount = m_column_data.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      m_column_data.ptrw()[i].remove(index);
+   }
+
+   erase_row_entry(id);
+   reindex_rows(index);
+
+   calculate_weights();
+}
+
+
+int64_t DBTable::remove_rows_by_index(const godot::PackedInt64Array& index_list, ValueSetType* out_id_set)
+{
+   const int64_t rcount = get_row_count();
+   if (rcount == 0)
+   {
+      return 0;
+   }
+
+   // Flag the rows first, which takes care of repeated indices and doesn't require the list to be sorted
+   godot::Vector<uint8_t> removed;
+   removed.resize(rcount);
+   uint8_t* rflag = removed.ptrw();
+   memset(rflag, 0, rcount);
+
+   int64_t first = rcount;
+   int64_t rem_count = 0;
+
+   const int64_t icount = index_list.size();
+   for (int64_t i = 0; i < icount; i++)
+   {
+      const int64_t index = index_list[i];
+      if (index < 0 || index >= rcount || rflag[index])
+      {
+         continue;
+      }
+
+      rflag[index] = 1;
+      rem_count++;
+      first = MIN(first, index);
+   }
+
+   if (rem_count == 0)
+   {
+      return 0;
+   }
+
+   // Release IDs and unique values of the flagged rows
+   for (int64_t r = first; r < rcount; r++)
+   {
+      if (!rflag[r])
+      {
+         continue;
+      }
+
+      const godot::Variant id = m_id_column.get(r);
+      erase_row_entry(id);
+
+      if (out_id_set)
+      {
+         out_id_set->insert(id);
+      }
+   }
+
+   for (godot::HashMap<godot::StringName, ValueSetType>::Iterator iter = m_unique_indexing.begin(); iter != m_unique_indexing.end(); ++iter)
+   {
+      const DBColumn* cdata = get_column_data(iter->key);
+      if (!cdata)
+      {
+         continue;
+      }
+
+      for (int64_t r = first; r < rcount; r++)
+      {
+         if (rflag[r])
+         {
+            iter->value.erase(cdata->get(r));
+         }
+      }
+   }
+
+   m_id_column.remove_marked(rflag);
+   const int64_t ccount = m_column_data.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      m_column_data.ptrw()[i].remove_marked(rflag);
    }
 
+   // Only rows after the first removed one got their indices changed
+   reindex_rows(first);
+
    calculate_weights();
+
+   if (m_secondary_index.size() > 0)
+   {
+      build_secondary_index();
+   }
+
+   return rem_count;
 }
 
 
@@ -1671,19 +2858,26 @@ bool DBTable::move_row(int64_t from, int64_t to)
    {
       return false;
    }
-   if (from < 0 || from >= m_row_list.size())
+   if (from < 0 || from >= get_row_count())
    {
       return false;
    }
-   if (to < 0 || to >= m_row_list.size())
+   if (to < 0 || to >= get_row_count())
    {
       return false;
    }
 
-   const godot::Dictionary row = m_row_list[from];
-   m_row_list.remove_at(from);
-   m_row_list.insert(to, row);
+   m_id_column.move(from, to);
+   const int64_t ccount = m_column_data.size();
+   for (int64_t i = 0; i < ccount; i++)
+   {
+      m_column_data.ptrw()[i].move(from, to);
+   }
+
+   // Only rows between the two indices got shifted
+   reindex_rows(MIN(from, to));
 
+   build_secondary_index();
    calculate_weights();
 
    return true;
@@ -1692,26 +2886,12 @@ bool DBTable::move_row(int64_t from, int64_t to)
 
 godot::Variant DBTable::get_row_id(int64_t row_index) const
 {
-   if (row_index < 0 || row_index >= m_row_list.size())
+   if (row_index < 0 || row_index >= get_row_count())
    {
       return nullptr;
    }
 
-   godot::Variant ret;
-   const godot::Dictionary row = m_row_list[row_index];
-
-   if (m_id_type == godot::Variant::INT)
-   {
-      const int64_t id = row.get("id", -1);
-      ret = id;
-   }
-   else if (m_id_type == godot::Variant::STRING)
-   {
-      const godot::String id = row.get("id", "");
-      ret = id;
-   }
-
-   return ret;
+   return m_id_column.get(row_index);
 }
 
 
@@ -1721,14 +2901,13 @@ bool DBTable::set_row_id(int64_t row_index, const godot::Variant& new_id)
 
    ERR_FAIL_COND_V_MSG(new_id.get_type() != m_id_type, false, "While attempting to set the ID of a row, the type does not match that of the table.");
 
-   if (row_index < 0 || row_index >= m_row_list.size())
+   if (row_index < 0 || row_index >= get_row_count())
    {
       // Row index out of bounds. Bail
       return false;
    }
 
-   godot::Dictionary row = m_row_list[row_index];
-   const godot::Variant old_id = row.get("id", nullptr);
+   const godot::Variant old_id = m_id_column.get(row_index);
 
 #ifdef DEBUG_ENABLED
    ERR_FAIL_COND_V_MSG(old_id.get_type() != m_id_type, false, "While attempting to set the ID of row, old stored one doesn't match the type set for the table.");
@@ -1740,18 +2919,42 @@ bool DBTable::set_row_id(int64_t row_index, const godot::Variant& new_id)
       return false;
    }
 
-   if (m_row_index.has(new_id))
+   if (has_row_id(new_id))
    {
       // New ID already exists in the table. Bail
       return false;
    }
 
+   ERR_FAIL_COND_V_MSG(m_dense_id && !is_dense_id_valid(new_id), false, godot::vformat("Table '%s' uses dense IDs, which must be non negative and smaller than %d.", m_table_name, MAX_DENSE_ID));
+
    // Update the row
-   row["id"] = new_id;
+   m_id_column.set(row_index, new_id);
 
    // Update the row indexing
-   m_row_index[new_id] = row;
-   m_row_index.erase(old_id);
+   erase_row_entry(old_id);
+   set_row_entry(new_id, row_index);
+
+   return true;
+}
+
+
+bool DBTable::set_dense_id(bool enabled)
+{
+   if (enabled == m_dense_id)
+   {
+      return true;
+   }
+
+   if (enabled)
+   {
+      ERR_FAIL_COND_V_MSG(m_id_type != godot::Variant::INT, false, godot::vformat("Attempting to enable dense IDs on table '%s', which doesn't use integer IDs.", m_table_name));
+
+      const int64_t invalid = find_invalid_dense_id();
+      ERR_FAIL_COND_V_MSG(invalid >= 0, false, godot::vformat("Attempting to enable dense IDs on table '%s', however row ID %d is either negative or too big.", m_table_name, m_id_column.get(invalid)));
+   }
+
+   m_dense_id = enabled;
+   build_row_index();
 
    return true;
 }
@@ -1764,15 +2967,16 @@ bool DBTable::set_value(const godot::String& column_title, int64_t row_index, co
    {
       return false;
    }
-   if (row_index < 0 || row_index >= m_row_list.size())
+   if (row_index < 0 || row_index >= get_row_count())
    {
       // Row index out of bounds
       return false;
    }
 
    const godot::String title = column_get_title(col_iter->value);
-   godot::Dictionary row = m_row_list[row_index];
-   const godot::Variant old_value = row.get(title, nullptr);
+   DBColumn* cdata = get_column_data(title);
+   ERR_FAIL_NULL_V_MSG(cdata, false, "While attempting to set the value of a cell, the storage of the requested column was not found");
+   const godot::Variant old_value = cdata->get(row_index);
 
 #ifdef DEBUG_ENABLED
    ERR_FAIL_COND_V_MSG(title.is_empty(), false, "While attempting to set the value of a cell, the requested column does not have a title");
@@ -1797,36 +3001,60 @@ bool DBTable::set_value(const godot::String& column_title, int64_t row_index, co
 
 
    // If the type is meant to hold an integer, incoming variant storing value might be holding a Float instead, because of the
-   // cell editor. Make sure the stored value is indeed an integer rather than a float/double
-   const ValueType type = column_get_type(col_iter->value);
-   switch (type)
+   // cell editor. The column storage takes care of converting the value into the stored type
+   /// FIXME: Perform the same kind of conversion for the array types meant to hold integers
+   godot::HashMap<godot::String, DBColumnIndex>::Iterator sindex = m_secondary_index.find(title);
+   if (sindex != m_secondary_index.end())
    {
-      case VT_UniqueInteger:
-      case VT_LockedUniqueInteger:
-      case VT_ExternalInteger:
-      case VT_Integer:
-      {
-         const int64_t ival = value;
-         row[title] = ival;
-      } break;
+      sindex->value.erase_value(*cdata, row_index);
+   }
 
-      //case VT_ExtIntArray:
-      //case VT_IntegerArray:
-      //{
-         /// FIXME: Perform the same kind of conversion for the array types meant to hold integers
-      //} break;
+   cdata->set(row_index, value);
 
-      default:
-      {
-         row[title] = value;
-      } break;
+   if (sindex != m_secondary_index.end())
+   {
+      sindex->value.add_value(*cdata, row_index);
    }
 
    if (m_rand_weight.column == title)
    {
-      calculate_weights();
+      // Only this row changed, so there is no need to rebuild everything
+      update_row_weight(row_index, old_value, cdata->get(row_index));
+   }
+
+   return true;
+}
+
+
+bool DBTable::set_row_weight(int64_t row_index, double weight)
+{
+   ERR_FAIL_COND_V_MSG(m_rand_weight.column.is_empty(), false, "Attempting to set a row weight, but the table does not contain a random weight column.");
+   ERR_FAIL_INDEX_V(row_index, get_row_count(), false);
+
+   DBColumn* wcolumn = get_column_data(m_rand_weight.column);
+   ERR_FAIL_NULL_V_MSG(wcolumn, false, "While attempting to set a row weight, the storage of the weight column was not found");
+
+   const double old_weight = wcolumn->get(row_index);
+   if (old_weight == weight)
+   {
+      return true;
+   }
+
+   godot::HashMap<godot::String, DBColumnIndex>::Iterator sindex = m_secondary_index.find(m_rand_weight.column);
+   if (sindex != m_secondary_index.end())
+   {
+      sindex->value.erase_value(*wcolumn, row_index);
+   }
+
+   wcolumn->set(row_index, weight);
+
+   if (sindex != m_secondary_index.end())
+   {
+      sindex->value.add_value(*wcolumn, row_index);
    }
 
+   update_row_weight(row_index, old_weight, weight);
+
    return true;
 }
 
@@ -1844,17 +3072,71 @@ bool DBTable::set_value_by_index(int64_t column_index, int64_t row_index, const
 }
 
 
-void DBTable::sort_by_id(bool ascending)
+void DBTable::sort_rows(const godot::Vector<const DBColumn*>& key_column, const godot::Vector<bool>& ascending)
 {
-   Sorter sorter("id", get_instance_id());
-   if (ascending)
+   const int64_t rcount = get_row_count();
+   const int64_t kcount = key_column.size();
+   if (rcount < 2 || kcount == 0)
    {
-      m_row_list.sort_custom(callable_mp(&sorter, &Sorter::ascending));
+      return;
    }
-   else
+
+   // Extract the keys of every sort column first, so comparisons only deal with contiguous integer arrays
+   godot::Vector<int64_t> key_data;
+   key_data.resize(rcount * kcount);
+   godot::Vector<const int64_t*> key;
+   key.resize(kcount);
+
+   for (int64_t k = 0; k < kcount; k++)
+   {
+      int64_t* dest = key_data.ptrw() + (k * rcount);
+      key_column[k]->get_sort_keys(dest);
+      key.ptrw()[k] = dest;
+   }
+
+   // Sort a list of row indices rather than the rows themselves, then reorder all columns once
+   godot::Vector<int64_t> permutation;
+   permutation.resize(rcount);
+   int64_t* perm = permutation.ptrw();
+   for (int64_t i = 0; i < rcount; i++)
+   {
+      perm[i] = i;
+   }
+
+   godot::SortArray<int64_t, RowSorter> sorter;
+   sorter.compare.key = key.ptr();
+   sorter.compare.ascending = ascending.ptr();
+   sorter.compare.count = kcount;
+   sorter.sort(perm, rcount);
+
+   apply_row_permutation(perm);
+}
+
+
+void DBTable::apply_row_permutation(const int64_t* permutation)
+{
+   m_id_column.apply_permutation(permutation);
+
+   const int64_t ccount = m_column_data.size();
+   for (int64_t i = 0; i < ccount; i++)
    {
-      m_row_list.sort_custom(callable_mp(&sorter, &Sorter::descending));
+      m_column_data.ptrw()[i].apply_permutation(permutation);
    }
+
+   build_row_index();
+   build_secondary_index();
+   calculate_weights();
+}
+
+
+void DBTable::sort_by_id(bool ascending)
+{
+   godot::Vector<const DBColumn*> key_column;
+   godot::Vector<bool> key_ascending;
+   key_column.push_back(&m_id_column);
+   key_ascending.push_back(ascending);
+
+   sort_rows(key_column, key_ascending);
 }
 
 
@@ -1874,31 +3156,40 @@ bool DBTable::sort_by_column(int64_t index, bool ascending)
    ERR_FAIL_COND_V_MSG(type == VT_Invalid, false, "While attempting to sort rows by specific column, its stored value type is not valid");
 #endif
 
-   Sorter sorter(title, get_instance_id());
+   // Keys are extracted before any reordering, so the column storage can be directly given
+   godot::Vector<const DBColumn*> key_column;
+   godot::Vector<bool> key_ascending;
+   key_column.push_back(&m_column_data[index]);
+   key_ascending.push_back(ascending);
 
-   if (type == VT_Color)
-   {
-      if (ascending)
-      {
-         m_row_list.sort_custom(callable_mp(&sorter, &Sorter::ascending_color));
-      }
-      else
-      {
-         m_row_list.sort_custom(callable_mp(&sorter, &Sorter::descending_color));
-      }
-   }
-   else
+   sort_rows(key_column, key_ascending);
+
+   return true;
+}
+
+
+bool DBTable::sort_by_columns(const godot::PackedStringArray& column_titles, const godot::Array& ascending)
+{
+   const int64_t kcount = column_titles.size();
+   ERR_FAIL_COND_V_MSG(kcount == 0, false, godot::vformat("Attempting to sort rows of table '%s', however no column has been given.", m_table_name));
+
+   godot::Vector<const DBColumn*> key_column;
+   godot::Vector<bool> key_ascending;
+   key_column.resize(kcount);
+   key_ascending.resize(kcount);
+
+   for (int64_t i = 0; i < kcount; i++)
    {
-      if (ascending)
-      {
-         m_row_list.sort_custom(callable_mp(&sorter, &Sorter::ascending));
-      }
-      else
-      {
-         m_row_list.sort_custom(callable_mp(&sorter, &Sorter::descending));
-      }
+      const godot::String title = column_titles[i];
+      const DBColumn* cdata = title == "id" ? &m_id_column : get_column_data(title);
+      ERR_FAIL_NULL_V_MSG(cdata, false, godot::vformat("Attempting to sort rows by column '%s', which does not exist in table '%s'.", title, m_table_name));
+
+      key_column.ptrw()[i] = cdata;
+      key_ascending.ptrw()[i] = i < ascending.size() ? (bool)ascending[i] : true;
    }
-   
+
+   sort_rows(key_column, key_ascending);
+
    return true;
 }
 
@@ -1954,6 +3245,15 @@ DBTable::DBTable(int id_type, const godot::StringName& name, bool locked_id)
    m_rand_gen.instantiate();
    m_rand_gen->randomize();
 
+   m_rand_weight.alias_dirty = true;
+   m_rand_weight.pick_mode = RPM_Alias;
+
+   m_row_layout_version = 0;
+   m_column_layout_version = 0;
+
+   m_dense_id = false;
+   m_next_id = 0;
+
    m_table_id = make_random_string(12);
 
    if (id_type != godot::Variant::INT && id_type != godot::Variant::STRING)
@@ -1963,6 +3263,8 @@ DBTable::DBTable(int id_type, const godot::StringName& name, bool locked_id)
    m_id_type = id_type;
    m_table_name = name;
    m_locked_id = locked_id;
+
+   m_id_column = DBColumn(m_id_type == godot::Variant::STRING ? DBColumn::ST_String : DBColumn::ST_Integer, &m_string_pool);
 }
 
 
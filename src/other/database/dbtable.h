@@ -35,16 +35,22 @@
 #include <godot_cpp/templates/hash_set.hpp>
 #include <godot_cpp/variant/variant.hpp>
 
+#include "dbcolumn.h"
+
 //class DBTablePatch;
+class DBRowView;
+class DBBinaryWriter;
+class DBBinaryReader;
 
 class DBTable : public godot::Resource
 {
    friend class GDDatabase;
+   friend class DBQuery;
    GDCLASS(DBTable, godot::Resource);
    //typedef godot::HashMap<godot::Variant, godot::Dictionary, godot::VariantHasher, godot::VariantComparator> ColumnIndexType;
    //typedef godot::HashMap<godot::String, godot::Dictionary, godot::VariantHasher, godot::VariantComparator> ColumnIndexType;
    typedef godot::HashMap<godot::String, godot::Dictionary> ColumnIndexType;
-   typedef godot::HashMap<godot::Variant, godot::Dictionary, godot::VariantHasher, godot::VariantComparator> RowIndexType;
+   typedef godot::HashMap<godot::Variant, int64_t, godot::VariantHasher, godot::VariantComparator> RowIndexType;
 public:
    typedef godot::HashSet<godot::Variant, godot::VariantHasher, godot::VariantComparator> ValueSetType;
 
@@ -119,6 +125,30 @@ public:
       EL_Master = 1 << 16,
    };
 
+   // Secondary indexes that can be declared on columns, speeding up lookups by value
+   enum IndexType
+   {
+      IT_None,
+
+      // Equality lookups through a hash map from value into rows
+      IT_Hash,
+
+      // Equality and range lookups through a list of rows sorted by value
+      IT_Sorted,
+   };
+
+   // How weighted random picks locate the rolled row
+   enum RandomPickMode
+   {
+      // Vose's alias method. Picks take constant time, but the alias table must be rebuilt (linear time) by the first
+      // pick after the weights change
+      RPM_Alias,
+
+      // Search the weight tree. Picks take logarithmic time and nothing extra has to be built, which is better suited
+      // for tables that change often
+      RPM_BinarySearch,
+   };
+
    // When the owning Database needs to deal with column (adding or querying info), this struct will be used.
    // The exposed interface will deal with Dictionary, but the database should "translate" into/from an instance
    // of this struct.
@@ -134,34 +164,31 @@ public:
    };
 
 private:
-   // When sorting rows an instance of this will be created
-   // One thing to note here is that godot::Callable requires the object to have the get_instance_id() function, which should
-   // return an unsigned integer of 64 bits. When an instance of this struct is created the ID value will be assigned from
-   // this resource itself, like 'sorter.id = get_instance_id()'.
-   // An alternative here is to use CallableCustom, however it requires several other functions to be implemented.
-   struct Sorter
+   // When sorting rows, a list of row indices is sorted through this, comparing integer keys previously extracted from
+   // each sort column (DBColumn::get_sort_keys()). The result is then applied into all columns at once. Ties are broken by
+   // the row index, so the result is the same of a stable sort
+   struct RowSorter
    {
-      godot::String column;
-      uint64_t inst_id;
-
-      bool ascending(const godot::Dictionary& a, const godot::Dictionary& b) const
-      {
-         return a[column] < b[column];
-      }
+      const int64_t* const* key;
+      const bool* ascending;
+      int64_t count;
 
-      bool descending(const godot::Dictionary& a, const godot::Dictionary& b) const
+      bool operator()(int64_t a, int64_t b) const
       {
-         return b[column] < a[column];
+         for (int64_t i = 0; i < count; i++)
+         {
+            const int64_t ka = key[i][a];
+            const int64_t kb = key[i][b];
+            if (ka != kb)
+            {
+               return (ka < kb) == ascending[i];
+            }
+         }
+
+         return a < b;
       }
 
-      bool ascending_color(const godot::Dictionary& a, const godot::Dictionary& b) const;
-      bool descending_color(const godot::Dictionary& a, const godot::Dictionary& b) const;
-
-
-      uint64_t get_instance_id() const { return inst_id; }
-
-
-      Sorter(const godot::String& col = "id", uint64_t iid = 0) : column(col), inst_id(iid) {}
+      RowSorter() : key(nullptr), ascending(nullptr), count(0) {}
    };
 
    /// Internal variables
@@ -197,22 +224,55 @@ private:
    // not be changed after table creation
    bool m_locked_id;
 
-   // Each entry is a Dictionary containing:
+   // Row data is stored per column (struct of arrays) rather than one Dictionary per row. Each column holds its values
+   // in a contiguous array typed based on the column value type. Strings are interned in the table's string pool. When
+   // saved, the data is still converted into an Array of Dictionaries (the "row_list" property), which contain:
    // - id: The ID of the row, which is either a String or an Integer
    // - [column_name]: Corresponding value. There will be one for each column
-   godot::Array m_row_list;
+   DBStringPool m_string_pool;
+
+   // Holds the ID of each row
+   DBColumn m_id_column;
+
+   // Values of each column, following the same order of m_column_array
+   godot::Vector<DBColumn> m_column_data;
+
+   // Dynamically built, maps from column title into its index within m_column_data
+   godot::HashMap<godot::String, int64_t> m_column_slot;
 
-   // This will be dynamically generated. The key is the row id and will directly point to the same corresponding row
-   // entry Dictionary that is held within the m_row_list
-   //godot::HashMap<godot::Variant, godot::Dictionary> m_row_index;
+   // This will be dynamically generated. The key is the row id and the value is the index of the row. Not used in dense
+   // ID mode
    RowIndexType m_row_index;
 
+   // Dense ID mode, only available to tables using integer IDs. New rows get sequential IDs and the row indexing is done
+   // through a plain array, directly indexed by the row ID, holding the row index (-1 for IDs that are not used)
+   bool m_dense_id;
+   godot::Vector<int64_t> m_dense_row;
+
+   // Next ID given to a new row in dense ID mode. Always bigger than any ID in the table
+   int64_t m_next_id;
+
+   // IDs released by removed rows in dense ID mode. Those are given to new rows before m_next_id is advanced, so repeatedly
+   // adding and removing rows doesn't make the indexing array grow beyond the row count
+   godot::Vector<int64_t> m_free_id;
+
+   // Incremented whenever existing rows get their indices changed. Row views use this to detect they became invalid
+   int64_t m_row_layout_version;
+
+   // Incremented whenever the column storage mapping is rebuilt. Column handles carry this in their upper bits so stale
+   // handles are detected rather than reading from another column
+   int64_t m_column_layout_version;
+
    // Another data meant to be dynamically generated. Columns that are meant to hold unique values will generate sets
    // within this container. The idea is to make things easier to ensure the values are indeed unique within those
    // columns. This will result if faster verifications at the expense of using more memory.
    // That said, the Map points from column name into Set. The Set holds the values of the column.
    godot::HashMap<godot::StringName, ValueSetType> m_unique_indexing;
 
+   // Dynamically built from the "index" entry of the column Dictionaries. Maps from column title into its secondary
+   // index. Those are maintained whenever rows are added, removed or changed
+   godot::HashMap<godot::String, DBColumnIndex> m_secondary_index;
+
 
    // Each time a column meant to reference another table is created, an entry in this Dictionary will be created. The
    // key is the name of the referenced table. The value is the name of the column referencing the table. This container
@@ -231,9 +291,17 @@ private:
       // The total weight -sum
       double total_weight;
 
-      // Each row needs its accumulation, which is based on the sum of the previous rows. Randomly picking something
-      // from the table means iterating through this specific array
-      godot::Vector<double> acc_weight;
+      // Each row needs its accumulation, which is based on the sum of the previous rows. Those are kept in a Fenwick
+      // tree so changing a single weight does not require recalculating everything
+      DBWeightTree tree;
+
+      // Alias table, one entry per row. When a row is rolled, 'alias_prob' is the probability of keeping it, otherwise
+      // the row at 'alias_index' is taken. Built on demand, which is why those are mutable
+      mutable godot::Vector<double> alias_prob;
+      mutable godot::Vector<int64_t> alias_index;
+      mutable bool alias_dirty;
+
+      RandomPickMode pick_mode;
    } m_rand_weight;
 
    /// NOTE: Perhaps find a way to share a single instance between tables of the same Database?
@@ -252,6 +320,12 @@ private:
    ValueType column_get_type(const godot::Dictionary& column) const { return ((ValueType)(int)column.get("value_type", VT_Invalid)); }
    void column_set_external(const godot::String& other, godot::Dictionary& out_column);
    godot::String column_get_external(const godot::Dictionary& column) const { return column.get("extid", ""); }
+   void column_set_index_type(IndexType type, godot::Dictionary& out_column);
+   IndexType column_get_index_type(const godot::Dictionary& column) const { return ((IndexType)(int)column.get("index", IT_None)); }
+
+   // Index that is actually built for the column. Columns referencing other tables always get at least a hash index, which
+   // serves as the reverse reference index (referenced ID -> referencing rows) used when the other table changes
+   IndexType column_get_built_index_type(const godot::Dictionary& column) const;
 
    // This function is meant to serve as a "shortcut" to verify if a given column requires unique values or not.
    bool require_unique_values(const godot::Dictionary& column) const;
@@ -274,15 +348,85 @@ private:
    // Whenever rows are reordered, new rows are added and so on, this function must be used to update
    void calculate_weights();
 
+   // Update the weight tree after the weight of a single row changed
+   void update_row_weight(int64_t row_index, double old_weight, double new_weight);
+
+   // (Re)build the alias table from the weights column
+   void build_alias_table() const;
+
+   // Roll a row index taking the random weights into account. Returns -1 if the table is empty or the total weight
+   // is not positive. If there is no random weight column every row has the same chance
+   int64_t roll_row_index(const godot::Ref<godot::RandomNumberGenerator>& rng) const;
+
    // (Re)build the column indexing
    void build_column_index();
 
    // (Re)build the unique values indexing
    void build_unique_index();
 
-   // (Re)build the row indexing. That is, from row ID into row data
+   // (Re)build the row indexing. That is, from row ID into row index
    void build_row_index();
 
+   // Row indexing access, dealing with either the hash map or the dense array. find_row() returns -1 if the ID is not used
+   int64_t find_row(const godot::Variant& id) const;
+   bool has_row_id(const godot::Variant& id) const { return find_row(id) >= 0; }
+   void set_row_entry(const godot::Variant& id, int64_t index);
+   void erase_row_entry(const godot::Variant& id);
+
+   // In dense ID mode IDs must be non negative and smaller than this. The row indexing array takes one entry per ID up
+   // to the biggest one, so this bounds its memory regardless of where the IDs come from (including corrupted files).
+   // The limit doesn't depend on the row count, so IDs created by the table remain valid after rows are removed
+   static constexpr int64_t MAX_DENSE_ID = int64_t(1) << 24;
+   static bool is_dense_id_valid(int64_t id) { return id >= 0 && id < MAX_DENSE_ID; }
+
+   // Index of the first row holding an ID that can't be used in dense ID mode, -1 if all of them are fine
+   int64_t find_invalid_dense_id() const;
+
+   // Loaded data only carries the dense ID flag, so verify the stored IDs before building the row indexing. If those are
+   // not valid then the table falls back to the hash row indexing
+   void validate_loaded_dense_id();
+
+   // (Re)build all secondary indexes declared in the columns
+   void build_secondary_index();
+
+   // (Re)build the secondary index of a single column, if it has one
+   void rebuild_secondary_index(const godot::String& column_title);
+
+   // Update secondary indexes after a row is inserted or before it is removed
+   void secondary_index_row_inserted(int64_t row_index);
+   void secondary_index_row_removed(int64_t row_index);
+
+   // Update the row indexing of all rows starting at 'first'. Used after rows are inserted, removed or moved
+   void reindex_rows(int64_t first);
+
+   // (Re)build the column title -> column storage mapping
+   void build_column_slots();
+
+   // Given a column handle, obtain the index of the column storage. Returns -1 (with an error) if the handle is invalid or
+   // was obtained before the columns changed
+   int64_t get_column_slot(int64_t column_handle) const;
+
+   // Which storage is used by columns of the given value type
+   static DBColumn::StorageType get_storage_type(ValueType type);
+
+   // Retrieve the storage of a column given its title. nullptr if not found
+   DBColumn* get_column_data(const godot::String& title);
+   const DBColumn* get_column_data(const godot::String& title) const;
+
+   // Build a Dictionary containing the values of the row at the given index. The index must be valid
+   godot::Dictionary make_row(int64_t index) const;
+
+   // Reorder all rows based on the values of the given columns (which can include the ID column). Subsequent columns are
+   // only used to order rows that are equal in all previous ones. Rows that are equal in all columns keep their order
+   void sort_rows(const godot::Vector<const DBColumn*>& key_column, const godot::Vector<bool>& ascending);
+
+   // Reorder all rows so the new row 'i' is the one that was previously at 'permutation[i]'
+   void apply_row_permutation(const int64_t* permutation);
+
+   // Convert the column storage into/from the Array of Dictionaries used when saving the table
+   godot::Array get_row_list() const;
+   void set_row_list(const godot::Array& list);
+
    // Generate a random string. Remember this does *not* have cryptography strength.
    godot::String make_random_string(int32_t length);
 
@@ -372,6 +516,12 @@ public:
    // entries are added
    bool is_row_id_locked() const { return m_locked_id; }
 
+   // Enable or disable the dense ID mode, which is only available to tables using integer IDs. In this mode new rows get
+   // sequential IDs and retrieving rows (or cells) by ID is a direct array access instead of a hash lookup. Enabling fails
+   // if existing IDs are negative or not smaller than MAX_DENSE_ID
+   bool set_dense_id(bool enabled);
+   bool is_dense_id() const { return m_dense_id; }
+
    // Retrieves how many columns are stored within this table
    int64_t get_column_count() const { return m_column_array.size(); }
 
@@ -393,7 +543,7 @@ public:
    ValueType get_column_value_type(const godot::String& column_title) const;
 
    //
-   int64_t get_row_count() const { return m_row_list.size(); }
+   int64_t get_row_count() const { return m_id_column.size(); }
 
    // Returns true if there is a column with the given title
    bool has_column(const godot::String& title) const { return m_column_index.has(title); }
@@ -410,9 +560,50 @@ public:
    // Given a row Id an da column title, retrieve the value of a single cell
    godot::Variant get_cell_value(const godot::Variant& id, const godot::String& column_title) const;
 
+   // Retrieve the index of the row with the given ID, -1 if there is no such row
+   int64_t get_row_index(const godot::Variant& id) const;
+
+   // Obtain a handle to be used with the typed cell accessors below. The handle remains valid until columns are added,
+   // removed, renamed or moved, after which the accessors fail with an error. Returns -1 if there is no column with the
+   // given title
+   int64_t get_column_handle(const godot::String& title) const;
+
+   // Cell access given a row index and a column handle. Those don't build any Dictionary and the typed ones don't go
+   // through Variant when the column storage matches the requested type
+   godot::Variant get_value(int64_t row_index, int64_t column_handle) const;
+   int64_t get_int(int64_t row_index, int64_t column_handle) const;
+   double get_float(int64_t row_index, int64_t column_handle) const;
+   bool get_bool(int64_t row_index, int64_t column_handle) const;
+   godot::String get_string(int64_t row_index, int64_t column_handle) const;
+
+   // Declare (or remove, with IT_None) a secondary index on the given column. This is stored with the table
+   bool set_column_index(const godot::String& column_title, IndexType type);
+   IndexType get_column_index_type(const godot::String& column_title) const;
+
+   // Indices of the rows where the given column holds 'value'. Uses the secondary index of the column if there is one,
+   // otherwise all rows are scanned
+   godot::PackedInt64Array find_rows(const godot::String& column_title, const godot::Variant& value) const;
+
+   // Indices of the rows where the given column holds a value in the [low..high] range, sorted by value if the column
+   // has an IT_Sorted index. Without that index all rows are scanned
+   godot::PackedInt64Array find_rows_in_range(const godot::String& column_title, const godot::Variant& low, const godot::Variant& high) const;
+
+   // Obtain a read only view of a row, which does not copy the row data. Returns an invalid reference if the row does
+   // not exist
+   godot::Ref<DBRowView> get_row_view(const godot::Variant& id);
+   godot::Ref<DBRowView> get_row_view_by_index(int64_t index);
+
+   // Not exposed. Used by the row views
+   int64_t get_row_layout_version() const { return m_row_layout_version; }
+
    // Pick a random row. If the random weight system is setup it will be used, otherwise a random index will be chosen
    godot::Dictionary pick_random_row(const godot::Ref<godot::RandomNumberGenerator>& rng = godot::Ref<godot::RandomNumberGenerator>()) const;
 
+   // Pick 'count' random rows in a single call, returning their indices. With replacement every roll is independent, so
+   // rows may repeat. Without replacement each row appears at most once, meaning that fewer than 'count' indices are
+   // returned if there aren't enough rows (with positive weight). Weights are taken into account in both cases
+   godot::PackedInt64Array pick_random_rows(int64_t count, bool with_replacement, const godot::Ref<godot::RandomNumberGenerator>& rng = godot::Ref<godot::RandomNumberGenerator>()) const;
+
    // Retrieve the title of the column holding automatic random weight calculation, if any. Empty if it's not set
    godot::String get_random_weight_column_title() const { return m_rand_weight.column; }
 
@@ -425,6 +616,13 @@ public:
    // Obtain the total accumulated weight sum for this table (-1.0 if the system is not set)
    double get_total_weight_sum() const { return m_rand_weight.total_weight; }
 
+   // Change the random weight of a single row. Only that row is affected, so this takes O(log n)
+   bool set_row_weight(int64_t row_index, double weight);
+
+   // How weighted random picks are performed. This is a runtime setting, it is not saved with the table
+   void set_random_pick_mode(RandomPickMode mode);
+   RandomPickMode get_random_pick_mode() const { return m_rand_weight.pick_mode; }
+
    // Get the list of tables referenced by this one
    godot::PackedStringArray get_reference_list() const { return m_ref_table.keys(); }
 
@@ -452,6 +650,9 @@ public:
 
    // "Converts" the stored data into a String in JSON format
    godot::String get_data_as_json(const godot::String& indent = "") const;
+
+   // Approximate number of bytes used by the row values. Interned strings are counted only once
+   int64_t get_data_memory_usage() const;
    
    /// Setters/Getters
 
@@ -460,6 +661,12 @@ public:
    // this function whenever the user requests to rename a table
    void change_name(const godot::StringName& name) { m_table_name = name; }
 
+   // Used by the binary database format (.gddb). Besides the column values, the weight tree and the secondary indexes
+   // are written as they are, so reading doesn't have to rebuild those. Reading is meant to be done on a new table.
+   // Returns false if the data is not valid
+   void write_binary(DBBinaryWriter& writer) const;
+   bool read_binary(DBBinaryReader& reader);
+
    // Given a column index, fill the incoming ColumnInfo struct with the corresponding data. Returns false if
    // no valid data was actually added into the output
    bool fill_column_info(int64_t column_index, ColumnInfo& out_info) const;
@@ -491,12 +698,23 @@ public:
    // Insert a row at the given index. ID will be automatically generated
    int64_t add_row(const godot::Dictionary& values, int64_t index);
 
+   // Insert multiple rows, each one given by a Dictionary in the same format used by add_row(), starting at the given
+   // index. Row indexing, unique values, secondary indexes and random weights are updated once for the entire batch
+   // rather than once per row. Unique values that are already used, either by existing rows or by earlier entries of
+   // the batch, are replaced by generated ones. Returns the index of the first inserted row, -1 if error
+   int64_t add_rows(const godot::Array& rows, int64_t index);
+
    // Given a row ID, remove it from the table
    void remove_row(const godot::Variant row_id);
 
    // Remove a row given its index
    void remove_row_by_index(int64_t index);
 
+   // Remove all rows given by their indices. Invalid and repeated indices are ignored. Rows are compacted in a single
+   // pass and row indexing, unique values, secondary indexes and random weights are updated once. If 'out_id_set' is
+   // given then it receives the IDs of the removed rows. Returns how many rows have been removed
+   int64_t remove_rows_by_index(const godot::PackedInt64Array& index_list, ValueSetType* out_id_set = nullptr);
+
    // Move a row from 'from' into 'to' index
    bool move_row(int64_t from, int64_t to);
 
@@ -518,6 +736,10 @@ public:
    // Sort rows by the specified column index
    bool sort_by_column(int64_t index, bool ascending);
 
+   // Sort rows by multiple columns, given by their titles ("id" meaning the row IDs). Each entry in 'ascending' tells the
+   // direction of the corresponding column, missing entries meaning ascending order. Returns false if any column is invalid
+   bool sort_by_columns(const godot::PackedStringArray& column_titles, const godot::Array& ascending);
+
 
    // Returns the name of the table referenced by the given column name
    godot::StringName get_referenced_by_column(const godot::String& column_title) const;
@@ -534,6 +756,8 @@ public:
 
 
 VARIANT_ENUM_CAST(DBTable::ValueType);
+VARIANT_ENUM_CAST(DBTable::IndexType);
+VARIANT_ENUM_CAST(DBTable::RandomPickMode);
 
 
 /*class ResourceFormatLoaderDBTable : public godot::ResourceFormatLoader
@@ -480,6 +480,7 @@ void GDDatabaseEditor::create_openclose_dialog()
    godot::PackedStringArray filters;
    filters.append("*.tres; TRES");
    filters.append("*.res; RES");
+   filters.append("*.gddb; GDDB");
 
    m_dlg_openclose = memnew(godot::FileDialog);
    m_dlg_openclose->set_filters(filters);
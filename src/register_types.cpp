@@ -42,6 +42,8 @@
 
 /// Includes from "general"
 #include "general/quantize.h"
+#include "general/bitstream.h"
+#include "general/quantized_animation.h"
 
 /// Includes from "nodes"
 #include "nodes/audiomaster.h"
@@ -50,6 +52,8 @@
 
 /// Includes from 'other"
 #include "other/database/database.h"
+#include "other/database/dbquery.h"
+#include "other/database/dbrowview.h"
 #include "other/database/editor/dbeplugin.h"      // The contents will not be included if Editor is disabled
 #include "other/database/editor/tabular_cells.h"
 
@@ -83,8 +87,8 @@
 
 
 #ifndef DATABASE_DISABLED
-   ///static godot::Ref<ResourceFormatLoaderGDDatabase> res_loader_database;
-   ///static godot::Ref<ResourceFormatSaverGDDatabase> res_saver_database;
+   static godot::Ref<ResourceFormatLoaderGDDatabase> res_loader_database;
+   static godot::Ref<ResourceFormatSaverGDDatabase> res_saver_database;
 #endif
 
 
@@ -136,6 +140,15 @@ void register_pack_types(godot::ModuleInitializationLevel p_level)
             GDREGISTER_CLASS(Quantize);
          #endif
 
+         #ifndef BITSTREAM_DISABLED
+            GDREGISTER_CLASS(BitStreamWriter);
+            GDREGISTER_CLASS(BitStreamReader);
+         #endif
+
+         #ifndef QUANTIZED_ANIMATION_DISABLED
+            GDREGISTER_CLASS(QuantizedAnimation);
+         #endif
+
 
          /// Register classes in the "nodes" category
          #ifndef AUDIO_MASTER_DISABLED
@@ -240,16 +253,18 @@ void register_pack_types(godot::ModuleInitializationLevel p_level)
          #endif
             // If the format loader and format saver are not registered they simply don't work! That is, ResourceLoader and
             // ResourceSaver completely ignore that those classes exist!
-            ///godot::ClassDB::register_internal_class<ResourceFormatLoaderGDDatabase>();
-            ///godot::ClassDB::register_internal_class<ResourceFormatSaverGDDatabase>();
+            godot::ClassDB::register_internal_class<ResourceFormatLoaderGDDatabase>();
+            godot::ClassDB::register_internal_class<ResourceFormatSaverGDDatabase>();
 
-            ///res_saver_database.instantiate();
-            ///res_loader_database.instantiate();
+            res_saver_database.instantiate();
+            res_loader_database.instantiate();
 
-            ///godot::ResourceLoader::get_singleton()->add_resource_format_loader(res_loader_database);
-            ///godot::ResourceSaver::get_singleton()->add_resource_format_saver(res_saver_database);
+            godot::ResourceLoader::get_singleton()->add_resource_format_loader(res_loader_database);
+            godot::ResourceSaver::get_singleton()->add_resource_format_saver(res_saver_database);
             
+            GDREGISTER_CLASS(DBRowView);
             GDREGISTER_CLASS(DBTable);
+            GDREGISTER_CLASS(DBQuery);
             //GDREGISTER_CLASS(DBTablePatch);
             GDREGISTER_CLASS(GDDatabase);
 
@@ -307,11 +322,11 @@ void unregister_pack_types(godot::ModuleInitializationLevel p_level)
 
       /// Cleanup "Other" related stuff
       #ifndef DATABASE_DISABLED
-         ///godot::ResourceLoader::get_singleton()->remove_resource_format_loader(res_loader_database);
-         ///godot::ResourceSaver::get_singleton()->remove_resource_format_saver(res_saver_database);
+         godot::ResourceLoader::get_singleton()->remove_resource_format_loader(res_loader_database);
+         godot::ResourceSaver::get_singleton()->remove_resource_format_saver(res_saver_database);
 
-         ///res_loader_database.unref();
-         ///res_saver_database.unref();
+         res_loader_database.unref();
+         res_saver_database.unref();
       #endif
    }
 